@@ -0,0 +1,10 @@
+#version 330 core
+in vec2 TexCoord;
+flat in uint TexLayer;
+out vec4 FragColor;
+
+uniform sampler2DArray texture_array;
+
+void main() {
+    FragColor = texture(texture_array, vec3(TexCoord, float(TexLayer)));
+}
\ No newline at end of file
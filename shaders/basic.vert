@@ -4,12 +4,25 @@ layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec2 aTexCoord;
 
 out vec2 TexCoord;
+flat out uint TexLayer;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform uint texture_layer;
+
+layout(std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    mat4 view_projection;
+    vec4 camera_pos;
+    vec4 time;
+    vec4 viewport;
+};
+
+// Matches the depth prepass exactly, so its depth can be tested with GL_EQUAL
+invariant gl_Position;
 
 void main() {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_Position = view_projection * model * vec4(aPos, 1.0);
     TexCoord = aTexCoord.xy;
+    TexLayer = texture_layer;
 }
@@ -0,0 +1,5 @@
+#version 330
+
+// Depth only: color writes are masked off during the prepass
+void main() {
+}
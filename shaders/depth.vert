@@ -0,0 +1,21 @@
+#version 330
+
+layout(location = 0) in vec3 aPos;
+
+uniform mat4 model;
+
+layout(std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    mat4 view_projection;
+    vec4 camera_pos;
+    vec4 time;
+    vec4 viewport;
+};
+
+// The shading pass tests its depth for equality against this one
+invariant gl_Position;
+
+void main() {
+    gl_Position = view_projection * model * vec4(aPos, 1.0);
+}
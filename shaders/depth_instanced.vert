@@ -0,0 +1,20 @@
+#version 330
+
+layout(location = 0) in vec3 aPos;
+layout(location = 2) in mat4 aModel;
+
+layout(std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    mat4 view_projection;
+    vec4 camera_pos;
+    vec4 time;
+    vec4 viewport;
+};
+
+// The shading pass tests its depth for equality against this one
+invariant gl_Position;
+
+void main() {
+    gl_Position = view_projection * aModel * vec4(aPos, 1.0);
+}
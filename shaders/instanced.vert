@@ -0,0 +1,27 @@
+#version 330
+
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec2 aTexCoord;
+layout(location = 2) in mat4 aModel;
+layout(location = 6) in uint aLayer;
+
+out vec2 TexCoord;
+flat out uint TexLayer;
+
+layout(std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    mat4 view_projection;
+    vec4 camera_pos;
+    vec4 time;
+    vec4 viewport;
+};
+
+// Matches the depth prepass exactly, so its depth can be tested with GL_EQUAL
+invariant gl_Position;
+
+void main() {
+    gl_Position = view_projection * aModel * vec4(aPos, 1.0);
+    TexCoord = aTexCoord.xy;
+    TexLayer = aLayer;
+}
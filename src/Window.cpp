@@ -3,7 +3,10 @@
 #include <assert.h>
 
 #include <chrono>
+#include <exception>
+#include <thread>
 
+#include "gfx/GLState.hpp"
 #include "menu/menu.hpp"
 
 using namespace std::chrono;
@@ -14,9 +17,17 @@ std::vector<int> _gl_target_to_version(gfx::gl::glAPI target);
 
 // I'm sorry, the memory boundaries made me do it...
 static GameWindow *CURRENT_GAME_WINDOW = nullptr;
+// Seconds between two reports of the stream buffer and render thread statistics
+static constexpr float STATS_REPORT_INTERVAL = 5.0f;
 
 GameWindow::GameWindow(std::string window_title, gfx::EngineConfig config, uint width, uint height)
-    : window(0U), width(0U), height(0U), deltaTime(0.0f), lastFrame(0.0f) {
+    : window(0U),
+      width(width),
+      height(height),
+      deltaTime(0.0f),
+      lastFrame(0.0f),
+      viewport_width(width),
+      viewport_height(height) {
     assert(CURRENT_GAME_WINDOW == nullptr);
     CURRENT_GAME_WINDOW = this;
 
@@ -49,8 +60,11 @@ GameWindow::GameWindow(std::string window_title, gfx::EngineConfig config, uint
     if (this->window) {
         glfwMakeContextCurrent(this->window);
         glfwSetKeyCallback(this->window, handleKeypress);
-        glfwSetFramebufferSizeCallback(
-            this->window, [](GLFWwindow *window, int width, int height) { glViewport(0, 0, width, height); });
+        // The render thread may own the context, so the new size is applied by the loop rather than here
+        glfwSetFramebufferSizeCallback(this->window, [](GLFWwindow *window, int width, int height) {
+            CURRENT_GAME_WINDOW->width = width;
+            CURRENT_GAME_WINDOW->height = height;
+        });
 
         // Initialize ImGUI
         goat::menu::init_menu(this->window);
@@ -60,12 +74,32 @@ GameWindow::GameWindow(std::string window_title, gfx::EngineConfig config, uint
     }
 }
 
+/**
+ * @brief Stream per-frame data through a fenced ring buffer: the loop starts and fences the buffer's frames, and
+ *        writes the frame uniforms to it. The buffer is returned so renderers can stream their own data too.
+ * @param mode The preferred mode (persistent mapping falls back to unsynchronized mapping below OpenGL 4.4)
+ * @param frame_size The bytes each frame can stream
+ */
+gfx::StreamBuffer *GameWindow::enableStreaming(gfx::StreamMode mode, size_t frame_size) {
+    this->stream = std::make_unique<gfx::StreamBuffer>(frame_size, mode);
+    return this->stream.get();
+}
+
+gfx::StreamBuffer *GameWindow::getStream() const {
+    return this->stream.get();
+}
+
 void GameWindow::loop(std::function<void()> tick_fn) {
     assert(!!this->window);
     this->logDriverInfo();
 
+    if (!this->frame_uniforms)
+        this->frame_uniforms = std::make_unique<gfx::FrameUniformBuffer>();
+
     LOG(INFO) << "Starting game loop...";
+    float lastReport = glfwGetTime();
     while (!glfwWindowShouldClose(this->window)) {
+        this->applyViewport(this->width, this->height);
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -73,6 +107,15 @@ void GameWindow::loop(std::function<void()> tick_fn) {
         this->deltaTime = currentFrame - this->lastFrame;
         this->lastFrame = currentFrame;
 
+        if (this->stream)
+            this->stream->beginFrame();
+
+        // Upload the camera matrices once for every program rendered this frame
+        if (this->camera) {
+            auto viewport = vec4(0.0f, 0.0f, static_cast<float>(this->width), static_cast<float>(this->height));
+            this->frame_uniforms->update(*this->camera, currentFrame, this->deltaTime, viewport, this->stream.get());
+        }
+
 #ifdef __DEBUG__
         auto startTime = high_resolution_clock::now();
 #endif
@@ -82,6 +125,9 @@ void GameWindow::loop(std::function<void()> tick_fn) {
         auto duration = duration_cast<milliseconds>(endTime - startTime);
         LOG(DEBUG) << "Game loop took " << duration.count() << " ms";
 #endif
+        if (this->stream)
+            this->stream->endFrame();
+        this->reportStats(currentFrame, lastReport);
 
         glfwSwapBuffers(this->window);
         glfwPollEvents();
@@ -90,6 +136,142 @@ void GameWindow::loop(std::function<void()> tick_fn) {
     glfwPollEvents();
 }
 
+void GameWindow::loop(std::function<void(world::SceneSnapshot &)> simulate_fn,
+                      std::function<void(const world::SceneSnapshot &)> render_fn) {
+    assert(!!this->window);
+    this->logDriverInfo();
+
+    if (!this->frame_uniforms)
+        this->frame_uniforms = std::make_unique<gfx::FrameUniformBuffer>();
+    if (!this->snapshots)
+        this->snapshots = std::make_unique<world::SnapshotBuffer>();
+
+    // Hand the context over to the render thread, and take it back once it has drawn its last snapshot
+    std::exception_ptr render_error{};
+    glfwMakeContextCurrent(nullptr);
+    std::thread render_thread([this, &render_fn, &render_error]() {
+        glfwMakeContextCurrent(this->window);
+        try {
+            this->renderSnapshots(render_fn);
+        } catch (...) {
+            render_error = std::current_exception();
+            glfwSetWindowShouldClose(this->window, true);
+            // The simulation may be waiting for the snapshot that was being drawn
+            this->snapshots->stop();
+        }
+        glfwMakeContextCurrent(nullptr);
+    });
+    auto join = [this, &render_thread]() {
+        this->snapshots->stop();
+        render_thread.join();
+        glfwMakeContextCurrent(this->window);
+    };
+
+    LOG(INFO) << "Starting game loop with a render thread...";
+    uint64_t frame = 0UL;
+    try {
+        while (!glfwWindowShouldClose(this->window)) {
+            glfwPollEvents();
+
+            float currentFrame = glfwGetTime();
+            this->deltaTime = currentFrame - this->lastFrame;
+            this->lastFrame = currentFrame;
+
+            // Waits only when the render thread is still drawing the snapshot before the last one
+            auto &snapshot = this->snapshots->write();
+            snapshot.frame = ++frame;
+            snapshot.time = currentFrame;
+            snapshot.delta_time = this->deltaTime;
+            snapshot.width = this->width;
+            snapshot.height = this->height;
+            if (this->camera)
+                snapshot.camera = *this->camera;
+
+#ifdef __DEBUG__
+            auto startTime = high_resolution_clock::now();
+#endif
+            simulate_fn(snapshot);
+#ifdef __DEBUG__
+            auto endTime = high_resolution_clock::now();
+            auto duration = duration_cast<milliseconds>(endTime - startTime);
+            LOG(DEBUG) << "Simulation took " << duration.count() << " ms";
+#endif
+            this->snapshots->publish();
+        }
+    } catch (...) {
+        join();
+        throw;
+    }
+    join();
+    glfwPollEvents();
+    if (render_error)
+        std::rethrow_exception(render_error);
+}
+
+void GameWindow::renderSnapshots(const std::function<void(const world::SceneSnapshot &)> &render_fn) {
+    float lastReport = glfwGetTime();
+    while (auto snapshot = this->snapshots->acquire()) {
+        this->applyViewport(snapshot->width, snapshot->height);
+        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        if (this->stream)
+            this->stream->beginFrame();
+        if (this->camera) {
+            auto viewport = vec4(0.0f, 0.0f, static_cast<float>(snapshot->width), static_cast<float>(snapshot->height));
+            this->frame_uniforms->update(snapshot->camera, snapshot->time, snapshot->delta_time, viewport,
+                                         this->stream.get());
+        }
+
+#ifdef __DEBUG__
+        auto startTime = high_resolution_clock::now();
+#endif
+        render_fn(*snapshot);
+#ifdef __DEBUG__
+        auto endTime = high_resolution_clock::now();
+        auto duration = duration_cast<milliseconds>(endTime - startTime);
+        LOG(DEBUG) << "Rendering frame " << snapshot->frame << " took " << duration.count() << " ms";
+#endif
+        if (this->stream)
+            this->stream->endFrame();
+        this->reportStats(snapshot->time, lastReport);
+
+        // Every GL command reading the snapshot is recorded, so the simulation can fill it again during the swap
+        this->snapshots->release();
+        glfwSwapBuffers(this->window);
+    }
+}
+
+void GameWindow::applyViewport(uint width, uint height) {
+    if (width == this->viewport_width && height == this->viewport_height)
+        return;
+    glViewport(0, 0, width, height);
+    this->viewport_width = width;
+    this->viewport_height = height;
+}
+
+void GameWindow::reportStats(float currentFrame, float &lastReport) {
+    if (currentFrame - lastReport < STATS_REPORT_INTERVAL)
+        return;
+    // Report what was streamed, with the frames that had to wait for the GPU
+    if (this->stream) {
+        const auto &stats = this->stream->getStats();
+        LOG(INFO) << "Streamed " << stats.bytes / 1024 << "KB in " << stats.writes << " writes over "
+                  << currentFrame - lastReport << "s (" << stats.stalls << " fence stalls, "
+                  << stats.stall_us / 1000.0 << " ms waited, " << stats.overflows << " overflows)";
+        this->stream->resetStats();
+    }
+    // And how long each side of the render thread waited for the other
+    if (this->snapshots) {
+        auto stats = this->snapshots->getStats();
+        LOG(INFO) << "Rendered " << stats.frames << " snapshots over " << currentFrame - lastReport
+                  << "s (simulation waited " << stats.simulation_wait_us / 1000.0 << " ms, rendering waited "
+                  << stats.render_wait_us / 1000.0 << " ms)";
+        this->snapshots->resetStats();
+    }
+    lastReport = currentFrame;
+}
+
 void GameWindow::handleKeypress(GLFWwindow *_glfwWindow, int key, int scancode, int action, int mods) {
     assert(CURRENT_GAME_WINDOW != nullptr);
     auto window = static_cast<GameWindow *>(CURRENT_GAME_WINDOW);
@@ -118,11 +300,7 @@ void GameWindow::createCamera(glm::vec3 start_pos) {
 }
 
 void GameWindow::setFeature(gfx::gl::glFeature feature, bool enable) {
-    if (enable) {
-        glEnable(static_cast<GLenum>(feature));
-    } else {
-        glDisable(static_cast<GLenum>(feature));
-    }
+    gfx::GLState::get().setEnabled(static_cast<GLenum>(feature), enable);
 }
 
 world::Camera *GameWindow::getCamera() const {
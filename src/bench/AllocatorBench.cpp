@@ -0,0 +1,186 @@
+#include <easylogging++.h>
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "bench/bench.hpp"
+#include "gfx/OffsetAllocator.hpp"
+
+namespace goat::bench {
+
+namespace {
+
+// A first-fit allocator over an ordered map of free regions, merging neighbours on free (the baseline)
+class FirstFitAllocator {
+   private:
+    std::map<uint32_t, uint32_t> free_regions;
+
+   public:
+    explicit FirstFitAllocator(uint32_t size) {
+        this->free_regions[0] = size;
+    }
+
+    uint32_t allocate(uint32_t size) {
+        for (auto it = this->free_regions.begin(); it != this->free_regions.end(); ++it) {
+            if (it->second < size)
+                continue;
+            auto offset = it->first, remainder = it->second - size;
+            this->free_regions.erase(it);
+            if (remainder > 0)
+                this->free_regions[offset + size] = remainder;
+            return offset;
+        }
+        return gfx::OffsetAllocation::NO_SPACE;
+    }
+
+    void free(uint32_t offset, uint32_t size) {
+        auto next = this->free_regions.lower_bound(offset);
+        if (next != this->free_regions.begin()) {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == offset) {
+                offset = prev->first;
+                size += prev->second;
+                this->free_regions.erase(prev);
+            }
+        }
+        if (next != this->free_regions.end() && offset + size == next->first) {
+            size += next->second;
+            this->free_regions.erase(next);
+        }
+        this->free_regions[offset] = size;
+    }
+};
+
+struct Live {
+    gfx::OffsetAllocation allocation;
+    uint32_t size;
+};
+
+}  // namespace
+
+/**
+ * @brief Churn random mesh-sized allocations (1 to 16k vertices) through the TLSF offset allocator used by the
+ *        geometry arena and a first-fit baseline, checking every live range against the others for overlaps and
+ *        the free space accounting. Then compacts the fragmented allocator the way `GeometryArena::defragment`
+ *        does and compares the largest free range before and after.
+ */
+void offset_allocator() {
+    constexpr uint32_t capacity = 64U * 1024U * 1024U;
+    constexpr size_t operations = 1'005'000;
+
+    std::mt19937 rng(1337);
+    std::uniform_int_distribution<uint32_t> sizes(1U, 16384U);
+    std::uniform_int_distribution<int> coin(0, 99);
+    // Alternating grow and shrink phases, so the live set keeps changing size
+    std::vector<std::pair<bool, uint32_t>> script;
+    script.reserve(operations);
+    size_t live_count = 0;
+    for (size_t i = 0; i < operations; i++) {
+        bool growing = (i / 10'000) % 2 == 0;
+        bool allocate = live_count == 0 || coin(rng) < (growing ? 70 : 30);
+        script.emplace_back(allocate, allocate ? sizes(rng) : static_cast<uint32_t>(rng()));
+        live_count += allocate ? 1 : -1;
+    }
+
+    gfx::OffsetAllocator allocator(capacity);
+    std::vector<Live> live;
+    size_t failed = 0;
+    auto tlsf_us = measure([&]() {
+        for (const auto &[allocate, value] : script) {
+            if (allocate) {
+                auto allocation = allocator.allocate(value);
+                if (allocation.valid())
+                    live.push_back(Live{allocation, value});
+                else
+                    failed++;
+            } else if (!live.empty()) {
+                auto index = value % live.size();
+                allocator.free(live[index].allocation);
+                live[index] = live.back();
+                live.pop_back();
+            }
+        }
+    });
+
+    FirstFitAllocator first_fit(capacity);
+    std::vector<std::pair<uint32_t, uint32_t>> first_fit_live;
+    size_t first_fit_failed = 0;
+    auto first_fit_us = measure([&]() {
+        for (const auto &[allocate, value] : script) {
+            if (allocate) {
+                auto offset = first_fit.allocate(value);
+                if (offset != gfx::OffsetAllocation::NO_SPACE)
+                    first_fit_live.emplace_back(offset, value);
+                else
+                    first_fit_failed++;
+            } else if (!first_fit_live.empty()) {
+                auto index = value % first_fit_live.size();
+                first_fit.free(first_fit_live[index].first, first_fit_live[index].second);
+                first_fit_live[index] = first_fit_live.back();
+                first_fit_live.pop_back();
+            }
+        }
+    });
+
+    // Every live range must be inside the space, disjoint from the others, and accounted for
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    size_t used = 0;
+    for (const auto &allocation : live) {
+        ranges.emplace_back(allocation.allocation.offset, allocation.size);
+        used += allocation.size;
+        if (allocator.allocationSize(allocation.allocation) != allocation.size)
+            LOG(ERROR) << "[bench] allocation at " << allocation.allocation.offset << " reports the wrong size";
+    }
+    std::sort(ranges.begin(), ranges.end());
+    size_t overlaps = 0;
+    for (size_t i = 0; i < ranges.size(); i++) {
+        if (ranges[i].first + ranges[i].second > capacity)
+            overlaps++;
+        if (i > 0 && ranges[i - 1].first + ranges[i - 1].second > ranges[i].first)
+            overlaps++;
+    }
+    auto before = allocator.report();
+    if (overlaps > 0)
+        LOG(ERROR) << "[bench] " << overlaps << " live ranges overlap or overflow";
+    if (before.total_free != capacity - used || before.allocations != live.size())
+        LOG(ERROR) << "[bench] free space accounting is off: " << before.total_free << " free, expected "
+                   << capacity - used;
+
+    LOG(INFO) << "[bench] " << operations << " operations on " << capacity / (1024 * 1024) << "M units";
+    LOG(INFO) << "[bench]   tlsf       " << tlsf_us / 1000.0 << "ms (" << tlsf_us * 1000.0 / operations
+              << "ns per operation), " << failed << " failed allocations";
+    LOG(INFO) << "[bench]   first fit  " << first_fit_us / 1000.0 << "ms (" << first_fit_us * 1000.0 / operations
+              << "ns per operation), " << first_fit_failed << " failed allocations";
+
+    // Compact: reallocate the live ranges in offset order into a reset allocator
+    std::sort(live.begin(), live.end(),
+              [](const Live &a, const Live &b) { return a.allocation.offset < b.allocation.offset; });
+    size_t unplaced = 0;
+    auto compact_us = measure([&]() {
+        allocator.reset();
+        for (auto &allocation : live) {
+            allocation.allocation = allocator.allocate(allocation.size);
+            unplaced += !allocation.allocation.valid();
+        }
+    });
+    auto after = allocator.report();
+    size_t misplaced = 0, expected = 0;
+    for (const auto &allocation : live) {
+        if (allocation.allocation.offset != expected)
+            misplaced++;
+        expected += allocation.size;
+    }
+    LOG(INFO) << "[bench]   " << live.size() << " live ranges (" << used * 100 / capacity << "% used): "
+              << before.free_regions << " free regions, largest " << before.largest_free << " of "
+              << before.total_free << " free";
+    LOG(INFO) << "[bench]   compacted in " << compact_us / 1000.0 << "ms: " << after.free_regions
+              << " free region, largest " << after.largest_free << " of " << after.total_free << " free";
+    if (unplaced > 0)
+        LOG(ERROR) << "[bench] " << unplaced << " ranges found no room when compacting (rounded up past the free tail)";
+    if (misplaced > 0)
+        LOG(ERROR) << "[bench] " << misplaced << " ranges were not packed back to back by the compaction";
+}
+
+}  // namespace goat::bench
@@ -0,0 +1,149 @@
+#include <easylogging++.h>
+
+#include <cmath>
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <random>
+#include <vector>
+
+#include "bench/bench.hpp"
+#include "world/BVH.hpp"
+#include "world/Culling.hpp"
+
+namespace goat::bench {
+
+namespace {
+
+// `count` random boxes at a constant density, so the number of boxes near any query stays about the same
+std::vector<world::AABB> random_boxes(size_t count, std::mt19937 &rng, float &half_size) {
+    half_size = 2.0f * std::cbrt(static_cast<float>(count));
+    std::uniform_real_distribution<float> position(-half_size, half_size);
+    std::uniform_real_distribution<float> size(0.25f, 1.0f);
+
+    std::vector<world::AABB> boxes(count);
+    for (auto &box : boxes) {
+        auto center = vec3(position(rng), position(rng), position(rng));
+        auto extents = vec3(size(rng), size(rng), size(rng));
+        box = world::AABB{.min = center - extents, .max = center + extents};
+    }
+    return boxes;
+}
+
+void report(size_t count) {
+    constexpr size_t queries = 1000;
+    std::mt19937 rng(1337);
+    float half_size;
+    auto boxes = random_boxes(count, rng, half_size);
+
+    world::BVH bvh;
+    auto single_us = measure([&]() { bvh.build(boxes, world::BVHBuildOptions{.threads = 1}); });
+    auto build_us = measure([&]() { bvh.build(boxes); });
+    auto build_cost = bvh.cost();
+
+    // Move every box a little, as if the objects had moved for a frame
+    std::uniform_real_distribution<float> jitter(-0.5f, 0.5f);
+    for (auto &box : boxes) {
+        auto offset = vec3(jitter(rng), jitter(rng), jitter(rng));
+        box = world::AABB{.min = box.min + offset, .max = box.max + offset};
+    }
+    auto refit_us = measure([&]() { bvh.refit(boxes); });
+    auto refit_cost = bvh.cost();
+
+    // Frustum query against the linear SIMD culler
+    auto projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, half_size);
+    auto view = glm::lookAt(vec3(0.0f, 0.0f, 0.0f), vec3(0.0f, 0.0f, -1.0f), vec3(0.0f, 1.0f, 0.0f));
+    auto frustum = world::Frustum::fromMatrix(projection * view);
+    world::FrustumCuller culler;
+    culler.reserve(count);
+    for (const auto &box : boxes)
+        culler.add(box);
+
+    std::vector<uint32_t> results;
+    size_t bvh_visible = 0, linear_visible = 0;
+    auto frustum_us = measure(
+        [&]() {
+            results.clear();
+            bvh.queryFrustum(frustum, results);
+            bvh_visible = results.size();
+        },
+        10);
+    auto linear_us = measure(
+        [&]() {
+            results.clear();
+            linear_visible = culler.cull(frustum, results);
+        },
+        10);
+
+    // Small sphere/box queries and rays through the whole volume
+    std::uniform_real_distribution<float> position(-half_size, half_size);
+    std::vector<vec3> points(queries);
+    for (auto &point : points)
+        point = vec3(position(rng), position(rng), position(rng));
+
+    size_t sphere_hits = 0, box_hits = 0, ray_hits = 0;
+    auto sphere_us = measure([&]() {
+        for (const auto &point : points) {
+            results.clear();
+            bvh.querySphere(point, 4.0f, results);
+            sphere_hits += results.size();
+        }
+    });
+    auto box_us = measure([&]() {
+        for (const auto &point : points) {
+            results.clear();
+            bvh.queryAABB(world::AABB{.min = point - vec3(4.0f, 4.0f, 4.0f), .max = point + vec3(4.0f, 4.0f, 4.0f)},
+                          results);
+            box_hits += results.size();
+        }
+    });
+    auto ray_us = measure([&]() {
+        for (const auto &point : points)
+            ray_hits += bvh.raycast(point, glm::normalize(-point)).hit();
+    });
+
+    // Check a few queries against brute force
+    size_t mismatches = linear_visible != bvh_visible;
+    for (size_t q = 0; q < 10; q++) {
+        results.clear();
+        bvh.querySphere(points[q], 4.0f, results);
+        size_t expected = 0;
+        world::RayHit closest{};
+        auto direction = glm::normalize(-points[q]);
+        auto inverse = vec3(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+        for (uint32_t i = 0; i < boxes.size(); i++) {
+            expected += boxes[i].distanceSquared(points[q]) <= 16.0f;
+            float distance;
+            if (boxes[i].intersectRay(points[q], inverse, closest.distance, distance) && distance < closest.distance)
+                closest = world::RayHit{.index = i, .distance = distance};
+        }
+        mismatches += results.size() != expected;
+        mismatches += bvh.raycast(points[q], direction).distance != closest.distance;
+    }
+
+    LOG(INFO) << "[bench] " << count << " boxes: " << bvh.nodeCount() << " nodes";
+    LOG(INFO) << "[bench]   build          " << build_us / 1000.0 << "ms (" << single_us / 1000.0
+              << "ms single-threaded), SAH cost " << build_cost;
+    LOG(INFO) << "[bench]   refit          " << refit_us / 1000.0 << "ms, SAH cost " << refit_cost << " ("
+              << refit_cost / build_cost << "x)";
+    LOG(INFO) << "[bench]   frustum query  " << frustum_us / 1000.0 << "ms (" << bvh_visible << " visible), linear "
+              << linear_us / 1000.0 << "ms";
+    LOG(INFO) << "[bench]   " << queries << " spheres   " << sphere_us / 1000.0 << "ms (" << sphere_hits / queries
+              << " hits per query)";
+    LOG(INFO) << "[bench]   " << queries << " boxes     " << box_us / 1000.0 << "ms (" << box_hits / queries
+              << " hits per query)";
+    LOG(INFO) << "[bench]   " << queries << " rays      " << ray_us / 1000.0 << "ms (" << ray_hits << " hits)";
+    if (mismatches > 0)
+        LOG(ERROR) << "[bench] " << mismatches << " BVH queries disagree with brute force";
+}
+
+}  // namespace
+
+/**
+ * @brief Build, refit and query a BVH over 10k, 100k and 1M random boxes
+ */
+void bvh() {
+    for (size_t count : {10'000UL, 100'000UL, 1'000'000UL})
+        report(count);
+}
+
+}  // namespace goat::bench
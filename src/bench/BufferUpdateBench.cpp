@@ -0,0 +1,132 @@
+#include <easylogging++.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench/bench.hpp"
+#include "gfx/DirtyRanges.hpp"
+#include "gfx/VBO.hpp"
+
+namespace goat::bench {
+
+namespace {
+
+// Floats per vertex (XYZ)
+constexpr size_t VERTEX_FLOATS = 3;
+
+// The vertices changed by one deformation step
+struct Deformation {
+    std::string name;
+    std::vector<size_t> vertices;
+};
+
+std::vector<Deformation> deformations(size_t vertex_count, std::mt19937 &rng) {
+    std::uniform_int_distribution<size_t> vertex(0, vertex_count - 1);
+    std::vector<Deformation> result{{"one vertex", {vertex(rng)}}, {"1% scattered", {}}, {"25% region", {}}};
+    for (size_t i = 0; i < vertex_count / 100; i++)
+        result[1].vertices.push_back(vertex(rng));
+    auto start = vertex(rng) % (vertex_count - vertex_count / 4);
+    for (size_t i = start; i < start + vertex_count / 4; i++)
+        result[2].vertices.push_back(i);
+    result.push_back({"everything", {}});
+    for (size_t i = 0; i < vertex_count; i++)
+        result[3].vertices.push_back(i);
+    return result;
+}
+
+}  // namespace
+
+/**
+ * @brief Compare the ways of updating part of a vertex buffer on deformations of different sizes, for buffers of
+ *        64KB, 1MB and 16MB: re-sending everything with `applyAttributeBounds` (the only option before range
+ *        updates), against flushing the dirty ranges with glBufferSubData, an orphaned full upload, and mapped
+ *        ranges (synchronized or not). Every measurement ends with glFinish, so the time spent by the driver and
+ *        any wait on the GPU is included. Needs an OpenGL 3.3 context: without one only the CPU cost of the
+ *        dirty range tracking is measured.
+ */
+void vbo_update() {
+    std::mt19937 rng(1234);
+
+    // The cost of tracking itself: marking 1% of the vertices of a 16MB buffer in random order
+    {
+        constexpr size_t vertex_count = 16UL * 1024UL * 1024UL / (VERTEX_FLOATS * sizeof(float));
+        std::uniform_int_distribution<size_t> vertex(0, vertex_count - 1);
+        std::vector<size_t> marks(vertex_count / 100);
+        for (auto &mark : marks)
+            mark = vertex(rng);
+        gfx::DirtyRanges dirty;
+        auto mark_us = measure([&]() {
+            dirty.clear();
+            for (auto mark : marks)
+                dirty.add(mark * VERTEX_FLOATS * sizeof(float), VERTEX_FLOATS * sizeof(float));
+        }, 20);
+        LOG(INFO) << "[vbo_update] marking " << marks.size() << " random vertices: " << mark_us << "us ("
+                  << mark_us * 1000.0 / marks.size() << "ns per vertex), " << dirty.get().size() << " ranges, "
+                  << dirty.bytes() / 1024 << "KB to upload";
+    }
+
+    auto window = create_hidden_context("vbo_update");
+    if (window == nullptr) {
+        LOG(WARNING) << "[vbo_update] no OpenGL 3.3 context available, skipping the upload strategies";
+        return;
+    }
+    LOG(INFO) << "[vbo_update] " << glGetString(GL_RENDERER) << " (" << glGetString(GL_VERSION) << ")";
+
+    const std::vector<std::pair<std::string, gfx::UpdateMode>> modes = {
+        {"sub_data", gfx::UpdateMode::SUB_DATA},
+        {"orphan", gfx::UpdateMode::ORPHAN},
+        {"map_range", gfx::UpdateMode::MAP_RANGE},
+        {"map_unsync", gfx::UpdateMode::MAP_UNSYNCHRONIZED},
+    };
+    for (size_t buffer_bytes : {64UL * 1024UL, 1024UL * 1024UL, 16UL * 1024UL * 1024UL}) {
+        auto vertex_count = buffer_bytes / (VERTEX_FLOATS * sizeof(float));
+        // About 256MB of full uploads per strategy, at least 8 iterations
+        auto iterations = std::max<size_t>(8, 256UL * 1024UL * 1024UL / buffer_bytes);
+        std::vector<float> points(vertex_count * VERTEX_FLOATS, 0.0f);
+
+        gfx::VBO vbo(gfx::BufferType::ARRAY, gfx::DrawType::DYNAMIC, gfx::DataType::FLOAT);
+        vbo.addAttributeBound(0, VERTEX_FLOATS);
+        vbo.applyAttributeBounds(points);
+
+        for (const auto &deformation : deformations(vertex_count, rng)) {
+            auto deform = [&](float amount) {
+                for (auto v : deformation.vertices)
+                    points[v * VERTEX_FLOATS + 1] = amount;
+            };
+            std::string line = "[vbo_update] " + std::to_string(buffer_bytes / 1024) + "KB, " + deformation.name +
+                               " (" + std::to_string(deformation.vertices.size()) + " vertices):";
+
+            float amount = 0.0f;
+            auto full_us = measure([&]() {
+                for (size_t i = 0; i < iterations; i++) {
+                    deform(amount += 0.01f);
+                    vbo.applyAttributeBounds(points);
+                }
+                glFinish();
+            }) / iterations;
+            line += " full " + std::to_string(static_cast<long>(full_us)) + "us";
+
+            for (const auto &[name, mode] : modes) {
+                size_t uploaded = 0UL;
+                auto us = measure([&]() {
+                    for (size_t i = 0; i < iterations; i++) {
+                        deform(amount += 0.01f);
+                        for (auto v : deformation.vertices)
+                            vbo.markDirty(v * VERTEX_FLOATS, VERTEX_FLOATS);
+                        uploaded += vbo.flush(points, mode);
+                    }
+                    glFinish();
+                }) / iterations;
+                line += ", " + name + " " + std::to_string(static_cast<long>(us)) + "us";
+                if (mode == gfx::UpdateMode::SUB_DATA)
+                    line += " (" + std::to_string(uploaded / iterations / 1024) + "KB)";
+            }
+            LOG(INFO) << line;
+        }
+    }
+
+    destroy_hidden_context(window);
+}
+
+}  // namespace goat::bench
@@ -0,0 +1,89 @@
+#include <easylogging++.h>
+
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "bench/bench.hpp"
+#include "gfx/CommandBuffer.hpp"
+#include "jobs/JobSystem.hpp"
+
+namespace goat::bench {
+
+namespace {
+
+// Record the draws [begin, end) the way `Scene::recordDraws` records per-object draws: VBO, model, layer, draw
+void record_draws(gfx::CommandBuffer &buffer, const std::vector<mat4> &models, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+        buffer.push<gfx::cmd::UseVBO>().vbo = nullptr;
+        auto &model = buffer.push<gfx::cmd::SetMatrix4>();
+        model.location = 0;
+        model.value = models[i];
+        auto &layer = buffer.push<gfx::cmd::SetUInt>();
+        layer.location = 1;
+        layer.value = static_cast<uint>(i & 7U);
+        buffer.push<gfx::cmd::Draw>().vbo = nullptr;
+    }
+}
+
+}  // namespace
+
+/**
+ * @brief Measure command recording at 1, 2, 4 and one thread per hardware thread, each recording its own slice of
+ *        400k per-object draws (4 commands each) into its own buffer, as `Scene::submitDraws` does. Also measures
+ *        walking the recorded commands on one thread, which is what replaying costs before any GL call.
+ */
+void command_buffer() {
+    constexpr size_t draw_count = 400'000;
+    constexpr size_t commands_per_draw = 4;
+    constexpr size_t iterations = 10;
+
+    std::vector<mat4> models(draw_count);
+    for (size_t i = 0; i < draw_count; i++)
+        models[i][3] = vec4(static_cast<float>(i % 100), static_cast<float>(i / 100), 0.0f, 1.0f);
+
+    auto hardware = std::max(1U, std::thread::hardware_concurrency());
+    std::set<uint> counts{1U, 2U, 4U, hardware};
+    for (auto threads : counts) {
+        jobs::JobSystem system(threads);
+        std::vector<gfx::CommandBuffer> buffers(threads);
+        auto record = [&](size_t begin, size_t end) {
+            for (size_t slice = begin; slice < end; slice++) {
+                buffers[slice].clear();
+                record_draws(buffers[slice], models, draw_count * slice / threads,
+                             draw_count * (slice + 1) / threads);
+            }
+        };
+        // The first frame grows the buffers, later ones reuse them
+        system.parallelFor(threads, 1, record);
+        auto record_us = measure([&]() { system.parallelFor(threads, 1, record); }, iterations);
+
+        size_t commands = 0UL, bytes = 0UL;
+        for (const auto &buffer : buffers) {
+            commands += buffer.size();
+            bytes += buffer.bytes();
+        }
+        if (commands != draw_count * commands_per_draw)
+            throw std::runtime_error("Command buffer bench: a slice was not recorded");
+
+        size_t draws = 0UL;
+        auto walk_us = measure([&]() {
+            draws = 0UL;
+            for (const auto &buffer : buffers)
+                buffer.visit([&draws](const gfx::CommandHeader &header) {
+                    draws += header.type == gfx::CommandType::DRAW ? 1UL : 0UL;
+                });
+        }, iterations);
+        if (draws != draw_count)
+            throw std::runtime_error("Command buffer bench: the recorded draws were not walked in full");
+
+        auto rate = static_cast<double>(commands) / record_us;
+        LOG(INFO) << "[command_buffer] " << threads << " threads: recorded " << commands << " commands ("
+                  << bytes / 1024 / 1024 << "MB) in " << record_us << "us, " << rate << "M commands/s ("
+                  << rate / threads << "M per thread), walked in " << walk_us << "us ("
+                  << static_cast<double>(commands) / walk_us << "M commands/s)";
+    }
+}
+
+}  // namespace goat::bench
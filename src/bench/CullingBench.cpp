@@ -0,0 +1,72 @@
+#include <easylogging++.h>
+
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <random>
+#include <vector>
+
+#include "bench/bench.hpp"
+#include "world/Culling.hpp"
+
+namespace goat::bench {
+
+/**
+ * @brief Cull 1M randomly placed boxes against a camera frustum with the scalar and SIMD implementations.
+ *        The boxes are spread around the camera, so only about 5% of them are visible.
+ */
+void frustum_cull() {
+    constexpr size_t count = 1'000'000;
+    constexpr size_t iterations = 20;
+
+    std::mt19937 rng(1337);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> size(0.25f, 2.0f);
+    std::vector<world::AABB> boxes(count);
+    for (auto &box : boxes) {
+        auto center = vec3(position(rng), position(rng), position(rng));
+        auto extents = vec3(size(rng), size(rng), size(rng));
+        box = world::AABB{.min = center - extents, .max = center + extents};
+    }
+
+    auto projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    auto view = glm::lookAt(vec3(0.0f, 0.0f, 0.0f), vec3(0.0f, 0.0f, -1.0f), vec3(0.0f, 1.0f, 0.0f));
+    auto frustum = world::Frustum::fromMatrix(projection * view);
+
+    world::FrustumCuller culler;
+    auto fill_us = measure(
+        [&]() {
+            culler.clear();
+            culler.reserve(count);
+            for (const auto &box : boxes)
+                culler.add(box);
+        },
+        iterations);
+
+    std::vector<uint32_t> visible;
+    visible.reserve(count);
+    size_t scalar_visible = 0, simd_visible = 0;
+    auto scalar_us = measure(
+        [&]() {
+            visible.clear();
+            scalar_visible = culler.cullScalar(frustum, visible);
+        },
+        iterations);
+    auto simd_us = measure(
+        [&]() {
+            visible.clear();
+            simd_visible = culler.cull(frustum, visible);
+        },
+        iterations);
+
+    LOG(INFO) << "[bench] " << count << " boxes: " << simd_visible << " visible, " << count - simd_visible
+              << " culled";
+    LOG(INFO) << "[bench]   fill SoA arrays  " << fill_us / 1000.0 << "ms";
+    LOG(INFO) << "[bench]   scalar           " << scalar_us / 1000.0 << "ms";
+    LOG(INFO) << "[bench]   " << world::FrustumCuller::simdPath() << "    " << simd_us / 1000.0 << "ms ("
+              << scalar_us / simd_us << "x)";
+    if (scalar_visible != simd_visible)
+        LOG(ERROR) << "[bench] SIMD culling disagrees with the scalar reference (" << simd_visible << " vs "
+                   << scalar_visible << ")";
+}
+
+}  // namespace goat::bench
@@ -0,0 +1,95 @@
+#include <easylogging++.h>
+
+#include <atomic>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "bench/bench.hpp"
+#include "jobs/JobSystem.hpp"
+#include "world/Scene.hpp"
+
+namespace goat::bench {
+
+/**
+ * @brief Measure how the job system scales at 1, 2, 4 and one thread per hardware thread:
+ *        - the transform update of 200k objects split with `parallelFor` (as `Scene::updateTransforms` does),
+ *        - the overhead of 100k empty jobs submitted and waited on from the main thread,
+ *        - a chain of 64 groups of 64 jobs, each group waiting on the previous one (checked for ordering).
+ */
+void jobs() {
+    constexpr size_t object_count = 200'000;
+    constexpr size_t iterations = 20;
+    constexpr size_t empty_jobs = 100'000;
+    static constexpr size_t stages = 64;
+    static constexpr size_t stage_jobs = 64;
+
+    std::vector<std::shared_ptr<world::GameObject>> objects;
+    objects.reserve(object_count);
+    for (size_t i = 0; i < object_count; i++) {
+        auto object = world::GameObject::create(vec3(static_cast<float>(i % 100), static_cast<float>(i / 100), 0.0f));
+        object->transform->rot = vec3(static_cast<float>(i % 360), 0.0f, static_cast<float>(i % 90));
+        object->bounds = world::AABB{.min = vec3(-0.5f), .max = vec3(0.5f)};
+        objects.push_back(object);
+    }
+
+    auto hardware = std::max(1U, std::thread::hardware_concurrency());
+    std::set<uint> counts{1U, 2U, 4U, hardware};
+    double baseline_us = 0.0;
+    for (auto threads : counts) {
+        jobs::JobSystem system(threads);
+
+        auto transform_us = measure([&]() {
+            system.parallelFor(objects.size(), world::TRANSFORM_JOB_GRAIN, [&objects](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++)
+                    objects[i]->updateTransform();
+            });
+        }, iterations);
+        if (threads == 1)
+            baseline_us = transform_us;
+
+        std::atomic<size_t> ran{0};
+        auto empty_us = measure([&]() {
+            jobs::JobCounter counter;
+            for (size_t i = 0; i < empty_jobs; i++)
+                system.run([&ran]() { ran.fetch_add(1, std::memory_order_relaxed); }, &counter);
+            system.wait(counter);
+        });
+        if (ran.load() != empty_jobs)
+            throw std::runtime_error("Job bench: not every empty job ran");
+
+        // Every job of a stage checks that the whole previous stage has finished before it started
+        std::vector<std::atomic<size_t>> finished(stages);
+        std::atomic<size_t> violations{0};
+        auto chain_us = measure([&]() {
+            std::vector<std::unique_ptr<jobs::JobCounter>> counters;
+            for (size_t stage = 0; stage < stages; stage++) {
+                counters.push_back(std::make_unique<jobs::JobCounter>());
+                auto after = stage > 0 ? counters[stage - 1].get() : nullptr;
+                for (size_t j = 0; j < stage_jobs; j++) {
+                    system.run(
+                        [&finished, &violations, stage]() {
+                            if (stage > 0 && finished[stage - 1].load() != stage_jobs)
+                                violations.fetch_add(1);
+                            finished[stage].fetch_add(1);
+                        },
+                        counters.back().get(), after);
+                }
+            }
+            // Every counter, not just the last: earlier ones are still touched while releasing the stage after them
+            for (auto &counter : counters)
+                system.wait(*counter);
+        });
+        if (violations.load() != 0 || finished.back().load() != stage_jobs)
+            throw std::runtime_error("Job bench: a job started before the jobs it depends on finished");
+
+        auto stats = system.getStats();
+        LOG(INFO) << "[jobs] " << threads << " threads: transforms " << transform_us << "us ("
+                  << baseline_us / transform_us << "x), " << empty_us * 1000.0 / empty_jobs << "ns per empty job, "
+                  << stages << "x" << stage_jobs << " job chain " << chain_us << "us (" << stats.executed
+                  << " jobs run, " << stats.stolen << " stolen)";
+    }
+}
+
+}  // namespace goat::bench
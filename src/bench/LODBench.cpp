@@ -0,0 +1,106 @@
+#include <easylogging++.h>
+
+#include <cmath>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include "bench/bench.hpp"
+#include "mesh/Simplify.hpp"
+#include "world/LOD.hpp"
+
+namespace goat::bench {
+
+namespace {
+
+// The largest distance from the centroid of a triangle to the surface of a sphere, approximating how far the
+// flat triangles of a tessellated sphere are from the real surface
+float sphere_deviation(const mesh::Mesh &mesh, float radius) {
+    float deviation = 0.0f;
+    for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+        const float *a = mesh.vertex(mesh.indices[i]), *b = mesh.vertex(mesh.indices[i + 1]),
+                    *c = mesh.vertex(mesh.indices[i + 2]);
+        auto centroid = vec3(a[0] + b[0] + c[0], a[1] + b[1] + c[1], a[2] + b[2] + c[2]) / 3.0f;
+        deviation = std::max(deviation, std::abs(radius - glm::length(centroid)));
+    }
+    return deviation;
+}
+
+}  // namespace
+
+/**
+ * @brief Simplify a 128x256 UV sphere into a chain of levels of detail, then pick levels for 100k objects at
+ *        random distances (as seen by a 1080p, 75 degree camera) and for objects drifting back and forth across
+ *        switching distances, with and without hysteresis.
+ */
+void lod() {
+    constexpr size_t objects = 100'000;
+    constexpr size_t frames = 1'000;
+    constexpr float screen_height = 1080.0f;
+
+    auto sphere = mesh::sphere(128, 256);
+    std::vector<mesh::LODMesh> chain;
+    auto build_us = measure([&]() { chain = mesh::buildLODChain(sphere, 6); });
+    auto base = sphere_deviation(sphere, 1.0f);
+    world::LODChain lods;
+    LOG(INFO) << "[bench] " << chain.size() << " levels built in " << build_us / 1000.0 << "ms";
+    for (size_t i = 0; i < chain.size(); i++) {
+        lods.levels.push_back(world::LODLevel{.vbo = nullptr, .error = chain[i].error});
+        // Simplified vertices stay on the sphere, so its faceting is an upper bound of the distance to level 0
+        LOG(INFO) << "[bench]   level " << i << ": " << chain[i].mesh.triangleCount() << " triangles, "
+                  << chain[i].mesh.vertexCount() << " vertices, error " << chain[i].error << " (faceting "
+                  << sphere_deviation(chain[i].mesh, 1.0f) - base << ")";
+    }
+
+    auto pixels_per_unit = [&](float distance) {
+        auto projection_scale = 1.0f / std::tan(glm::radians(75.0f) * 0.5f);
+        return projection_scale * screen_height * 0.5f / distance;
+    };
+
+    std::mt19937 rng(1337);
+    std::uniform_real_distribution<float> range(2.0f, 100.0f);
+    std::vector<float> distances(objects);
+    for (auto &distance : distances)
+        distance = range(rng);
+    std::vector<size_t> selected(objects, 0UL);
+    auto select_us = measure([&]() {
+        for (size_t i = 0; i < objects; i++)
+            selected[i] = lods.select(pixels_per_unit(distances[i]), world::DEFAULT_LOD_PIXEL_ERROR,
+                                      world::DEFAULT_LOD_HYSTERESIS, selected[i]);
+    });
+    size_t triangles = 0;
+    std::vector<size_t> histogram(lods.levels.size(), 0UL);
+    for (auto level : selected) {
+        triangles += chain[level].mesh.triangleCount();
+        histogram[level]++;
+    }
+    std::stringstream levels;
+    for (size_t i = 0; i < histogram.size(); i++)
+        levels << (i > 0 ? "/" : "") << histogram[i];
+    LOG(INFO) << "[bench] selected levels for " << objects << " objects in " << select_us / 1000.0 << "ms ("
+              << levels.str() << " per level): " << triangles / 1'000'000 << "M triangles instead of "
+              << objects * sphere.triangleCount() / 1'000'000 << "M";
+
+    // Objects slowly drifting around their distance, plus per-frame jitter (e.g. camera shake)
+    std::normal_distribution<float> jitter(0.0f, 0.05f);
+    for (auto hysteresis : {0.0f, world::DEFAULT_LOD_HYSTERESIS}) {
+        std::mt19937 drift_rng(7);
+        size_t switches = 0;
+        for (size_t i = 0; i < 1'000; i++) {
+            auto distance = distances[i];
+            size_t current = lods.select(pixels_per_unit(distance), world::DEFAULT_LOD_PIXEL_ERROR, hysteresis, 0);
+            for (size_t frame = 0; frame < frames; frame++) {
+                auto offset = std::sin(static_cast<float>(frame) * 0.01f) * 0.5f + jitter(drift_rng);
+                auto next = lods.select(pixels_per_unit(distance + offset), world::DEFAULT_LOD_PIXEL_ERROR,
+                                        hysteresis, current);
+                if (next != current)
+                    switches++;
+                current = next;
+            }
+        }
+        LOG(INFO) << "[bench] hysteresis " << hysteresis << ": " << switches << " level switches over " << frames
+                  << " frames of 1000 drifting objects";
+    }
+}
+
+}  // namespace goat::bench
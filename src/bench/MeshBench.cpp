@@ -0,0 +1,95 @@
+#include <easylogging++.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+
+#include "bench/bench.hpp"
+#include "mesh/Optimize.hpp"
+#include "mesh/Quantize.hpp"
+
+namespace goat::bench {
+
+namespace {
+
+// A flat XYZ+UV grid of `size` x `size` quads, with its triangles shuffled to mimic an unoptimized export
+mesh::Mesh shuffled_grid(uint size) {
+    mesh::Mesh grid{.vertices = {}, .indices = {}, .vertex_size = 5};
+    for (uint y = 0; y <= size; y++) {
+        for (uint x = 0; x <= size; x++) {
+            auto u = static_cast<float>(x) / size;
+            auto v = static_cast<float>(y) / size;
+            grid.vertices.insert(grid.vertices.end(), {u, v, 0.0f, u, v});
+        }
+    }
+
+    std::vector<std::array<uint, 3>> triangles;
+    for (uint y = 0; y < size; y++) {
+        for (uint x = 0; x < size; x++) {
+            uint i = y * (size + 1) + x;
+            triangles.push_back({i, i + 1, i + size + 1});
+            triangles.push_back({i + 1, i + size + 2, i + size + 1});
+        }
+    }
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937(1337));
+    for (const auto &triangle : triangles)
+        grid.indices.insert(grid.indices.end(), triangle.begin(), triangle.end());
+    return grid;
+}
+
+void report(const std::string &name, mesh::Mesh mesh) {
+    auto before = mesh::analyzeVertexCache(mesh);
+    std::vector<size_t> clusters;
+    auto cache_us = measure([&]() { clusters = mesh::optimizeVertexCache(mesh); });
+    auto after_cache = mesh::analyzeVertexCache(mesh);
+    auto overdraw_us = measure([&]() { mesh::optimizeOverdraw(mesh, clusters); });
+    auto after_overdraw = mesh::analyzeVertexCache(mesh);
+    auto fetch_us = measure([&]() { mesh::optimizeVertexFetch(mesh); });
+
+    LOG(INFO) << "[bench] " << name << ": " << mesh.triangleCount() << " triangles, " << mesh.vertexCount()
+              << " vertices, " << clusters.size() << " clusters";
+    LOG(INFO) << "[bench]   unoptimized   ACMR " << before.acmr << " ATVR " << before.atvr;
+    LOG(INFO) << "[bench]   vertex cache  ACMR " << after_cache.acmr << " ATVR " << after_cache.atvr << " ("
+              << cache_us / 1000.0 << "ms)";
+    LOG(INFO) << "[bench]   overdraw      ACMR " << after_overdraw.acmr << " ATVR " << after_overdraw.atvr << " ("
+              << overdraw_us / 1000.0 << "ms)";
+    LOG(INFO) << "[bench]   vertex fetch  (" << fetch_us / 1000.0 << "ms)";
+}
+
+}  // namespace
+
+/**
+ * @brief Run the mesh optimization pipeline step by step on generated meshes, reporting the vertex cache
+ *        statistics after each step
+ */
+void mesh_optimize() {
+    report("shuffled grid 256x256", shuffled_grid(256));
+    report("uv sphere 128x256", mesh::sphere(128, 256));
+}
+
+/**
+ * @brief Encode a sphere's XYZ+UV vertices with several attribute formats, reporting the vertex size, the
+ *        encoding time and the error each format introduces
+ */
+void vertex_quantize() {
+    using gfx::DataType;
+    auto mesh = mesh::sphere(512, 1024);
+    const std::vector<std::pair<std::string, std::vector<gfx::VAOBound>>> formats = {
+        {"float/float", {{0, 0, 3, DataType::FLOAT, false}, {1, 0, 2, DataType::FLOAT, false}}},
+        {"half/half", {{0, 0, 3, DataType::HALF_FLOAT, false}, {1, 0, 2, DataType::HALF_FLOAT, false}}},
+        {"snorm16/unorm16", {{0, 0, 3, DataType::SHORT, true}, {1, 0, 2, DataType::UNSIGNED_SHORT, true}}},
+        {"half/unorm16", {{0, 0, 3, DataType::HALF_FLOAT, false}, {1, 0, 2, DataType::UNSIGNED_SHORT, true}}},
+        {"snorm8/unorm8", {{0, 0, 3, DataType::BYTE, true}, {1, 0, 2, DataType::UNSIGNED_BYTE, true}}},
+    };
+
+    LOG(INFO) << "[bench] uv sphere 512x1024: " << mesh.vertexCount() << " vertices";
+    for (const auto &[name, format] : formats) {
+        mesh::QuantizedMesh quantized;
+        auto duration = measure([&]() { quantized = mesh::quantize(mesh, format); });
+        LOG(INFO) << "[bench] " << name << " (" << duration / 1000.0 << "ms)";
+        mesh::logQuantization(mesh, quantized);
+    }
+}
+
+}  // namespace goat::bench
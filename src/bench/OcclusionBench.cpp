@@ -0,0 +1,107 @@
+#include <easylogging++.h>
+
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <random>
+#include <vector>
+
+#include "bench/bench.hpp"
+#include "world/Occlusion.hpp"
+
+namespace goat::bench {
+
+/**
+ * @brief Rasterize a wall of 60 box occluders (with small gaps between them) into the occlusion buffer, then test
+ *        100k random boxes in the frustum against it. Compares the SIMD and scalar rasterizers, and checks that no
+ *        box in front of the wall is reported as occluded.
+ */
+void occlusion() {
+    constexpr size_t count = 100'000;
+    constexpr size_t iterations = 50;
+    constexpr float wall_z = -20.0f;
+
+    auto projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    auto view = glm::lookAt(vec3(0.0f, 0.0f, 0.0f), vec3(0.0f, 0.0f, -1.0f), vec3(0.0f, 1.0f, 0.0f));
+    auto view_projection = projection * view;
+    auto frustum = world::Frustum::fromMatrix(view_projection);
+
+    // A 10x6 grid of 3.6x3.6x1 boxes, 4 units apart, covering the whole view at the wall's depth
+    std::vector<std::pair<std::shared_ptr<const world::Occluder>, mat4>> occluders;
+    auto wall_box = world::AABB{.min = vec3(-1.8f, -1.8f, -0.5f), .max = vec3(1.8f, 1.8f, 0.5f)};
+    auto wall_occluder = world::Occluder::fromBox(wall_box);
+    for (int y = -3; y < 3; y++)
+        for (int x = -5; x < 5; x++)
+            occluders.emplace_back(wall_occluder,
+                                   glm::translate(mat4(1.0f), vec3(x * 4.0f + 2.0f, y * 4.0f + 2.0f, wall_z)));
+
+    std::mt19937 rng(1337);
+    std::uniform_real_distribution<float> position_x(-40.0f, 40.0f), position_y(-25.0f, 25.0f),
+        position_z(-95.0f, -1.0f);
+    std::uniform_real_distribution<float> size(0.1f, 0.5f);
+    std::vector<world::AABB> boxes;
+    boxes.reserve(count);
+    while (boxes.size() < count) {
+        auto center = vec3(position_x(rng), position_y(rng), position_z(rng));
+        auto extents = vec3(size(rng), size(rng), size(rng));
+        auto box = world::AABB{.min = center - extents, .max = center + extents};
+        if (frustum.intersects(box))
+            boxes.push_back(box);
+    }
+
+    world::OcclusionBuffer buffer;
+    auto setup_us = measure(
+        [&]() {
+            buffer.begin(view_projection);
+            for (const auto &[occluder, model] : occluders)
+                buffer.addOccluder(*occluder, model);
+        },
+        iterations);
+    auto scalar_us = measure([&]() { buffer.rasterizeScalar(); }, iterations);
+    auto scalar_depth = buffer.getDepth();
+    auto simd_us = measure([&]() { buffer.rasterize(); }, iterations);
+
+    size_t mismatched = 0;
+    for (size_t i = 0; i < scalar_depth.size(); i++)
+        if (scalar_depth[i] != buffer.getDepth()[i])
+            mismatched++;
+    size_t covered = 0;
+    for (auto depth : buffer.getDepth())
+        if (depth > 0.0f)
+            covered++;
+
+    size_t occluded = 0, false_occlusions = 0, behind = 0;
+    auto test_us = measure(
+        [&]() {
+            occluded = 0;
+            false_occlusions = 0;
+            for (const auto &box : boxes) {
+                if (buffer.visible(box))
+                    continue;
+                occluded++;
+                // Only boxes entirely behind the wall's front face can be hidden by it
+                if (box.max.z > wall_z + 0.5f)
+                    false_occlusions++;
+            }
+        },
+        iterations / 10);
+    for (const auto &box : boxes)
+        if (box.max.z <= wall_z + 0.5f)
+            behind++;
+
+    const auto &stats = buffer.getStats();
+    LOG(INFO) << "[bench] " << buffer.getWidth() << "x" << buffer.getHeight() << " buffer, " << stats.occluders
+              << " occluders (" << stats.triangles << " triangles binned into " << stats.binned << " tiles), "
+              << covered * 100 / scalar_depth.size() << "% of pixels covered";
+    LOG(INFO) << "[bench]   transform + bin  " << setup_us / 1000.0 << "ms";
+    LOG(INFO) << "[bench]   scalar raster    " << scalar_us / 1000.0 << "ms";
+    LOG(INFO) << "[bench]   " << world::OcclusionBuffer::simdPath() << "    " << simd_us / 1000.0 << "ms ("
+              << scalar_us / simd_us << "x)";
+    LOG(INFO) << "[bench]   test " << count << " boxes " << test_us / 1000.0 << "ms: " << occluded << " occluded of "
+              << behind << " behind the wall";
+    if (mismatched > 0)
+        LOG(ERROR) << "[bench] SIMD rasterization disagrees with the scalar reference on " << mismatched << " pixels";
+    if (false_occlusions > 0)
+        LOG(ERROR) << "[bench] " << false_occlusions << " boxes in front of the wall were reported as occluded";
+}
+
+}  // namespace goat::bench
@@ -0,0 +1,75 @@
+#include <easylogging++.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "bench/bench.hpp"
+#include "gfx/RenderQueue.hpp"
+
+namespace goat::bench {
+
+/**
+ * @brief Sort 1M render queue keys with the radix sort and compare against std::sort/std::stable_sort. The keys
+ *        use a realistic spread: a handful of programs, a few hundred materials/VAOs and random depths.
+ */
+void render_queue() {
+    constexpr size_t count = 1'000'000;
+    constexpr size_t iterations = 10;
+
+    std::mt19937 rng(1337);
+    std::uniform_int_distribution<uint32_t> program(1, 8);
+    std::uniform_int_distribution<uint32_t> material(1, 256);
+    std::uniform_int_distribution<uint32_t> vao(1, 512);
+    std::uniform_real_distribution<float> depth(0.0f, 1.0f);
+    std::uniform_int_distribution<int> translucent(0, 9);
+
+    std::vector<gfx::SortEntry> source(count);
+    for (size_t i = 0; i < count; i++) {
+        auto pass = translucent(rng) == 0 ? gfx::RenderPass::TRANSLUCENT : gfx::RenderPass::SOLID;
+        source[i] = gfx::SortEntry{
+            .key = gfx::SortKey::make(pass, program(rng), material(rng), vao(rng), depth(rng)),
+            .item = static_cast<uint32_t>(i),
+        };
+    }
+
+    // Each run sorts a fresh copy; the copy is timed separately and subtracted
+    std::vector<gfx::SortEntry> entries;
+    std::vector<gfx::SortEntry> scratch;
+    auto copy_us = measure([&]() { entries = source; }, iterations);
+
+    auto radix_us = measure(
+                        [&]() {
+                            entries = source;
+                            gfx::radix_sort(entries, scratch);
+                        },
+                        iterations) -
+                    copy_us;
+    bool sorted = std::is_sorted(entries.begin(), entries.end(),
+                                 [](const gfx::SortEntry &a, const gfx::SortEntry &b) { return a.key < b.key; });
+
+    auto by_key = [](const gfx::SortEntry &a, const gfx::SortEntry &b) { return a.key < b.key; };
+    auto std_us = measure(
+                      [&]() {
+                          entries = source;
+                          std::sort(entries.begin(), entries.end(), by_key);
+                      },
+                      iterations) -
+                  copy_us;
+    auto stable_us = measure(
+                         [&]() {
+                             entries = source;
+                             std::stable_sort(entries.begin(), entries.end(), by_key);
+                         },
+                         iterations) -
+                     copy_us;
+
+    auto rate = [&](double us) { return static_cast<double>(count) / us; };
+    LOG(INFO) << "[bench] render_queue: " << count << " keys, " << iterations << " iterations"
+              << (sorted ? "" : " (RADIX SORT OUTPUT NOT SORTED)");
+    LOG(INFO) << "[bench]   radix_sort       " << radix_us / 1000.0 << "ms (" << rate(radix_us) << " Mkeys/s)";
+    LOG(INFO) << "[bench]   std::sort        " << std_us / 1000.0 << "ms (" << rate(std_us) << " Mkeys/s)";
+    LOG(INFO) << "[bench]   std::stable_sort " << stable_us / 1000.0 << "ms (" << rate(stable_us) << " Mkeys/s)";
+}
+
+}  // namespace goat::bench
@@ -0,0 +1,101 @@
+#include <easylogging++.h>
+
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "bench/bench.hpp"
+#include "jobs/JobSystem.hpp"
+#include "world/Scene.hpp"
+#include "world/SceneSnapshot.hpp"
+
+namespace goat::bench {
+
+/**
+ * @brief Measure what the render thread costs and saves:
+ *        - capturing 200k objects into a snapshot (the first capture also copies the objects for the render
+ *          thread), against updating their transforms in place,
+ *        - frames simulated and drawn one after the other, against the simulation running a frame ahead of the
+ *          render thread through a `SnapshotBuffer`. Sleeps stand in for the work of both sides (like the waits on
+ *          the driver and vsync), so the overlap shows even on a single core.
+ */
+void render_thread() {
+    constexpr size_t object_count = 200'000;
+    constexpr size_t iterations = 20;
+    constexpr size_t frames = 120;
+    constexpr auto simulation_time = std::chrono::microseconds(4000);
+    constexpr auto render_time = std::chrono::microseconds(6000);
+
+    // The scene is only captured, so it needs no render context
+    jobs::JobSystem system(1U);
+    std::unique_ptr<world::Scene> scene(world::Scene::create(
+        "Bench", std::make_shared<world::Camera>(vec3(0.0f, 0.0f, 0.0f)), std::shared_ptr<gfx::RenderContext>()));
+    scene->jobs = &system;
+    scene->objects.reserve(object_count);
+    for (size_t i = 0; i < object_count; i++) {
+        auto object = world::GameObject::create(vec3(static_cast<float>(i % 100), static_cast<float>(i / 100), 0.0f));
+        object->transform->rot = vec3(static_cast<float>(i % 360), 0.0f, static_cast<float>(i % 90));
+        object->bounds = world::AABB{.min = vec3(-0.5f), .max = vec3(0.5f)};
+        scene->objects.push_back(object);
+    }
+
+    world::SceneSnapshot snapshot{};
+    auto first_us = measure([&]() { scene->capture(snapshot); });
+    auto capture_us = measure([&]() { scene->capture(snapshot); }, iterations);
+    auto update_us = measure([&]() { scene->updateTransforms(); }, iterations);
+    for (size_t i = 0; i < object_count; i++)
+        if (snapshot.models[i] != scene->objects[i]->model)
+            throw std::runtime_error("Render thread bench: a captured transform differs from the updated one");
+    LOG(INFO) << "[render_thread] capture " << object_count << " objects: " << capture_us << "us (" << first_us
+              << "us with copying the objects), update in place " << update_us << "us";
+
+    // Changing how an object is drawn copies it again, and only it: earlier snapshots keep drawing the old copy
+    auto before = snapshot.objects;
+    scene->objects[7]->active = false;
+    scene->capture(snapshot);
+    if (snapshot.objects == before || (*snapshot.objects)[7] == (*before)[7] || (*snapshot.objects)[7]->active ||
+        !(*before)[7]->active || (*snapshot.objects)[8] != (*before)[8] || (*snapshot.objects)[8] == scene->objects[8])
+        throw std::runtime_error("Render thread bench: a changed object was not copied into a new object list");
+
+    auto serial_us = measure([&]() {
+        for (size_t frame = 0; frame < frames; frame++) {
+            std::this_thread::sleep_for(simulation_time);
+            std::this_thread::sleep_for(render_time);
+        }
+    });
+
+    world::SnapshotBuffer snapshots{};
+    size_t drawn = 0UL;
+    uint64_t last_frame = 0UL;
+    bool ordered = true;
+    auto threaded_us = measure([&]() {
+        std::thread renderer([&]() {
+            while (auto snapshot = snapshots.acquire()) {
+                ordered = ordered && snapshot->frame > last_frame;
+                last_frame = snapshot->frame;
+                std::this_thread::sleep_for(render_time);
+                snapshots.release();
+                drawn++;
+            }
+        });
+        for (size_t frame = 0; frame < frames; frame++) {
+            auto &snapshot = snapshots.write();
+            snapshot.frame = frame + 1;
+            std::this_thread::sleep_for(simulation_time);
+            snapshots.publish();
+        }
+        snapshots.stop();
+        renderer.join();
+    });
+    if (!ordered)
+        throw std::runtime_error("Render thread bench: a snapshot was drawn out of order or twice");
+
+    auto stats = snapshots.getStats();
+    LOG(INFO) << "[render_thread] " << frames << " frames (" << simulation_time.count() << "us simulated, "
+              << render_time.count() << "us drawn): " << serial_us / 1000.0 / frames << "ms per frame serial, "
+              << threaded_us / 1000.0 / frames << "ms with a render thread (" << drawn
+              << " drawn, simulation waited " << stats.simulation_wait_us / 1000.0 << "ms, rendering waited "
+              << stats.render_wait_us / 1000.0 << "ms)";
+}
+
+}  // namespace goat::bench
@@ -0,0 +1,108 @@
+#include <easylogging++.h>
+
+#include <cmath>
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <vector>
+
+#include "bench/bench.hpp"
+#include "world/Culling.hpp"
+#include "world/GameObject.hpp"
+#include "world/StaticBatch.hpp"
+
+namespace goat::bench {
+
+namespace {
+
+// A unit cube with 8 shared corners (XYZ+UV)
+std::shared_ptr<const mesh::Mesh> box_mesh() {
+    auto box = std::make_shared<mesh::Mesh>(mesh::Mesh{.vertices = {}, .indices = {}, .vertex_size = 5});
+    for (uint i = 0; i < 8; i++)
+        box->vertices.insert(box->vertices.end(),
+                             {(i & 1) ? 0.5f : -0.5f, (i & 2) ? 0.5f : -0.5f, (i & 4) ? 0.5f : -0.5f,
+                              (i & 1) ? 1.0f : 0.0f, (i & 2) ? 1.0f : 0.0f});
+    box->indices = {0, 2, 1, 1, 2, 3, 4, 5, 6, 5, 7, 6, 0, 1, 4, 1, 5, 4,
+                    2, 6, 3, 3, 6, 7, 0, 4, 2, 2, 4, 6, 1, 3, 5, 3, 7, 5};
+    return box;
+}
+
+}  // namespace
+
+/**
+ * @brief Merge 50k static boxes laid out on the demo's grid into chunked world-space geometry, then compare the
+ *        draw calls needed to render what is in front of the camera: one per visible object on the per-object
+ *        path, against one per run of consecutive visible chunks once batched.
+ */
+void static_batch() {
+    constexpr size_t count = 50'000;
+    constexpr size_t iterations = 20;
+    constexpr float spacing = 1.5f;
+
+    auto box = box_mesh();
+    auto side = static_cast<size_t>(std::ceil(std::cbrt(static_cast<double>(count))));
+    std::vector<std::shared_ptr<world::GameObject>> objects;
+    std::vector<const world::GameObject *> pointers;
+    objects.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        auto position = vec3((static_cast<float>(i % side) - side / 2.0f) * spacing,
+                             (static_cast<float>((i / side) % side) - side / 2.0f) * spacing,
+                             -5.0f - static_cast<float>(i / (side * side)) * spacing);
+        auto object = world::GameObject::create(position, gfx::ObjectLifetime::STATIC);
+        object->transform->rot = vec3(0.0f, static_cast<float>(i % 90), 0.0f);
+        object->bounds = world::AABB::fromPoints(box->vertices.data(), box->vertexCount(), box->vertex_size);
+        object->mesh = box;
+        objects.push_back(object);
+        pointers.push_back(object.get());
+    }
+
+    world::StaticGeometry geometry;
+    auto merge_us = measure([&]() { geometry = world::StaticGeometry::merge(pointers); });
+
+    auto projection = glm::perspective(glm::radians(75.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    for (auto target : {vec3(0.0f, 0.0f, -1.0f), vec3(1.0f, 0.0f, -0.2f)}) {
+        auto view = glm::lookAt(vec3(0.0f, 0.0f, 3.0f), vec3(0.0f, 0.0f, 3.0f) + target, vec3(0.0f, 1.0f, 0.0f));
+        auto frustum = world::Frustum::fromMatrix(projection * view);
+
+        world::FrustumCuller culler;
+        std::vector<uint32_t> visible;
+        size_t visible_objects = 0;
+        auto objects_us = measure(
+            [&]() {
+                culler.clear();
+                culler.reserve(count);
+                for (const auto &object : objects)
+                    culler.add(object->getWorldBounds());
+                visible.clear();
+                visible_objects = culler.cull(frustum, visible);
+            },
+            iterations);
+
+        size_t visible_chunks = 0, draws = 0;
+        auto chunks_us = measure(
+            [&]() {
+                visible_chunks = 0;
+                draws = 0;
+                bool previous = false;
+                for (const auto &chunk : geometry.chunks) {
+                    bool inside = frustum.intersects(chunk.bounds);
+                    visible_chunks += inside ? 1 : 0;
+                    // Consecutive visible chunks are drawn as one range
+                    if (inside && !previous)
+                        draws++;
+                    previous = inside;
+                }
+            },
+            iterations);
+
+        LOG(INFO) << "[bench] camera towards (" << target.x << ", " << target.y << ", " << target.z << ")";
+        LOG(INFO) << "[bench]   per object  " << objects_us / 1000.0 << "ms: " << visible_objects << " of " << count
+                  << " objects visible, " << visible_objects << " draw calls";
+        LOG(INFO) << "[bench]   batched     " << chunks_us / 1000.0 << "ms: " << visible_chunks << " of "
+                  << geometry.chunks.size() << " chunks visible, " << draws << " draw calls";
+    }
+    LOG(INFO) << "[bench] merged " << count << " objects in " << merge_us / 1000.0 << "ms ("
+              << geometry.mesh.vertices.size() * sizeof(float) / 1024 / 1024 << "MB of vertices, "
+              << geometry.mesh.indices.size() * sizeof(uint) / 1024 / 1024 << "MB of indices)";
+}
+
+}  // namespace goat::bench
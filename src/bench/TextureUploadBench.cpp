@@ -0,0 +1,107 @@
+#include <easylogging++.h>
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench/bench.hpp"
+#include "gfx/TextureLoader.hpp"
+#include "jobs/JobSystem.hpp"
+
+namespace goat::bench {
+
+/**
+ * @brief Compare loading the demo's textures (8 copies of each) synchronously, which stalls a single frame for the
+ *        whole load, against a `TextureLoader` decoding them on the job system and uploading them under budgets of
+ *        256KB, 1MB and 4MB per frame. Reports the longest frame, the frames taken and the bytes uploaded per
+ *        frame. Every frame ends with glFinish, so the driver's copies are included. Then streams the same textures
+ *        under a 4MB memory budget, all of them drawn close up and then only half of them, to show levels being
+ *        streamed in and evicted. Needs an OpenGL 3.3 context.
+ */
+void texture_upload() {
+    constexpr size_t copies = 8;
+    const std::vector<std::string> files = {"textures/gaga.dds", "textures/da_baby_car.dds"};
+
+    auto window = create_hidden_context("texture_upload");
+    if (window == nullptr) {
+        LOG(WARNING) << "[texture_upload] no OpenGL 3.3 context available, skipping";
+        return;
+    }
+    LOG(INFO) << "[texture_upload] " << glGetString(GL_RENDERER) << " (" << glGetString(GL_VERSION) << ")";
+
+    {
+        std::vector<std::shared_ptr<gfx::Texture>> textures{};
+        auto sync_us = measure([&]() {
+            for (size_t i = 0; i < copies; i++)
+                for (const auto &file : files)
+                    textures.push_back(std::make_shared<gfx::Texture>(file));
+            glFinish();
+        });
+        LOG(INFO) << "[texture_upload] synchronous: " << textures.size() << " textures in one "
+                  << sync_us / 1000.0 << "ms frame";
+    }
+
+    jobs::JobSystem system(0U);
+    for (size_t budget : {256UL * 1024UL, 1024UL * 1024UL, 4UL * 1024UL * 1024UL}) {
+        std::vector<std::shared_ptr<gfx::Texture>> textures{};
+        double longest_us = 0.0;
+        size_t frames = 0UL;
+        gfx::TextureLoadStats stats{};
+        auto total_us = measure([&]() {
+            gfx::TextureLoader loader(&system, budget);
+            for (size_t i = 0; i < copies; i++)
+                for (const auto &file : files)
+                    textures.push_back(loader.load(file));
+            while (!loader.idle()) {
+                longest_us = std::max(longest_us, measure([&]() {
+                                          loader.update();
+                                          glFinish();
+                                      }));
+                frames++;
+            }
+            stats = loader.getStats();
+        });
+        for (const auto &texture : textures)
+            if (!texture->isLoaded())
+                LOG(WARNING) << "[texture_upload] " << texture->getPath() << " did not load";
+
+        LOG(INFO) << "[texture_upload] " << budget / 1024 << "KB per frame: " << stats.loaded << " textures in "
+                  << total_us / 1000.0 << "ms over " << frames << " frames (" << stats.frames
+                  << " uploading), longest frame " << longest_us / 1000.0 << "ms, at most "
+                  << stats.max_frame_bytes / 1024 << "KB per frame (" << stats.oversized << " over budget)";
+    }
+
+    {
+        constexpr size_t memory_budget = 4UL * 1024UL * 1024UL;
+        constexpr size_t frames = 120;
+        gfx::TextureLoader loader(&system, gfx::DEFAULT_TEXTURE_UPLOAD_BUDGET, memory_budget);
+        std::vector<std::shared_ptr<gfx::Texture>> textures{};
+        for (size_t i = 0; i < copies; i++)
+            for (const auto &file : files)
+                textures.push_back(loader.load(file));
+
+        // Every texture drawn close up, then only the first half of them
+        for (size_t drawn : {textures.size(), textures.size() / 2}) {
+            double longest_us = 0.0;
+            for (size_t frame = 0; frame < frames; frame++) {
+                for (size_t i = 0; i < drawn; i++)
+                    textures[i]->request(std::numeric_limits<float>::infinity());
+                longest_us = std::max(longest_us, measure([&]() {
+                                          loader.update();
+                                          glFinish();
+                                      }));
+            }
+            auto stats = loader.getStats();
+            LOG(INFO) << "[texture_upload] streaming " << drawn << "/" << textures.size() << " textures drawn: "
+                      << stats.resident_bytes / 1024 << "KB resident of " << memory_budget / 1024 << "KB, "
+                      << stats.streamed_in << " levels streamed in, " << stats.evicted << " evicted, longest frame "
+                      << longest_us / 1000.0 << "ms";
+        }
+    }
+
+    destroy_hidden_context(window);
+}
+
+}  // namespace goat::bench
@@ -0,0 +1,74 @@
+#include "bench.hpp"
+
+#include <GLFW/glfw3.h>
+#include <easylogging++.h>
+
+#include <functional>
+#include <map>
+
+#include "gfx/GLState.hpp"
+
+namespace goat::bench {
+
+static const std::map<std::string, std::function<void()>> BENCHMARKS = {
+    {"bvh", bvh},
+    {"command_buffer", command_buffer},
+    {"frustum_cull", frustum_cull},
+    {"jobs", jobs},
+    {"lod", lod},
+    {"mesh_optimize", mesh_optimize},
+    {"occlusion", occlusion},
+    {"offset_allocator", offset_allocator},
+    {"render_queue", render_queue},
+    {"render_thread", render_thread},
+    {"static_batch", static_batch},
+    {"texture_upload", texture_upload},
+    {"vbo_update", vbo_update},
+    {"vertex_quantize", vertex_quantize},
+};
+
+bool run(const std::string &name) {
+    auto it = BENCHMARKS.find(name);
+    if (it == BENCHMARKS.end())
+        return false;
+
+    LOG(INFO) << "[bench] running '" << name << "'";
+    auto duration = measure(it->second);
+    LOG(INFO) << "[bench] '" << name << "' finished in " << static_cast<long>(duration / 1000.0) << "ms";
+    return true;
+}
+
+void list() {
+    for (const auto &[name, _] : BENCHMARKS)
+        LOG(INFO) << "[bench] " << name;
+}
+
+GLFWwindow *create_hidden_context(const char *title) {
+    if (!glfwInit())
+        return nullptr;
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    auto window = glfwCreateWindow(64, 64, title, nullptr, nullptr);
+    if (window == nullptr) {
+        glfwTerminate();
+        return nullptr;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGL(glfwGetProcAddress)) {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return nullptr;
+    }
+    return window;
+}
+
+void destroy_hidden_context(GLFWwindow *window) {
+    gfx::GLState::get().invalidate();
+    glfwDestroyWindow(window);
+    glfwTerminate();
+}
+
+}  // namespace goat::bench
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+struct GLFWwindow;
+
+namespace goat::bench {
+
+/**
+ * @brief Run a headless benchmark by name (see `--bench` in main.cpp). Benchmarks mostly exercise CPU-side code
+ *        and do not need a window; the few timing OpenGL calls open a hidden one and skip those parts without it.
+ * @return false if there is no benchmark with that name
+ */
+bool run(const std::string &name);
+
+// Log the name of every registered benchmark
+void list();
+
+/**
+ * @brief Run a function `iterations` times and return the average wall time of one run in microseconds
+ */
+template <typename F>
+double measure(F &&fn, size_t iterations = 1) {
+    auto startTime = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < iterations; i++)
+        fn();
+    auto endTime = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime);
+    return static_cast<double>(duration.count()) / 1000.0 / static_cast<double>(iterations);
+}
+
+/**
+ * @brief Open a hidden window with an OpenGL 3.3 core context, make it current and load the GL functions, for the
+ *        benchmarks timing OpenGL calls
+ * @return nullptr when there is no display or driver
+ */
+GLFWwindow *create_hidden_context(const char *title);
+
+// Destroy a window made by `create_hidden_context`, forgetting the GL state cached for its context
+void destroy_hidden_context(GLFWwindow *window);
+
+// Benchmarks
+void render_queue();
+void mesh_optimize();
+void vertex_quantize();
+void frustum_cull();
+void bvh();
+void occlusion();
+void lod();
+void static_batch();
+void offset_allocator();
+void vbo_update();
+void jobs();
+void render_thread();
+void command_buffer();
+void texture_upload();
+
+}  // namespace goat::bench
@@ -0,0 +1,16 @@
+#include "CommandBuffer.hpp"
+
+#include <algorithm>
+
+namespace goat::gfx {
+
+void CommandBuffer::reserve(size_t bytes) {
+    if (this->head + bytes <= this->data.size())
+        return;
+    auto size = std::max(this->data.size() * 2, DEFAULT_COMMAND_BUFFER_SIZE);
+    while (size < this->head + bytes)
+        size *= 2;
+    this->data.resize(size);
+}
+
+}  // namespace goat::gfx
@@ -0,0 +1,197 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include "../constants.hpp"
+#include "gfx/constants.hpp"
+
+namespace goat::gfx {
+
+class RenderContext;
+class VBO;
+
+// Every command (and the data stored after it) starts at a multiple of this, enough for the inline matrices
+static constexpr size_t COMMAND_ALIGNMENT = 16UL;
+// The bytes a command buffer reserves the first time it is written to
+static constexpr size_t DEFAULT_COMMAND_BUFFER_SIZE = 64UL * 1024UL;
+
+static_assert(__STDCPP_DEFAULT_NEW_ALIGNMENT__ >= COMMAND_ALIGNMENT, "command storage must be aligned by new");
+
+enum class CommandType : uint32_t {
+    SET_PASS,
+    USE_CONTEXT,
+    USE_VBO,
+    BIND_TEXTURE,
+    SET_MATRIX4,
+    SET_UINT,
+    DRAW,
+    DRAW_INSTANCED,
+};
+
+// Every command starts with its type and its size in bytes, including the data stored after it
+struct CommandHeader {
+    CommandType type;
+    uint32_t size;
+};
+
+namespace cmd {
+
+// Switch the blending and depth state to a render pass (depth writes stay off after a depth prepass)
+struct SetPass {
+    static constexpr CommandType TYPE = CommandType::SET_PASS;
+    CommandHeader header;
+    RenderPass pass;
+    bool prepassed;
+};
+
+// Use the program and textures of a render context
+struct UseContext {
+    static constexpr CommandType TYPE = CommandType::USE_CONTEXT;
+    CommandHeader header;
+    const RenderContext *context;
+};
+
+// Bind the vertex array of a VBO
+struct UseVBO {
+    static constexpr CommandType TYPE = CommandType::USE_VBO;
+    CommandHeader header;
+    const VBO *vbo;
+};
+
+struct BindTexture {
+    static constexpr CommandType TYPE = CommandType::BIND_TEXTURE;
+    CommandHeader header;
+    uint unit;
+    uint target;
+    uint handle;
+};
+
+// Set a 4x4 matrix uniform of the program in use
+struct SetMatrix4 {
+    static constexpr CommandType TYPE = CommandType::SET_MATRIX4;
+    CommandHeader header;
+    int location;
+    mat4 value;
+};
+
+// Set an unsigned integer uniform of the program in use
+struct SetUInt {
+    static constexpr CommandType TYPE = CommandType::SET_UINT;
+    CommandHeader header;
+    int location;
+    uint value;
+};
+
+struct Draw {
+    static constexpr CommandType TYPE = CommandType::DRAW;
+    CommandHeader header;
+    const VBO *vbo;
+};
+
+// Upload the per-instance data stored after the command (`count` model matrices, then `count` texture array
+// layers when `layers` is set) and draw that many instances
+struct DrawInstanced {
+    static constexpr CommandType TYPE = CommandType::DRAW_INSTANCED;
+    CommandHeader header;
+    VBO *vbo;
+    uint32_t count;
+    bool layers;
+
+    // The bytes stored after the command for `count` instances
+    static size_t payload(size_t count, bool layers) {
+        return count * sizeof(mat4) + (layers ? count * sizeof(uint) : 0UL);
+    }
+    mat4 *models() {
+        return reinterpret_cast<mat4 *>(reinterpret_cast<uint8_t *>(this) + PAYLOAD_OFFSET);
+    }
+    const mat4 *models() const {
+        return reinterpret_cast<const mat4 *>(reinterpret_cast<const uint8_t *>(this) + PAYLOAD_OFFSET);
+    }
+    uint *instanceLayers() {
+        return this->layers ? reinterpret_cast<uint *>(this->models() + this->count) : nullptr;
+    }
+    const uint *instanceLayers() const {
+        return this->layers ? reinterpret_cast<const uint *>(this->models() + this->count) : nullptr;
+    }
+    // Where the instance data starts: the command's size rounded up to the alignment (checked below)
+    static constexpr size_t PAYLOAD_OFFSET = 32UL;
+};
+
+static_assert(((sizeof(DrawInstanced) + COMMAND_ALIGNMENT - 1) & ~(COMMAND_ALIGNMENT - 1)) ==
+                  DrawInstanced::PAYLOAD_OFFSET,
+              "the instance data starts at the aligned end of the command");
+
+}  // namespace cmd
+
+/**
+ * @brief A list of draw commands recorded into linear memory, to be replayed later by a graphics backend (see
+ *        `replay`). Recording never calls into the graphics API, so threads can each record a slice of a frame
+ *        into their own buffer while the thread owning the context replays the finished buffers in order.
+ *        Commands are plain structs that only refer to what they use; it must outlive the replay.
+ */
+class CommandBuffer {
+    std::vector<uint8_t> data{};
+    // The bytes written and the number of commands
+    size_t head = 0UL;
+    size_t count = 0UL;
+
+    // Make room for `bytes` more bytes, doubling the storage (capacity is kept across `clear`)
+    void reserve(size_t bytes);
+
+   public:
+    // Append a command followed by `extra` bytes of data, returning it to be filled in
+    template <typename T>
+    T &push(size_t extra = 0UL) {
+        static_assert(std::is_trivially_copyable<T>::value, "commands must be plain data");
+        static_assert(alignof(T) <= COMMAND_ALIGNMENT);
+        auto size = (sizeof(T) + COMMAND_ALIGNMENT - 1) & ~(COMMAND_ALIGNMENT - 1);
+        size = (size + extra + COMMAND_ALIGNMENT - 1) & ~(COMMAND_ALIGNMENT - 1);
+        this->reserve(size);
+        auto command = new (&this->data[this->head]) T{};
+        command->header = CommandHeader{.type = T::TYPE, .size = static_cast<uint32_t>(size)};
+        this->head += size;
+        this->count++;
+        return *command;
+    }
+
+    // Call `fn` with the header of every command, in recording order
+    template <typename F>
+    void visit(F &&fn) const {
+        for (size_t offset = 0; offset < this->head;) {
+            auto header = reinterpret_cast<const CommandHeader *>(&this->data[offset]);
+            fn(*header);
+            offset += header->size;
+        }
+    }
+
+    void clear() {
+        this->head = 0UL;
+        this->count = 0UL;
+    }
+
+    bool empty() const {
+        return this->count == 0;
+    }
+
+    // Returns the number of commands recorded
+    size_t size() const {
+        return this->count;
+    }
+
+    // Returns the bytes taken by the recorded commands
+    size_t bytes() const {
+        return this->head;
+    }
+};
+
+// Return the command a header belongs to
+template <typename T>
+const T &command_cast(const CommandHeader &header) {
+    assert(header.type == T::TYPE);
+    return *reinterpret_cast<const T *>(&header);
+}
+
+}  // namespace goat::gfx
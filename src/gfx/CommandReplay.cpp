@@ -0,0 +1,75 @@
+#include "CommandReplay.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "gfx/GLState.hpp"
+#include "gfx/RenderContext.hpp"
+#include "gfx/VBO.hpp"
+
+namespace goat::gfx {
+
+size_t replay(const CommandBuffer &buffer, StreamBuffer *stream) {
+    auto &state = GLState::get();
+    size_t draw_calls = 0UL;
+    buffer.visit([&](const CommandHeader &header) {
+        switch (header.type) {
+            case CommandType::SET_PASS: {
+                const auto &command = command_cast<cmd::SetPass>(header);
+                // Everything after the solid pass is blended over it without writing depth
+                bool blended = command.pass != RenderPass::SOLID;
+                state.setEnabled(GL_BLEND, blended);
+                glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+                glDepthMask(blended || command.prepassed ? GL_FALSE : GL_TRUE);
+                // Blended draws were not prepassed, so they test against the solid depth as usual
+                if (command.prepassed && blended)
+                    glDepthFunc(GL_LESS);
+                break;
+            }
+            case CommandType::USE_CONTEXT:
+                command_cast<cmd::UseContext>(header).context->use();
+                break;
+            case CommandType::USE_VBO:
+                command_cast<cmd::UseVBO>(header).vbo->use();
+                break;
+            case CommandType::BIND_TEXTURE: {
+                const auto &command = command_cast<cmd::BindTexture>(header);
+                state.bindTexture(command.unit, command.target, command.handle);
+                break;
+            }
+            case CommandType::SET_MATRIX4: {
+                const auto &command = command_cast<cmd::SetMatrix4>(header);
+                glUniformMatrix4fv(command.location, 1, GL_FALSE, glm::value_ptr(command.value));
+                break;
+            }
+            case CommandType::SET_UINT: {
+                const auto &command = command_cast<cmd::SetUInt>(header);
+                glUniform1ui(command.location, command.value);
+                break;
+            }
+            case CommandType::DRAW:
+                command_cast<cmd::Draw>(header).vbo->draw();
+                ++draw_calls;
+                break;
+            case CommandType::DRAW_INSTANCED: {
+                const auto &command = command_cast<cmd::DrawInstanced>(header);
+                auto vbo = command.vbo;
+                if (!vbo->isInstanced())
+                    vbo->enableInstancing();
+                if (stream != nullptr)
+                    vbo->uploadInstances(*stream, command.models(), command.instanceLayers(), command.count);
+                else
+                    vbo->uploadInstances(command.models(), command.instanceLayers(), command.count);
+                vbo->drawInstanced(command.count);
+                ++draw_calls;
+                break;
+            }
+        }
+    });
+#ifdef __DEBUG__
+    LOG(DEBUG) << "replay(" << buffer.size() << " commands, " << buffer.bytes() << " bytes) " << draw_calls
+               << " draw calls";
+#endif
+    return draw_calls;
+}
+
+}  // namespace goat::gfx
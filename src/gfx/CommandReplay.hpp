@@ -0,0 +1,16 @@
+#pragma once
+
+#include "gfx/CommandBuffer.hpp"
+#include "gfx/StreamBuffer.hpp"
+
+namespace goat::gfx {
+
+/**
+ * @brief Replay a command buffer through OpenGL, from the thread owning the context. Bindings go through
+ *        `GLState`, so the ones a buffer repeats from the buffer replayed before it are skipped.
+ * @param stream The stream buffer instance data is written to (uploaded to each VBO's instance buffers when null)
+ * @return The number of draw calls issued
+ */
+size_t replay(const CommandBuffer &buffer, StreamBuffer *stream = nullptr);
+
+}  // namespace goat::gfx
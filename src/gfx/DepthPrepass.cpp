@@ -0,0 +1,93 @@
+#include "DepthPrepass.hpp"
+
+#include <easylogging++.h>
+
+#include <glm/gtc/type_ptr.hpp>
+#include <sstream>
+
+#include "gfx/GLState.hpp"
+#include "gfx/Shader.hpp"
+#include "gfx/constants.hpp"
+
+namespace goat::gfx {
+
+namespace {
+
+// Compile and link a vertex and fragment shader, binding the program to the shared frame uniform block
+GLuint link_program(const std::string &vertex_path, const std::string &fragment_path) {
+    Shader vertex(vertex_path, ShaderType::VERTEX);
+    Shader fragment(fragment_path, ShaderType::FRAGMENT);
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertex.getHandle());
+    glAttachShader(program, fragment.getHandle());
+    glLinkProgram(program);
+    glDetachShader(program, vertex.getHandle());
+    glDetachShader(program, fragment.getHandle());
+
+    int success{};
+    char infoLog[512]{};
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        glGetProgramInfoLog(program, 512, nullptr, infoLog);
+        glDeleteProgram(program);
+        std::stringstream err;
+        err << "Failed to link depth program '" << vertex_path << "': " << infoLog;
+        LOG(ERROR) << err.str();
+        throw std::runtime_error(err.str());
+    }
+
+    GLuint frame_block = glGetUniformBlockIndex(program, FRAME_UNIFORM_BLOCK);
+    if (frame_block != GL_INVALID_INDEX)
+        glUniformBlockBinding(program, frame_block, FRAME_UNIFORM_BINDING);
+    return program;
+}
+
+}  // namespace
+
+DepthPrepass::DepthPrepass(const std::string &vertex_shader, const std::string &instanced_shader,
+                           const std::string &fragment_shader) {
+    this->program = link_program(vertex_shader, fragment_shader);
+    this->instanced_program = link_program(instanced_shader, fragment_shader);
+    this->model_uniform = glGetUniformLocation(this->program, "model");
+    LOG(INFO) << "Created depth prepass programs " << this->program << " and " << this->instanced_program;
+}
+
+DepthPrepass::~DepthPrepass() {
+    auto &state = GLState::get();
+    for (auto handle : {this->program, this->instanced_program}) {
+        if (handle == 0)
+            continue;
+        state.forgetProgram(handle);
+        glDeleteProgram(handle);
+    }
+}
+
+void DepthPrepass::use(bool instanced) const {
+    GLState::get().useProgram(instanced ? this->instanced_program : this->program);
+}
+
+void DepthPrepass::setModel(const mat4 &model) const {
+    glUniformMatrix4fv(this->model_uniform, 1, GL_FALSE, glm::value_ptr(model));
+}
+
+void DepthPrepass::begin() const {
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_TRUE);
+    glDepthFunc(GL_LESS);
+}
+
+void DepthPrepass::end() const {
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
+
+void DepthPrepass::shade(GLenum depth_func) const {
+    glDepthMask(GL_FALSE);
+    glDepthFunc(depth_func);
+}
+
+void DepthPrepass::restore() const {
+    glDepthMask(GL_TRUE);
+    glDepthFunc(GL_LESS);
+}
+
+}  // namespace goat::gfx
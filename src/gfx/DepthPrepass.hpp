@@ -0,0 +1,56 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <string>
+
+#include "../constants.hpp"
+
+namespace goat::gfx {
+
+/**
+ * @brief The position-only programs of a depth prepass: one taking the model matrix as a uniform, one reading
+ *        it from the per-instance attribute (see `VBO::enableInstancing`). Both read the view projection from the
+ *        shared `FrameData` block and write no color, so the prepass only fetches positions (through
+ *        `VBO::useDepth`) and runs an empty fragment shader.
+ *
+ * @note The vertex shaders declare `invariant gl_Position`, as must the shaders of the shading pass for its
+ *       GL_EQUAL depth test to pass.
+ */
+class DepthPrepass {
+   private:
+    GLuint program = 0U;
+    GLuint instanced_program = 0U;
+    GLint model_uniform = -1;
+
+   public:
+    DepthPrepass(const std::string &vertex_shader = "shaders/depth.vert",
+                 const std::string &instanced_shader = "shaders/depth_instanced.vert",
+                 const std::string &fragment_shader = "shaders/depth.frag");
+    DepthPrepass(const DepthPrepass &) = delete;
+    ~DepthPrepass();
+
+    DepthPrepass &operator=(const DepthPrepass &) = delete;
+
+    // Use the per-object or the instanced program
+    void use(bool instanced) const;
+
+    // Set the model matrix of the per-object program (which must be in use)
+    void setModel(const mat4 &model) const;
+
+    // Start the prepass: mask color writes off and write depth with GL_LESS
+    void begin() const;
+    // End the prepass, turning color writes back on (draws not in the prepass can follow with the default state)
+    void end() const;
+
+    /**
+     * @brief Set up the shading pass of the prepassed draws: depth writes off and the depth test set to
+     *        `depth_func` (GL_EQUAL, or GL_LEQUAL when the shaders are not invariant).
+     */
+    void shade(GLenum depth_func = GL_EQUAL) const;
+
+    // Restore the default depth state (GL_LESS with depth writes) after the shading pass
+    void restore() const;
+};
+
+}  // namespace goat::gfx
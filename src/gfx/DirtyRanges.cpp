@@ -0,0 +1,38 @@
+#include "DirtyRanges.hpp"
+
+#include <algorithm>
+
+namespace goat::gfx {
+
+void DirtyRanges::add(size_t offset, size_t size) {
+    if (size == 0)
+        return;
+    auto end = offset + size;
+    auto gap = this->merge_gap;
+
+    // The ranges are disjoint, so their ends are sorted too: find the first one close enough to reach `offset`
+    auto first = std::lower_bound(this->ranges.begin(), this->ranges.end(), offset,
+                                  [gap](const ByteRange &range, size_t value) { return range.end() + gap < value; });
+    auto last = first;
+    while (last != this->ranges.end() && last->offset <= end + gap) {
+        offset = std::min(offset, last->offset);
+        end = std::max(end, last->end());
+        ++last;
+    }
+
+    if (first == last) {
+        this->ranges.insert(first, ByteRange{.offset = offset, .size = end - offset});
+        return;
+    }
+    *first = ByteRange{.offset = offset, .size = end - offset};
+    this->ranges.erase(first + 1, last);
+}
+
+size_t DirtyRanges::bytes() const {
+    size_t total = 0UL;
+    for (const auto &range : this->ranges)
+        total += range.size;
+    return total;
+}
+
+}  // namespace goat::gfx
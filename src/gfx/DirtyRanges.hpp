@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace goat::gfx {
+
+// Ranges closer than this many bytes are merged: one larger upload is cheaper than several calls
+static constexpr size_t DEFAULT_DIRTY_MERGE_GAP = 1024UL;
+
+struct ByteRange {
+    size_t offset = 0UL;
+    size_t size = 0UL;
+
+    size_t end() const {
+        return this->offset + this->size;
+    }
+};
+
+/**
+ * @brief The byte ranges of a buffer changed since its last upload, kept sorted and disjoint. Ranges that
+ *        overlap, touch, or are less than `merge_gap` bytes apart are merged as they are added, so a mesh
+ *        deformed vertex by vertex is uploaded in a few calls rather than one per vertex.
+ */
+class DirtyRanges {
+   private:
+    std::vector<ByteRange> ranges{};
+    size_t merge_gap;
+
+   public:
+    DirtyRanges(size_t merge_gap = DEFAULT_DIRTY_MERGE_GAP) : merge_gap(merge_gap) {}
+
+    // Mark `size` bytes starting at `offset` as changed
+    void add(size_t offset, size_t size);
+
+    void clear() {
+        this->ranges.clear();
+    }
+
+    bool empty() const {
+        return this->ranges.empty();
+    }
+
+    // The total number of bytes covered by the ranges (including the merged gaps)
+    size_t bytes() const;
+
+    const std::vector<ByteRange> &get() const {
+        return this->ranges;
+    }
+};
+
+}  // namespace goat::gfx
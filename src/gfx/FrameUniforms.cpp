@@ -0,0 +1,63 @@
+#include "FrameUniforms.hpp"
+
+#include <easylogging++.h>
+
+#include "gfx/GLState.hpp"
+#include "gfx/constants.hpp"
+
+namespace goat::gfx {
+
+FrameUniformBuffer::FrameUniformBuffer() {
+    glGenBuffers(1, &this->ubo);
+    auto &state = GLState::get();
+    state.bindBuffer(GL_UNIFORM_BUFFER, this->ubo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), nullptr, GL_STREAM_DRAW);
+    state.bindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORM_BINDING, this->ubo);
+    GLint alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    if (alignment > 0)
+        this->range_alignment = static_cast<size_t>(alignment);
+    LOG(DEBUG) << "Created frame uniform buffer " << this->ubo << " at binding " << FRAME_UNIFORM_BINDING;
+}
+
+FrameUniformBuffer::~FrameUniformBuffer() {
+    if (this->ubo != 0) {
+        GLState::get().forgetBuffer(this->ubo);
+        glDeleteBuffers(1, &this->ubo);
+    }
+}
+
+/**
+ * @brief Fill the frame data from the camera and upload it in a single call. The previous contents are orphaned
+ *        first, so the upload never waits for draws of the last frame that still read from the buffer.
+ * @param camera The camera the frame is rendered from
+ * @param time Seconds since the window was created
+ * @param delta Seconds since the previous frame
+ * @param viewport The viewport rectangle (x, y, width, height)
+ * @param stream A stream buffer inside a frame: the data is written to it and its range bound to the block
+ *               instead (optional, the buffer is orphaned as above when the stream's frame is full)
+ */
+void FrameUniformBuffer::update(const world::Camera &camera, float time, float delta, vec4 viewport,
+                                StreamBuffer *stream) {
+    this->data.view = camera.view;
+    this->data.projection = camera.getProjectionMatrix();
+    this->data.view_projection = this->data.projection * this->data.view;
+    this->data.camera_pos = vec4(camera.pos, 1.0f);
+    this->data.time = vec4(time, delta, 0.0f, 0.0f);
+    this->data.viewport = viewport;
+
+    auto &state = GLState::get();
+    if (stream != nullptr) {
+        auto range = stream->write(&this->data, sizeof(FrameData), this->range_alignment);
+        if (range.valid()) {
+            state.bindBufferRange(GL_UNIFORM_BUFFER, FRAME_UNIFORM_BINDING, range.buffer, range.offset, range.size);
+            return;
+        }
+    }
+    state.bindBuffer(GL_UNIFORM_BUFFER, this->ubo);
+    state.bindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORM_BINDING, this->ubo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameData), &this->data);
+}
+
+}  // namespace goat::gfx
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include "../constants.hpp"
+#include "gfx/StreamBuffer.hpp"
+#include "world/Camera.hpp"
+
+namespace goat::gfx {
+
+/**
+ * @brief Per-frame shader data, laid out to match the std140 `FrameData` uniform block:
+ *
+ *     layout(std140) uniform FrameData {
+ *         mat4 view;
+ *         mat4 projection;
+ *         mat4 view_projection;
+ *         vec4 camera_pos;  // xyz = world position
+ *         vec4 time;        // x = seconds since start, y = frame delta
+ *         vec4 viewport;    // x, y, width, height
+ *     };
+ */
+struct FrameData {
+    mat4 view;
+    mat4 projection;
+    mat4 view_projection;
+    vec4 camera_pos;
+    vec4 time;
+    vec4 viewport;
+};
+static_assert(sizeof(FrameData) == 3 * 64 + 3 * 16, "FrameData must match the std140 layout of the shader block");
+
+/**
+ * @brief A uniform buffer holding `FrameData`, bound to `FRAME_UNIFORM_BINDING`. It is filled once per frame and
+ *        read by every shader program that declares the `FrameData` block, so camera matrices are not uploaded
+ *        again for each program.
+ */
+class FrameUniformBuffer {
+   private:
+    GLuint ubo = 0U;
+    FrameData data{};
+    // The offset alignment required of uniform buffer ranges (GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT)
+    size_t range_alignment = DEFAULT_STREAM_ALIGNMENT;
+
+   public:
+    FrameUniformBuffer();
+    FrameUniformBuffer(const FrameUniformBuffer &) = delete;
+    ~FrameUniformBuffer();
+
+    FrameUniformBuffer &operator=(const FrameUniformBuffer &) = delete;
+
+    // Recalculate the frame data from the camera and upload it (to a range of `stream` when given)
+    void update(const world::Camera &camera, float time, float delta, vec4 viewport, StreamBuffer *stream = nullptr);
+
+    // Return the data uploaded by the last call to `update`
+    const FrameData &getData() const {
+        return this->data;
+    }
+};
+
+}  // namespace goat::gfx
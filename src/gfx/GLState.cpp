@@ -0,0 +1,193 @@
+#include "GLState.hpp"
+
+#include <easylogging++.h>
+
+namespace goat::gfx {
+
+GLState &GLState::get() {
+    static GLState state;
+    return state;
+}
+
+void GLState::useProgram(GLuint program) {
+    if (this->program == program) {
+        ++this->stats.skipped;
+        return;
+    }
+    this->program = program;
+    ++this->stats.issued;
+    glUseProgram(program);
+#ifdef __DEBUG__
+    LOG(DEBUG) << " glUseProgram(" << program << ")";
+#endif
+}
+
+void GLState::bindVertexArray(GLuint vao) {
+    if (this->vao == vao) {
+        ++this->stats.skipped;
+        return;
+    }
+    this->vao = vao;
+    ++this->stats.issued;
+    glBindVertexArray(vao);
+#ifdef __DEBUG__
+    LOG(DEBUG) << " glBindVertexArray(" << vao << ")";
+#endif
+
+    // The element buffer binding is part of the VAO state
+    this->buffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+}
+
+void GLState::bindBuffer(GLenum target, GLuint buffer) {
+    auto it = this->buffers.find(target);
+    if (it != this->buffers.end() && it->second == buffer) {
+        ++this->stats.skipped;
+        return;
+    }
+    this->buffers[target] = buffer;
+    ++this->stats.issued;
+    glBindBuffer(target, buffer);
+#ifdef __DEBUG__
+    LOG(DEBUG) << " glBindBuffer(" << target << ", " << buffer << ")";
+#endif
+}
+
+void GLState::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+    auto key = (static_cast<uint64_t>(target) << 32) | index;
+    auto it = this->indexed_buffers.find(key);
+    if (it != this->indexed_buffers.end() && it->second == buffer) {
+        ++this->stats.skipped;
+        return;
+    }
+    this->indexed_buffers[key] = buffer;
+    this->buffers[target] = buffer;
+    ++this->stats.issued;
+    glBindBufferBase(target, index, buffer);
+#ifdef __DEBUG__
+    LOG(DEBUG) << " glBindBufferBase(" << target << ", " << index << ", " << buffer << ")";
+#endif
+}
+
+void GLState::bindBufferRange(GLenum target, GLuint index, GLuint buffer, size_t offset, size_t size) {
+    // The cache only knows whole buffers, so the next glBindBufferBase at this point must go through
+    auto key = (static_cast<uint64_t>(target) << 32) | index;
+    this->indexed_buffers[key] = UNKNOWN;
+    this->buffers[target] = buffer;
+    ++this->stats.issued;
+    glBindBufferRange(target, index, buffer, offset, size);
+#ifdef __DEBUG__
+    LOG(DEBUG) << " glBindBufferRange(" << target << ", " << index << ", " << buffer << ", " << offset << ", " << size
+               << ")";
+#endif
+}
+
+void GLState::activeTexture(uint unit) {
+    if (this->active_unit == unit) {
+        ++this->stats.skipped;
+        return;
+    }
+    this->active_unit = unit;
+    ++this->stats.issued;
+    glActiveTexture(static_cast<GLenum>(GL_TEXTURE0 + unit));
+#ifdef __DEBUG__
+    LOG(DEBUG) << " glActiveTexture(GL_TEXTURE" << unit << ")";
+#endif
+}
+
+void GLState::bindTexture(GLenum target, GLuint texture) {
+    // Binding before any unit was selected must not be cached against the wrong unit
+    if (this->active_unit == UNKNOWN) {
+        glBindTexture(target, texture);
+        ++this->stats.issued;
+        return;
+    }
+
+    if (this->active_unit >= this->textures.size())
+        this->textures.resize(this->active_unit + 1);
+
+    auto &binding = this->textures[this->active_unit];
+    if (binding.target == target && binding.handle == texture) {
+        ++this->stats.skipped;
+        return;
+    }
+    binding = TextureBinding{.target = target, .handle = texture};
+    ++this->stats.issued;
+    glBindTexture(target, texture);
+#ifdef __DEBUG__
+    LOG(DEBUG) << " glBindTexture(" << target << ", " << texture << ") unit=" << this->active_unit;
+#endif
+}
+
+void GLState::bindTexture(uint unit, GLenum target, GLuint texture) {
+    // Check the unit binding first, so an unchanged texture does not cost a glActiveTexture either
+    if (unit < this->textures.size()) {
+        auto &binding = this->textures[unit];
+        if (binding.target == target && binding.handle == texture) {
+            ++this->stats.skipped;
+            return;
+        }
+    }
+    this->activeTexture(unit);
+    this->bindTexture(target, texture);
+}
+
+void GLState::setEnabled(GLenum feature, bool enable) {
+    auto it = this->features.find(feature);
+    if (it != this->features.end() && it->second == enable) {
+        ++this->stats.skipped;
+        return;
+    }
+    this->features[feature] = enable;
+    ++this->stats.issued;
+    if (enable)
+        glEnable(feature);
+    else
+        glDisable(feature);
+#ifdef __DEBUG__
+    LOG(DEBUG) << (enable ? " glEnable(" : " glDisable(") << feature << ")";
+#endif
+}
+
+void GLState::forgetProgram(GLuint program) {
+    if (this->program == program)
+        this->program = UNKNOWN;
+}
+
+void GLState::forgetVertexArray(GLuint vao) {
+    if (this->vao == vao)
+        this->vao = UNKNOWN;
+}
+
+void GLState::forgetBuffer(GLuint buffer) {
+    for (auto it = this->buffers.begin(); it != this->buffers.end();) {
+        if (it->second == buffer)
+            it = this->buffers.erase(it);
+        else
+            ++it;
+    }
+    for (auto it = this->indexed_buffers.begin(); it != this->indexed_buffers.end();) {
+        if (it->second == buffer)
+            it = this->indexed_buffers.erase(it);
+        else
+            ++it;
+    }
+}
+
+void GLState::forgetTexture(GLuint texture) {
+    for (auto &binding : this->textures) {
+        if (binding.handle == texture)
+            binding = TextureBinding{};
+    }
+}
+
+void GLState::invalidate() {
+    this->program = UNKNOWN;
+    this->vao = UNKNOWN;
+    this->active_unit = UNKNOWN;
+    this->buffers.clear();
+    this->indexed_buffers.clear();
+    this->textures.clear();
+    this->features.clear();
+}
+
+}  // namespace goat::gfx
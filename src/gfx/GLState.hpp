@@ -0,0 +1,97 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <unordered_map>
+#include <vector>
+
+#include "../constants.hpp"
+
+namespace goat::gfx {
+
+// Counters for the state changes routed through `GLState`
+struct GLStateStats {
+    // Calls that changed state and were forwarded to OpenGL
+    size_t issued = 0UL;
+    // Calls that would not have changed state and were dropped
+    size_t skipped = 0UL;
+};
+
+/**
+ * @brief A shadow copy of the OpenGL binding state (program, VAO, buffers, texture units and capabilities).
+ *        Every bind in the engine goes through this class so that calls which would not change the current
+ *        state never reach the driver.
+ *
+ * @note The cache is only correct as long as nothing binds objects behind its back. ImGui's OpenGL backend
+ *       restores the state it touches after rendering, so it is safe; anything else must call `invalidate()`.
+ */
+class GLState {
+   private:
+    // Marks a binding whose value is not known, so the next call always goes through
+    static constexpr GLuint UNKNOWN = ~0U;
+
+    struct TextureBinding {
+        GLenum target = 0U;
+        GLuint handle = UNKNOWN;
+    };
+
+    GLuint program = UNKNOWN;
+    GLuint vao = UNKNOWN;
+    uint active_unit = UNKNOWN;
+    // Bound buffer per target (e.g. GL_ARRAY_BUFFER)
+    std::unordered_map<GLenum, GLuint> buffers;
+    // Bound buffer per indexed binding point, keyed by (target << 32 | index)
+    std::unordered_map<uint64_t, GLuint> indexed_buffers;
+    // Bound texture per texture unit
+    std::vector<TextureBinding> textures;
+    // Enabled state per capability (e.g. GL_DEPTH_TEST)
+    std::unordered_map<GLenum, bool> features;
+    GLStateStats stats;
+
+    GLState() = default;
+
+   public:
+    GLState(const GLState &) = delete;
+    GLState &operator=(const GLState &) = delete;
+
+    // Return the state cache of the (single) OpenGL context
+    static GLState &get();
+
+    // Bind a shader program (glUseProgram)
+    void useProgram(GLuint program);
+    // Bind a vertex array object (glBindVertexArray)
+    void bindVertexArray(GLuint vao);
+    // Bind a buffer to a target (glBindBuffer)
+    void bindBuffer(GLenum target, GLuint buffer);
+    // Bind a buffer to an indexed binding point, which also binds it to the generic target (glBindBufferBase)
+    void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+    // Bind a range of a buffer to an indexed binding point (glBindBufferRange, never skipped as ranges move often)
+    void bindBufferRange(GLenum target, GLuint index, GLuint buffer, size_t offset, size_t size);
+    // Select the active texture unit (glActiveTexture)
+    void activeTexture(uint unit);
+    // Bind a texture to the active texture unit (glBindTexture)
+    void bindTexture(GLenum target, GLuint texture);
+    // Bind a texture to a given texture unit
+    void bindTexture(uint unit, GLenum target, GLuint texture);
+    // Enable or disable a capability (glEnable/glDisable)
+    void setEnabled(GLenum feature, bool enable);
+
+    // Drop cached bindings of deleted objects, so that a recycled handle is bound again
+    void forgetProgram(GLuint program);
+    void forgetVertexArray(GLuint vao);
+    void forgetBuffer(GLuint buffer);
+    void forgetTexture(GLuint texture);
+
+    // Forget all cached state, forcing the next call of every kind through to OpenGL
+    void invalidate();
+
+    const GLStateStats &getStats() const {
+        return this->stats;
+    }
+
+    void resetStats() {
+        this->stats = GLStateStats{};
+    }
+};
+
+}  // namespace goat::gfx
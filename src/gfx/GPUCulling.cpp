@@ -0,0 +1,208 @@
+#include "GPUCulling.hpp"
+
+#include <easylogging++.h>
+
+#include <algorithm>
+#include <bit>
+#include <glm/gtc/type_ptr.hpp>
+#include <sstream>
+
+#include "gfx/GLState.hpp"
+#include "gfx/Shader.hpp"
+#include "world/Bounds.hpp"
+
+namespace goat::gfx {
+
+namespace {
+
+// Compile and link a program made of a single compute shader
+GLuint link_compute(const std::string &path) {
+    Shader shader(path, ShaderType::COMPUTE);
+    GLuint program = glCreateProgram();
+    glAttachShader(program, shader.getHandle());
+    glLinkProgram(program);
+    glDetachShader(program, shader.getHandle());
+
+    int success{};
+    char infoLog[512]{};
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        glGetProgramInfoLog(program, 512, nullptr, infoLog);
+        glDeleteProgram(program);
+        std::stringstream err;
+        err << "Failed to link compute program '" << path << "': " << infoLog;
+        LOG(ERROR) << err.str();
+        throw std::runtime_error(err.str());
+    }
+    return program;
+}
+
+// Upload data to a buffer, growing it when needed and orphaning its previous storage otherwise
+void stream(GLenum target, GLuint buffer, size_t &capacity, const void *data, size_t bytes) {
+    GLState::get().bindBuffer(target, buffer);
+    if (bytes > capacity) {
+        glBufferData(target, bytes, data, GL_STREAM_DRAW);
+        capacity = bytes;
+    } else {
+        glBufferData(target, capacity, nullptr, GL_STREAM_DRAW);
+        if (data != nullptr)
+            glBufferSubData(target, 0, bytes, data);
+    }
+}
+
+}  // namespace
+
+GPUCuller::GPUCuller(const std::string &cull_shader, const std::string &pyramid_shader) {
+    if (!GPUCuller::supported())
+        throw std::runtime_error("GPU culling requires OpenGL 4.3 (compute shaders and multi-draw-indirect)");
+
+    this->cull_program = link_compute(cull_shader);
+    this->pyramid_program = link_compute(pyramid_shader);
+    this->count_uniform = glGetUniformLocation(this->cull_program, "instance_count");
+    this->planes_uniform = glGetUniformLocation(this->cull_program, "frustum_planes");
+    this->pyramid_enabled_uniform = glGetUniformLocation(this->cull_program, "pyramid_enabled");
+    this->pyramid_matrix_uniform = glGetUniformLocation(this->cull_program, "pyramid_view_projection");
+    this->source_level_uniform = glGetUniformLocation(this->pyramid_program, "source_level");
+
+    // Both programs sample from texture unit 0, which is only bound while they run
+    auto &state = GLState::get();
+    state.useProgram(this->cull_program);
+    glUniform1i(glGetUniformLocation(this->cull_program, "pyramid"), 0);
+    state.useProgram(this->pyramid_program);
+    glUniform1i(glGetUniformLocation(this->pyramid_program, "source"), 0);
+
+    glGenBuffers(1, &this->instance_buffer);
+    glGenBuffers(1, &this->command_buffer);
+    LOG(INFO) << "GPU culling enabled (" << cull_shader << ", " << pyramid_shader << ")";
+}
+
+GPUCuller::~GPUCuller() {
+    auto &state = GLState::get();
+    for (auto program : {this->cull_program, this->pyramid_program}) {
+        if (program == 0)
+            continue;
+        state.forgetProgram(program);
+        glDeleteProgram(program);
+    }
+    for (auto buffer : {this->instance_buffer, this->command_buffer}) {
+        if (buffer == 0)
+            continue;
+        state.forgetBuffer(buffer);
+        glDeleteBuffers(1, &buffer);
+    }
+    for (auto texture : {this->depth_texture, this->pyramid_texture}) {
+        if (texture == 0)
+            continue;
+        state.forgetTexture(texture);
+        glDeleteTextures(1, &texture);
+    }
+}
+
+bool GPUCuller::supported() {
+    return GLAD_GL_VERSION_4_3 != 0;
+}
+
+void GPUCuller::cull(const std::vector<GPUInstance> &instances, const mat4 &view_projection) {
+    if (instances.empty())
+        return;
+
+    auto &state = GLState::get();
+    stream(GL_SHADER_STORAGE_BUFFER, this->instance_buffer, this->instance_capacity, instances.data(),
+           instances.size() * sizeof(GPUInstance));
+    stream(GL_SHADER_STORAGE_BUFFER, this->command_buffer, this->command_capacity, nullptr,
+           instances.size() * sizeof(DrawElementsIndirectCommand));
+
+    auto frustum = world::Frustum::fromMatrix(view_projection);
+    bool pyramid = this->occlusion && this->pyramid_valid;
+    state.useProgram(this->cull_program);
+    glUniform1ui(this->count_uniform, static_cast<GLuint>(instances.size()));
+    glUniform4fv(this->planes_uniform, world::Frustum::PLANE_COUNT, glm::value_ptr(frustum.planes[0]));
+    glUniform1i(this->pyramid_enabled_uniform, pyramid ? 1 : 0);
+    glUniformMatrix4fv(this->pyramid_matrix_uniform, 1, GL_FALSE, glm::value_ptr(this->pyramid_view_projection));
+    if (pyramid)
+        state.bindTexture(0, GL_TEXTURE_2D, this->pyramid_texture);
+
+    state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, CULL_INSTANCE_BINDING, this->instance_buffer);
+    state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, CULL_COMMAND_BINDING, this->command_buffer);
+    auto groups = static_cast<GLuint>((instances.size() + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE);
+    glDispatchCompute(groups, 1, 1);
+    // The commands are written through a storage buffer, and read back as indirect draws
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+#ifdef __DEBUG__
+    LOG(DEBUG) << " glDispatchCompute(" << groups << ", 1, 1) culling " << instances.size() << " instances"
+               << (pyramid ? " (frustum + depth pyramid)" : " (frustum)");
+#endif
+}
+
+void GPUCuller::draw(const VBO &vbo, size_t first, size_t count) const {
+    GLState::get().bindBuffer(GL_DRAW_INDIRECT_BUFFER, this->command_buffer);
+    vbo.drawIndirect(first, count);
+}
+
+void GPUCuller::resize(uint width, uint height) {
+    auto &state = GLState::get();
+    for (auto texture : {&this->depth_texture, &this->pyramid_texture}) {
+        if (*texture == 0)
+            continue;
+        state.forgetTexture(*texture);
+        glDeleteTextures(1, texture);
+        *texture = 0U;
+    }
+
+    this->depth_width = width;
+    this->depth_height = height;
+    auto pyramid_width = std::max(width / 2, 1U), pyramid_height = std::max(height / 2, 1U);
+    this->pyramid_levels = static_cast<uint>(std::bit_width(std::max(pyramid_width, pyramid_height)));
+
+    glGenTextures(1, &this->depth_texture);
+    state.bindTexture(0, GL_TEXTURE_2D, this->depth_texture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT24, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glGenTextures(1, &this->pyramid_texture);
+    state.bindTexture(0, GL_TEXTURE_2D, this->pyramid_texture);
+    glTexStorage2D(GL_TEXTURE_2D, this->pyramid_levels, GL_R32F, pyramid_width, pyramid_height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    LOG(INFO) << "Created a " << pyramid_width << "x" << pyramid_height << " depth pyramid (" << this->pyramid_levels
+              << " levels)";
+}
+
+/**
+ * @brief Copy the depth buffer into a texture, then reduce it level by level: each texel of a level holds the
+ *        farthest depth of the 2x2 texels under it (3 wide at odd edges), so one texel bounds the depth of the
+ *        whole area it covers.
+ */
+void GPUCuller::buildDepthPyramid(const mat4 &view_projection) {
+    GLint viewport[4]{};
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    auto width = static_cast<uint>(std::max(viewport[2], 1)), height = static_cast<uint>(std::max(viewport[3], 1));
+    if (width != this->depth_width || height != this->depth_height)
+        this->resize(width, height);
+
+    auto &state = GLState::get();
+    state.bindTexture(0, GL_TEXTURE_2D, this->depth_texture);
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, viewport[0], viewport[1], width, height);
+
+    state.useProgram(this->pyramid_program);
+    auto level_width = std::max(width / 2, 1U), level_height = std::max(height / 2, 1U);
+    for (uint level = 0; level < this->pyramid_levels; level++) {
+        // Level 0 reads the depth copy, every other level the one above it in the pyramid
+        state.bindTexture(0, GL_TEXTURE_2D, level == 0 ? this->depth_texture : this->pyramid_texture);
+        glUniform1i(this->source_level_uniform, level == 0 ? 0 : static_cast<GLint>(level - 1));
+        glBindImageTexture(0, this->pyramid_texture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        glDispatchCompute((level_width + 7) / 8, (level_height + 7) / 8, 1);
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+        level_width = std::max(level_width / 2, 1U);
+        level_height = std::max(level_height / 2, 1U);
+    }
+
+    this->pyramid_view_projection = view_projection;
+    this->pyramid_valid = true;
+}
+
+}  // namespace goat::gfx
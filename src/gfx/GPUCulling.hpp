@@ -0,0 +1,93 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <string>
+#include <vector>
+
+#include "../constants.hpp"
+#include "gfx/VBO.hpp"
+
+namespace goat::gfx {
+
+/**
+ * @brief One instance tested by the culling shader, laid out to match its std430 `Instance` struct. Each one
+ *        becomes the draw command at the same index, drawing a single instance (or none once culled).
+ */
+struct GPUInstance {
+    // xyz = world-space center of the bounds, w = 0 for unbounded instances (which are never culled)
+    vec4 center;
+    vec4 extents;
+    // The indexed draw to issue when the instance is visible
+    uint index_count;
+    uint first_index;
+    int base_vertex;
+    // The index of the instance's per-instance attributes (e.g. its model matrix)
+    uint base_instance;
+};
+static_assert(sizeof(GPUInstance) == 48, "GPUInstance must match the std430 layout of the shader struct");
+
+/**
+ * @brief Culls instances on the GPU for OpenGL 4.3+ targets. A compute shader tests the bounds held in a shader
+ *        storage buffer against the view frustum and a depth pyramid of the previous frame (Hi-Z), and writes one
+ *        `DrawElementsIndirectCommand` per instance, so everything is submitted with a single
+ *        glMultiDrawElementsIndirect per VBO whatever the number of visible instances.
+ *
+ * @note Culled instances keep their command with an instance count of 0: glMultiDrawElementsIndirectCount
+ *       (OpenGL 4.6) would let the shader compact them, but it is not part of the loaded GL API.
+ */
+class GPUCuller {
+   private:
+    GLuint cull_program = 0U;
+    GLuint pyramid_program = 0U;
+    // Instance bounds read by the culling shader, and the draw commands it writes
+    GLuint instance_buffer = 0U;
+    size_t instance_capacity = 0UL;
+    GLuint command_buffer = 0U;
+    size_t command_capacity = 0UL;
+    // A copy of the last frame's depth buffer, and the pyramid of its farthest depths (half its size at level 0)
+    GLuint depth_texture = 0U;
+    GLuint pyramid_texture = 0U;
+    uint depth_width = 0U, depth_height = 0U;
+    uint pyramid_levels = 0U;
+    // The view projection the pyramid was rendered with (instances are projected with it to test against it)
+    mat4 pyramid_view_projection = mat4(1.0f);
+    bool pyramid_valid = false;
+    // Uniform locations of the culling and pyramid programs
+    GLint count_uniform = -1, planes_uniform = -1, pyramid_enabled_uniform = -1, pyramid_matrix_uniform = -1;
+    GLint source_level_uniform = -1;
+
+    // (Re-)create the depth copy and the pyramid for a new viewport size
+    void resize(uint width, uint height);
+
+   public:
+    // Test instances against the depth pyramid after the frustum (only the frustum is tested when false)
+    bool occlusion = true;
+
+    GPUCuller(const std::string &cull_shader = "shaders/cull.comp",
+              const std::string &pyramid_shader = "shaders/depth_pyramid.comp");
+    GPUCuller(const GPUCuller &) = delete;
+    ~GPUCuller();
+
+    GPUCuller &operator=(const GPUCuller &) = delete;
+
+    // Returns true if the current context supports compute shaders and multi-draw-indirect (OpenGL 4.3)
+    static bool supported();
+
+    /**
+     * @brief Upload the instances and dispatch the culling shader, filling the command buffer with one draw
+     *        per instance. Commands are ready to draw once this returns (a command barrier is issued).
+     */
+    void cull(const std::vector<GPUInstance> &instances, const mat4 &view_projection);
+
+    // Draw `count` commands starting at `first` with the VBO (its instance attributes must be uploaded)
+    void draw(const VBO &vbo, size_t first, size_t count) const;
+
+    /**
+     * @brief Copy the depth buffer of the frame rendered with `view_projection` and build its depth pyramid, for
+     *        the next frame's occlusion tests. Call it once every instance has been drawn.
+     */
+    void buildDepthPyramid(const mat4 &view_projection);
+};
+
+}  // namespace goat::gfx
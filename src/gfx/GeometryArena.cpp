@@ -0,0 +1,330 @@
+#include "GeometryArena.hpp"
+
+#include <easylogging++.h>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+#include "gfx/GLState.hpp"
+
+namespace goat::gfx {
+
+namespace {
+
+bool same_format(const std::vector<VAOBound> &a, const std::vector<VAOBound> &b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const VAOBound &x, const VAOBound &y) {
+        return x.index == y.index && x.data_size == y.data_size && x.entries == y.entries && x.type == y.type &&
+               x.normalized == y.normalized;
+    });
+}
+
+// Create a buffer of `bytes` bytes without data
+GLuint create_buffer(size_t bytes) {
+    GLuint buffer = 0U;
+    glGenBuffers(1, &buffer);
+    GLState::get().bindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, bytes, nullptr, GL_STATIC_DRAW);
+    return buffer;
+}
+
+void delete_buffer(GLuint buffer) {
+    GLState::get().forgetBuffer(buffer);
+    glDeleteBuffers(1, &buffer);
+}
+
+// Room for `size` units in a new allocator: requests are rounded up to their size class, so an allocator of exactly
+// `size` units can fail to allocate `size` (a free region is only searched in classes that fit any request size)
+uint32_t size_class_capacity(uint32_t size) {
+    return OffsetAllocator::binSize(OffsetAllocator::binRoundUp(size));
+}
+
+/**
+ * @brief Allocate ranges of the given sizes back to back from a new allocator of at least `capacity` units. The
+ *        capacity grows by about one size class until every range fits, as the exact total is not always enough.
+ * @param ranges Set to the allocation of each size
+ */
+OffsetAllocator pack(const std::vector<uint32_t> &sizes, uint32_t capacity, std::vector<OffsetAllocation> &ranges) {
+    while (true) {
+        OffsetAllocator allocator(capacity);
+        ranges.clear();
+        for (auto size : sizes) {
+            auto range = allocator.allocate(size);
+            if (!range.valid())
+                break;
+            ranges.push_back(range);
+        }
+        if (ranges.size() == sizes.size())
+            return allocator;
+        auto growth = std::max(capacity / 8U, 1U);
+        if (capacity > std::numeric_limits<uint32_t>::max() - growth)
+            throw std::runtime_error("Geometry arena pool is too large to compact");
+        capacity += growth;
+    }
+}
+
+}  // namespace
+
+GeometryArena::GeometryArena(uint32_t pool_vertices, uint32_t pool_indices)
+    : pool_vertices(pool_vertices), pool_indices(pool_indices) {}
+
+GeometryArena::~GeometryArena() {
+    auto &state = GLState::get();
+    for (const auto &pool : this->pools) {
+        state.forgetVertexArray(pool->vao);
+        glDeleteVertexArrays(1, &pool->vao);
+        delete_buffer(pool->vertex_buffer);
+        delete_buffer(pool->index_buffer);
+    }
+}
+
+GeometryArena::Pool &GeometryArena::createPool(const std::vector<VAOBound> &format, size_t stride, uint32_t vertices,
+                                               uint32_t indices) {
+    vertices = std::max(size_class_capacity(vertices), this->pool_vertices);
+    indices = std::max(size_class_capacity(indices), this->pool_indices);
+    auto pool = std::make_unique<Pool>(Pool{
+        .format = format,
+        .stride = stride,
+        .vertices = OffsetAllocator(vertices),
+        .indices = OffsetAllocator(indices),
+    });
+    glGenVertexArrays(1, &pool->vao);
+    pool->vertex_buffer = create_buffer(vertices * stride);
+    pool->index_buffer = create_buffer(indices * sizeof(uint));
+    this->bindAttributes(*pool);
+
+    LOG(INFO) << "[arena] created pool " << this->pools.size() << " (" << vertices << " vertices of " << stride
+              << " bytes, " << indices << " indices)";
+    this->pools.push_back(std::move(pool));
+    return *this->pools.back();
+}
+
+void GeometryArena::bindAttributes(Pool &pool) const {
+    auto &state = GLState::get();
+    state.bindVertexArray(pool.vao);
+    state.bindBuffer(GL_ARRAY_BUFFER, pool.vertex_buffer);
+    state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, pool.index_buffer);
+    size_t offset{};
+    for (const auto &bound : pool.format) {
+        auto normalized = bound.normalized ? GL_TRUE : GL_FALSE;
+        glVertexAttribPointer(bound.index, bound.entries, (GLenum)bound.type, normalized, pool.stride, (void *)offset);
+        glEnableVertexAttribArray(bound.index);
+        offset += bound.bytes();
+    }
+}
+
+GeometryHandle GeometryArena::add(const std::vector<VAOBound> &format, const void *vertices, uint32_t vertex_count,
+                                  const std::vector<uint> &indices) {
+    if (format.empty() || vertex_count == 0 || indices.empty())
+        throw std::runtime_error("Cannot add a mesh without vertices or indices to the geometry arena");
+    auto stride = std::accumulate(format.begin(), format.end(), static_cast<size_t>(0UL),
+                                  [](size_t acc, const VAOBound &bound) { return acc + bound.bytes(); });
+    auto index_count = static_cast<uint32_t>(indices.size());
+
+    Entry entry{.vertex_count = vertex_count, .index_count = index_count, .live = true};
+    Pool *pool = nullptr;
+    for (uint32_t i = 0; i < this->pools.size() && pool == nullptr; i++) {
+        auto &candidate = *this->pools[i];
+        if (!same_format(candidate.format, format))
+            continue;
+        auto vertex_range = candidate.vertices.allocate(vertex_count);
+        if (!vertex_range.valid())
+            continue;
+        auto index_range = candidate.indices.allocate(index_count);
+        if (!index_range.valid()) {
+            candidate.vertices.free(vertex_range);
+            continue;
+        }
+        pool = &candidate;
+        entry.pool = i;
+        entry.vertices = vertex_range;
+        entry.indices = index_range;
+    }
+    if (pool == nullptr) {
+        entry.pool = static_cast<uint32_t>(this->pools.size());
+        pool = &this->createPool(format, stride, vertex_count, index_count);
+        entry.vertices = pool->vertices.allocate(vertex_count);
+        entry.indices = pool->indices.allocate(index_count);
+        if (!entry.vertices.valid() || !entry.indices.valid())
+            throw std::runtime_error("Geometry arena pool has no room for the mesh it was created for");
+    }
+
+    auto &state = GLState::get();
+    state.bindBuffer(GL_COPY_WRITE_BUFFER, pool->vertex_buffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, entry.vertices.offset * pool->stride, vertex_count * pool->stride, vertices);
+    state.bindBuffer(GL_COPY_WRITE_BUFFER, pool->index_buffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, entry.indices.offset * sizeof(uint), index_count * sizeof(uint),
+                    indices.data());
+
+    GeometryHandle handle;
+    if (!this->free_handles.empty()) {
+        handle = this->free_handles.back();
+        this->free_handles.pop_back();
+        this->entries[handle] = entry;
+    } else {
+        handle = static_cast<GeometryHandle>(this->entries.size());
+        this->entries.push_back(entry);
+    }
+#ifdef __DEBUG__
+    LOG(DEBUG) << "[arena] added mesh " << handle << " to pool " << entry.pool << " (vertices "
+               << entry.vertices.offset << "+" << vertex_count << ", indices " << entry.indices.offset << "+"
+               << index_count << ")";
+#endif
+    return handle;
+}
+
+void GeometryArena::remove(GeometryHandle handle) {
+    if (handle >= this->entries.size() || !this->entries[handle].live)
+        throw std::runtime_error("Invalid geometry arena handle");
+    auto &entry = this->entries[handle];
+    auto &pool = *this->pools[entry.pool];
+    pool.vertices.free(entry.vertices);
+    pool.indices.free(entry.indices);
+    entry = Entry{};
+    this->free_handles.push_back(handle);
+}
+
+GeometryRange GeometryArena::range(GeometryHandle handle) const {
+    if (handle >= this->entries.size() || !this->entries[handle].live)
+        throw std::runtime_error("Invalid geometry arena handle");
+    const auto &entry = this->entries[handle];
+    return GeometryRange{
+        .pool = entry.pool,
+        .base_vertex = static_cast<int32_t>(entry.vertices.offset),
+        .first_index = entry.indices.offset,
+        .index_count = entry.index_count,
+        .vertex_count = entry.vertex_count,
+    };
+}
+
+void GeometryArena::bind(uint32_t pool) const {
+    GLState::get().bindVertexArray(this->pools[pool]->vao);
+}
+
+void GeometryArena::draw(GeometryHandle handle) const {
+    auto range = this->range(handle);
+    this->bind(range.pool);
+    auto offset = (void *)(static_cast<size_t>(range.first_index) * sizeof(uint));
+    glDrawElementsBaseVertex(GL_TRIANGLES, range.index_count, GL_UNSIGNED_INT, offset, range.base_vertex);
+#ifdef __DEBUG__
+    LOG(DEBUG) << " glDrawElementsBaseVertex(GL_TRIANGLES, " << range.index_count << ", GL_UNSIGNED_INT, " << offset
+               << ", " << range.base_vertex << ")";
+#endif
+}
+
+size_t GeometryArena::draw(const std::vector<GeometryHandle> &handles) const {
+    size_t draw_calls = 0UL;
+    for (size_t i = 0; i < handles.size();) {
+        auto pool = this->range(handles[i]).pool;
+        this->draw_counts.clear();
+        this->draw_offsets.clear();
+        this->draw_base_vertices.clear();
+        for (; i < handles.size(); i++) {
+            auto range = this->range(handles[i]);
+            if (range.pool != pool)
+                break;
+            this->draw_counts.push_back(static_cast<GLsizei>(range.index_count));
+            this->draw_offsets.push_back((const void *)(static_cast<size_t>(range.first_index) * sizeof(uint)));
+            this->draw_base_vertices.push_back(range.base_vertex);
+        }
+
+        this->bind(pool);
+        glMultiDrawElementsBaseVertex(GL_TRIANGLES, this->draw_counts.data(), GL_UNSIGNED_INT,
+                                      this->draw_offsets.data(), static_cast<GLsizei>(this->draw_counts.size()),
+                                      this->draw_base_vertices.data());
+#ifdef __DEBUG__
+        LOG(DEBUG) << " glMultiDrawElementsBaseVertex(GL_TRIANGLES, ..., GL_UNSIGNED_INT, ..., "
+                   << this->draw_counts.size() << ", ...) from pool " << pool;
+#endif
+        ++draw_calls;
+    }
+    return draw_calls;
+}
+
+/**
+ * @brief Reallocate the meshes of a pool in the order of their current offsets, so each range is placed right after
+ *        the previous one. Vertices and indices are packed independently into new allocators (grown if rounding
+ *        keeps them from fitting), then copied from the old buffers to new ones with glCopyBufferSubData. The pool
+ *        only switches to the new allocators and buffers once every range has been moved.
+ */
+void GeometryArena::compact(uint32_t index) {
+    auto &pool = *this->pools[index];
+    std::vector<Entry *> by_vertex;
+    for (auto &entry : this->entries)
+        if (entry.live && entry.pool == index)
+            by_vertex.push_back(&entry);
+    auto by_index = by_vertex;
+    std::sort(by_vertex.begin(), by_vertex.end(),
+              [](auto a, auto b) { return a->vertices.offset < b->vertices.offset; });
+    std::sort(by_index.begin(), by_index.end(), [](auto a, auto b) { return a->indices.offset < b->indices.offset; });
+
+    std::vector<uint32_t> sizes;
+    std::vector<OffsetAllocation> vertex_ranges, index_ranges;
+    for (const auto *entry : by_vertex)
+        sizes.push_back(entry->vertex_count);
+    auto vertices = pack(sizes, pool.vertices.capacity(), vertex_ranges);
+    sizes.clear();
+    for (const auto *entry : by_index)
+        sizes.push_back(entry->index_count);
+    auto indices = pack(sizes, pool.indices.capacity(), index_ranges);
+
+    auto &state = GLState::get();
+    auto vertex_buffer = create_buffer(static_cast<size_t>(vertices.capacity()) * pool.stride);
+    auto index_buffer = create_buffer(static_cast<size_t>(indices.capacity()) * sizeof(uint));
+
+    state.bindBuffer(GL_COPY_READ_BUFFER, pool.vertex_buffer);
+    state.bindBuffer(GL_COPY_WRITE_BUFFER, vertex_buffer);
+    for (size_t i = 0; i < by_vertex.size(); i++) {
+        auto *entry = by_vertex[i];
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, entry->vertices.offset * pool.stride,
+                            vertex_ranges[i].offset * pool.stride, entry->vertex_count * pool.stride);
+        entry->vertices = vertex_ranges[i];
+    }
+
+    state.bindBuffer(GL_COPY_READ_BUFFER, pool.index_buffer);
+    state.bindBuffer(GL_COPY_WRITE_BUFFER, index_buffer);
+    for (size_t i = 0; i < by_index.size(); i++) {
+        auto *entry = by_index[i];
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, entry->indices.offset * sizeof(uint),
+                            index_ranges[i].offset * sizeof(uint), entry->index_count * sizeof(uint));
+        entry->indices = index_ranges[i];
+    }
+
+    if (vertices.capacity() != pool.vertices.capacity() || indices.capacity() != pool.indices.capacity())
+        LOG(INFO) << "[arena] grew pool " << index << " to " << vertices.capacity() << " vertices and "
+                  << indices.capacity() << " indices to pack its meshes";
+    delete_buffer(pool.vertex_buffer);
+    delete_buffer(pool.index_buffer);
+    pool.vertex_buffer = vertex_buffer;
+    pool.index_buffer = index_buffer;
+    pool.vertices = std::move(vertices);
+    pool.indices = std::move(indices);
+    this->bindAttributes(pool);
+    LOG(INFO) << "[arena] compacted pool " << index << " (" << by_vertex.size() << " meshes)";
+}
+
+void GeometryArena::defragment() {
+    for (uint32_t i = 0; i < this->pools.size(); i++) {
+        // A pool whose free space is already a single range has nothing to gain
+        auto vertices = this->pools[i]->vertices.report(), indices = this->pools[i]->indices.report();
+        if (vertices.free_regions > 1 || indices.free_regions > 1)
+            this->compact(i);
+    }
+}
+
+GeometryArenaStats GeometryArena::getStats() const {
+    GeometryArenaStats stats{.pools = this->pools.size(), .meshes = this->entries.size() - this->free_handles.size()};
+    for (const auto &pool : this->pools) {
+        auto vertices = pool->vertices.report(), indices = pool->indices.report();
+        stats.used_vertices += pool->vertices.capacity() - vertices.total_free;
+        stats.free_vertices += vertices.total_free;
+        stats.used_indices += pool->indices.capacity() - indices.total_free;
+        stats.free_indices += indices.total_free;
+        stats.largest_vertices = std::max(stats.largest_vertices, static_cast<size_t>(vertices.largest_free));
+        stats.largest_indices = std::max(stats.largest_indices, static_cast<size_t>(indices.largest_free));
+    }
+    return stats;
+}
+
+}  // namespace goat::gfx
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <memory>
+#include <vector>
+
+#include "gfx/OffsetAllocator.hpp"
+#include "gfx/structs.hpp"
+
+namespace goat::gfx {
+
+// The vertices and indices of each buffer pair created by a `GeometryArena` (larger meshes get a pool of their own)
+static constexpr uint32_t DEFAULT_ARENA_VERTICES = 1U << 20;
+static constexpr uint32_t DEFAULT_ARENA_INDICES = 1U << 22;
+
+// A mesh stored in a `GeometryArena`
+using GeometryHandle = uint32_t;
+static constexpr GeometryHandle INVALID_GEOMETRY = 0xFFFFFFFFU;
+
+// Where a mesh lives in the arena: everything `glDrawElementsBaseVertex` needs to draw it
+struct GeometryRange {
+    // The buffer pair holding the mesh (meshes in the same pool share a VAO)
+    uint32_t pool = 0U;
+    int32_t base_vertex = 0;
+    uint32_t first_index = 0U;
+    uint32_t index_count = 0U;
+    uint32_t vertex_count = 0U;
+};
+
+struct GeometryArenaStats {
+    size_t pools = 0UL;
+    size_t meshes = 0UL;
+    size_t used_vertices = 0UL, free_vertices = 0UL;
+    size_t used_indices = 0UL, free_indices = 0UL;
+    // The most vertices/indices that can still be added to a single pool without defragmenting it
+    size_t largest_vertices = 0UL, largest_indices = 0UL;
+};
+
+/**
+ * @brief Stores many meshes in a few large vertex and index buffers, one pair (and one VAO) per vertex format.
+ *        Each mesh is a range of vertices and indices sub-allocated with an `OffsetAllocator`, and is drawn with
+ *        `glDrawElementsBaseVertex` (indices stay relative to the mesh). Meshes sharing a pool can be drawn
+ *        without switching VAOs or buffers, and many at once with `glMultiDrawElementsBaseVertex`. A `VBO` can
+ *        draw a single mesh of the arena (see its arena constructor).
+ *
+ * @note Indices are always 32-bit, as a pool holds far more than 65536 vertices.
+ */
+class GeometryArena {
+   private:
+    struct Pool {
+        std::vector<VAOBound> format;
+        size_t stride;
+        GLuint vao = 0U;
+        GLuint vertex_buffer = 0U;
+        GLuint index_buffer = 0U;
+        OffsetAllocator vertices;
+        OffsetAllocator indices;
+        // What the per-instance attributes of the VAO read from (see `VBO::enableInstancing`)
+        std::shared_ptr<InstanceSources> instance_sources = std::make_shared<InstanceSources>();
+    };
+
+    struct Entry {
+        uint32_t pool = 0U;
+        OffsetAllocation vertices{};
+        OffsetAllocation indices{};
+        uint32_t vertex_count = 0U;
+        uint32_t index_count = 0U;
+        bool live = false;
+    };
+
+    uint32_t pool_vertices;
+    uint32_t pool_indices;
+    std::vector<std::unique_ptr<Pool>> pools{};
+    std::vector<Entry> entries{};
+    std::vector<GeometryHandle> free_handles{};
+    // Scratch arrays for multi-draws (reused to avoid reallocating every frame)
+    mutable std::vector<GLsizei> draw_counts{};
+    mutable std::vector<const void *> draw_offsets{};
+    mutable std::vector<GLint> draw_base_vertices{};
+
+    // Create a pool for a vertex format, with room for at least the given number of vertices and indices
+    Pool &createPool(const std::vector<VAOBound> &format, size_t stride, uint32_t vertices, uint32_t indices);
+    // Point the pool's VAO at its current buffers
+    void bindAttributes(Pool &pool) const;
+    // Move every mesh of a pool to the start of new buffers
+    void compact(uint32_t pool);
+
+   public:
+    GeometryArena(uint32_t pool_vertices = DEFAULT_ARENA_VERTICES, uint32_t pool_indices = DEFAULT_ARENA_INDICES);
+    GeometryArena(const GeometryArena &) = delete;
+    ~GeometryArena();
+
+    GeometryArena &operator=(const GeometryArena &) = delete;
+
+    /**
+     * @brief Copy a mesh into the pool of its vertex format, creating a new pool when none has room for it
+     * @param format The attributes of each vertex, as registered on a `VBO` (see `mesh::quantize`)
+     * @param vertices `vertex_count` vertices laid out as described by `format`
+     */
+    GeometryHandle add(const std::vector<VAOBound> &format, const void *vertices, uint32_t vertex_count,
+                       const std::vector<uint> &indices);
+
+    // Free the ranges of a mesh (the handle may be reused by a later `add`)
+    void remove(GeometryHandle handle);
+
+    // Return the current location of a mesh (it changes when the arena is defragmented)
+    GeometryRange range(GeometryHandle handle) const;
+
+    // Bind the VAO of a pool
+    void bind(uint32_t pool) const;
+
+    // The VAO and buffers of a pool (the buffers are replaced when the pool is compacted, the VAO is not)
+    GLuint vertexArray(uint32_t pool) const {
+        return this->pools[pool]->vao;
+    }
+    GLuint vertexBuffer(uint32_t pool) const {
+        return this->pools[pool]->vertex_buffer;
+    }
+    GLuint indexBuffer(uint32_t pool) const {
+        return this->pools[pool]->index_buffer;
+    }
+
+    // The per-instance attribute sources of a pool's VAO, shared by the VBOs drawing from the pool
+    std::shared_ptr<InstanceSources> instanceSources(uint32_t pool) const {
+        return this->pools[pool]->instance_sources;
+    }
+
+    // Draw a single mesh
+    void draw(GeometryHandle handle) const;
+
+    /**
+     * @brief Draw many meshes, with one glMultiDrawElementsBaseVertex per run of meshes in the same pool (sort
+     *        the handles by `range().pool` to get one call per pool)
+     * @return The number of draw calls issued
+     */
+    size_t draw(const std::vector<GeometryHandle> &handles) const;
+
+    /**
+     * @brief Move the meshes of every fragmented pool back to back at the start of freshly allocated buffers
+     *        (copied on the GPU), so the free space of each pool is one contiguous range again. Handles stay
+     *        valid, but their ranges change.
+     */
+    void defragment();
+
+    GeometryArenaStats getStats() const;
+};
+
+}  // namespace goat::gfx
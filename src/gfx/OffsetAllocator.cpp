@@ -0,0 +1,230 @@
+#include "OffsetAllocator.hpp"
+
+#include <assert.h>
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+namespace goat::gfx {
+
+namespace {
+
+constexpr uint32_t MANTISSA_BITS = 3U;
+constexpr uint32_t MANTISSA_VALUE = 1U << MANTISSA_BITS;
+constexpr uint32_t MANTISSA_MASK = MANTISSA_VALUE - 1U;
+
+// The index of the lowest set bit of `mask` at or above `start` (32 if there is none)
+uint32_t lowest_bit_from(uint32_t mask, uint32_t start) {
+    if (start >= 32U)
+        return 32U;
+    return static_cast<uint32_t>(std::countr_zero(mask & (~0U << start)));
+}
+
+}  // namespace
+
+/**
+ * @brief Size classes are small floats: sizes under 8 map to themselves, larger ones keep their 3 bits after the
+ *        leading one as the mantissa, and the position of the leading one as the exponent. Each power of two is
+ *        thus split into 8 classes, which bounds the space wasted by a fit to 12.5%.
+ */
+uint32_t OffsetAllocator::binRoundDown(uint32_t size) {
+    if (size < MANTISSA_VALUE)
+        return size;
+    auto highest = 31U - static_cast<uint32_t>(std::countl_zero(size));
+    auto shift = highest - MANTISSA_BITS;
+    return ((shift + 1U) << MANTISSA_BITS) | ((size >> shift) & MANTISSA_MASK);
+}
+
+uint32_t OffsetAllocator::binRoundUp(uint32_t size) {
+    auto bin = OffsetAllocator::binRoundDown(size);
+    // Any bit below the mantissa means the size is over the smallest size of its class
+    if (size >= MANTISSA_VALUE) {
+        auto shift = 31U - static_cast<uint32_t>(std::countl_zero(size)) - MANTISSA_BITS;
+        if ((size & ((1U << shift) - 1U)) != 0)
+            bin++;
+    }
+    return bin;
+}
+
+uint32_t OffsetAllocator::binSize(uint32_t bin) {
+    auto exponent = bin >> MANTISSA_BITS;
+    auto mantissa = bin & MANTISSA_MASK;
+    if (exponent == 0)
+        return mantissa;
+    return (mantissa | MANTISSA_VALUE) << (exponent - 1U);
+}
+
+OffsetAllocator::OffsetAllocator(uint32_t size, uint32_t max_allocations)
+    : size(size), max_allocations(max_allocations) {
+    if (size == 0 || max_allocations == 0)
+        throw std::runtime_error("An offset allocator needs a size and room for at least one allocation");
+    this->reset();
+}
+
+void OffsetAllocator::reset() {
+    this->free_storage = 0U;
+    this->allocation_count = 0U;
+    this->used_top = 0U;
+    std::fill(std::begin(this->used_leaf), std::end(this->used_leaf), 0U);
+    std::fill(std::begin(this->bin_heads), std::end(this->bin_heads), NONE);
+
+    // One node per allocation, plus one per free region around them
+    auto node_count = 2U * this->max_allocations + 1U;
+    this->nodes.assign(node_count, Node{});
+    this->free_nodes.resize(node_count);
+    for (uint32_t i = 0; i < node_count; i++)
+        this->free_nodes[i] = node_count - i - 1U;
+    this->insertFree(0U, this->size);
+}
+
+uint32_t OffsetAllocator::insertFree(uint32_t offset, uint32_t size) {
+    // Regions are filed under the class they fully cover, so any region found for a rounded up request fits it
+    auto bin = OffsetAllocator::binRoundDown(size);
+    auto top = bin >> MANTISSA_BITS, leaf = bin & MANTISSA_MASK;
+    if (this->bin_heads[bin] == NONE) {
+        this->used_leaf[top] |= static_cast<uint8_t>(1U << leaf);
+        this->used_top |= 1U << top;
+    }
+
+    assert(!this->free_nodes.empty());
+    auto index = this->free_nodes.back();
+    this->free_nodes.pop_back();
+    auto head = this->bin_heads[bin];
+    this->nodes[index] = Node{.offset = offset, .size = size, .bin_next = head};
+    if (head != NONE)
+        this->nodes[head].bin_prev = index;
+    this->bin_heads[bin] = index;
+    this->free_storage += size;
+    return index;
+}
+
+void OffsetAllocator::removeFree(uint32_t index) {
+    auto &node = this->nodes[index];
+    if (node.bin_prev != NONE) {
+        this->nodes[node.bin_prev].bin_next = node.bin_next;
+        if (node.bin_next != NONE)
+            this->nodes[node.bin_next].bin_prev = node.bin_prev;
+    } else {
+        // The node heads its class: the class becomes empty with it
+        auto bin = OffsetAllocator::binRoundDown(node.size);
+        this->bin_heads[bin] = node.bin_next;
+        if (node.bin_next != NONE) {
+            this->nodes[node.bin_next].bin_prev = NONE;
+        } else {
+            auto top = bin >> MANTISSA_BITS, leaf = bin & MANTISSA_MASK;
+            this->used_leaf[top] &= static_cast<uint8_t>(~(1U << leaf));
+            if (this->used_leaf[top] == 0)
+                this->used_top &= ~(1U << top);
+        }
+    }
+    this->free_storage -= node.size;
+    this->free_nodes.push_back(index);
+}
+
+OffsetAllocation OffsetAllocator::allocate(uint32_t size) {
+    // Splitting a region may need a node for the remainder
+    if (size == 0 || this->allocation_count >= this->max_allocations || this->free_nodes.empty())
+        return OffsetAllocation{};
+
+    auto min_bin = OffsetAllocator::binRoundUp(size);
+    auto top = min_bin >> MANTISSA_BITS;
+    auto leaf = 32U;
+    if (top < TOP_BINS && (this->used_top & (1U << top)))
+        leaf = lowest_bit_from(this->used_leaf[top], min_bin & MANTISSA_MASK);
+    if (leaf >= BINS_PER_LEAF) {
+        top = lowest_bit_from(this->used_top, top + 1U);
+        if (top >= TOP_BINS)
+            return OffsetAllocation{};
+        leaf = static_cast<uint32_t>(std::countr_zero(static_cast<uint32_t>(this->used_leaf[top])));
+    }
+    auto bin = (top << MANTISSA_BITS) | leaf;
+
+    // Take the first region of the class, and give back what it has beyond the request
+    auto index = this->bin_heads[bin];
+    auto region_offset = this->nodes[index].offset, region_size = this->nodes[index].size;
+    auto neighbor_prev = this->nodes[index].neighbor_prev, neighbor_next = this->nodes[index].neighbor_next;
+    this->removeFree(index);
+    this->free_nodes.pop_back();
+    this->nodes[index] = Node{.offset = region_offset,
+                              .size = size,
+                              .neighbor_prev = neighbor_prev,
+                              .neighbor_next = neighbor_next,
+                              .used = true};
+
+    if (region_size > size) {
+        auto remainder = this->insertFree(region_offset + size, region_size - size);
+        this->nodes[remainder].neighbor_prev = index;
+        this->nodes[remainder].neighbor_next = neighbor_next;
+        if (neighbor_next != NONE)
+            this->nodes[neighbor_next].neighbor_prev = remainder;
+        this->nodes[index].neighbor_next = remainder;
+    }
+    this->allocation_count++;
+    return OffsetAllocation{.offset = region_offset, .node = index};
+}
+
+void OffsetAllocator::free(OffsetAllocation allocation) {
+    if (!allocation.valid())
+        return;
+    auto index = allocation.node;
+    assert(index < this->nodes.size() && this->nodes[index].used);
+
+    auto node = this->nodes[index];
+    auto offset = node.offset, size = node.size;
+    auto neighbor_prev = node.neighbor_prev, neighbor_next = node.neighbor_next;
+    // Merge with the free regions on either side
+    if (neighbor_prev != NONE && !this->nodes[neighbor_prev].used) {
+        const auto &prev = this->nodes[neighbor_prev];
+        offset = prev.offset;
+        size += prev.size;
+        auto before = prev.neighbor_prev;
+        this->removeFree(neighbor_prev);
+        neighbor_prev = before;
+    }
+    if (neighbor_next != NONE && !this->nodes[neighbor_next].used) {
+        const auto &next = this->nodes[neighbor_next];
+        size += next.size;
+        auto after = next.neighbor_next;
+        this->removeFree(neighbor_next);
+        neighbor_next = after;
+    }
+
+    this->nodes[index].used = false;
+    this->free_nodes.push_back(index);
+    this->allocation_count--;
+    auto merged = this->insertFree(offset, size);
+    this->nodes[merged].neighbor_prev = neighbor_prev;
+    this->nodes[merged].neighbor_next = neighbor_next;
+    if (neighbor_prev != NONE)
+        this->nodes[neighbor_prev].neighbor_next = merged;
+    if (neighbor_next != NONE)
+        this->nodes[neighbor_next].neighbor_prev = merged;
+}
+
+uint32_t OffsetAllocator::allocationSize(OffsetAllocation allocation) const {
+    if (!allocation.valid())
+        return 0U;
+    return this->nodes[allocation.node].size;
+}
+
+OffsetAllocatorReport OffsetAllocator::report() const {
+    OffsetAllocatorReport report{
+        .total_free = this->free_storage,
+        .largest_free = 0U,
+        .allocations = this->allocation_count,
+        .free_regions = 0U,
+    };
+    for (auto head : this->bin_heads)
+        for (auto index = head; index != NONE; index = this->nodes[index].bin_next)
+            report.free_regions++;
+    if (this->used_top != 0) {
+        // Every region in the highest class fits its smallest size
+        auto top = 31U - static_cast<uint32_t>(std::countl_zero(this->used_top));
+        auto leaf = 31U - static_cast<uint32_t>(std::countl_zero(static_cast<uint32_t>(this->used_leaf[top])));
+        report.largest_free = OffsetAllocator::binSize((top << MANTISSA_BITS) | leaf);
+    }
+    return report;
+}
+
+}  // namespace goat::gfx
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "../constants.hpp"
+
+namespace goat::gfx {
+
+// The default number of allocations (and free regions) an `OffsetAllocator` can track at once
+static constexpr uint32_t DEFAULT_MAX_ALLOCATIONS = 128U * 1024U;
+
+// A range handed out by an `OffsetAllocator`
+struct OffsetAllocation {
+    static constexpr uint32_t NO_SPACE = 0xFFFFFFFFU;
+
+    uint32_t offset = NO_SPACE;
+    // The allocator's internal node for the range, needed to free it
+    uint32_t node = NO_SPACE;
+
+    bool valid() const {
+        return this->offset != NO_SPACE;
+    }
+};
+
+// The free space left in an `OffsetAllocator`
+struct OffsetAllocatorReport {
+    uint32_t total_free = 0U;
+    // The largest allocation guaranteed to succeed (the smallest size of the largest non-empty size class)
+    uint32_t largest_free = 0U;
+    uint32_t allocations = 0U;
+    uint32_t free_regions = 0U;
+};
+
+/**
+ * @brief Sub-allocates ranges of a fixed size space (e.g. the vertices of a GL buffer) in O(1), without touching
+ *        the memory it manages. Free regions are kept in 256 size classes (two-level segregated fit, as in TLSF:
+ *        Masmano et al., 2004): a size is rounded to a float with a 3-bit mantissa, and two levels of bitmasks
+ *        find the smallest non-empty class that fits a request with two bit scans. Freed ranges are merged with
+ *        their free neighbours right away.
+ *
+ * @note Sizes and offsets are in whatever unit the caller picks (vertices, indices, bytes). Requests are rounded
+ *       up to the next size class when searching, so an allocation can fail while a slightly larger free region
+ *       exists in the same class; the largest allocation that always succeeds is reported by `report`.
+ */
+class OffsetAllocator {
+   private:
+    static constexpr uint32_t NONE = 0xFFFFFFFFU;
+    static constexpr uint32_t TOP_BINS = 32U;
+    static constexpr uint32_t BINS_PER_LEAF = 8U;
+    static constexpr uint32_t LEAF_BINS = TOP_BINS * BINS_PER_LEAF;
+
+    // A range of the space: either allocated, or free and linked into the list of its size class
+    struct Node {
+        uint32_t offset = 0U;
+        uint32_t size = 0U;
+        uint32_t bin_prev = NONE, bin_next = NONE;
+        // The ranges right before and after this one, to merge free neighbours
+        uint32_t neighbor_prev = NONE, neighbor_next = NONE;
+        bool used = false;
+    };
+
+    uint32_t size;
+    uint32_t max_allocations;
+    uint32_t free_storage = 0U;
+    uint32_t allocation_count = 0U;
+    // A bit per top-level class with any free region, then a bit per class within each top-level class
+    uint32_t used_top = 0U;
+    uint8_t used_leaf[TOP_BINS]{};
+    uint32_t bin_heads[LEAF_BINS]{};
+    std::vector<Node> nodes{};
+    // Unused node indices
+    std::vector<uint32_t> free_nodes{};
+
+    // Add a free region to the list of its size class, returning its node
+    uint32_t insertFree(uint32_t offset, uint32_t size);
+    // Remove a free region from the list of its size class and release its node
+    void removeFree(uint32_t node);
+
+   public:
+    OffsetAllocator(uint32_t size, uint32_t max_allocations = DEFAULT_MAX_ALLOCATIONS);
+
+    // Free every allocation at once
+    void reset();
+
+    // Allocate `size` contiguous units, returning an invalid allocation when no free region fits
+    OffsetAllocation allocate(uint32_t size);
+    void free(OffsetAllocation allocation);
+
+    // The size of an allocation (as requested)
+    uint32_t allocationSize(OffsetAllocation allocation) const;
+
+    uint32_t capacity() const {
+        return this->size;
+    }
+
+    OffsetAllocatorReport report() const;
+
+    // Round a size down/up to its size class, and return the smallest size of a class (exposed for benchmarks)
+    static uint32_t binRoundDown(uint32_t size);
+    static uint32_t binRoundUp(uint32_t size);
+    static uint32_t binSize(uint32_t bin);
+};
+
+}  // namespace goat::gfx
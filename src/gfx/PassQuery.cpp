@@ -0,0 +1,44 @@
+#include "PassQuery.hpp"
+
+#include <assert.h>
+
+namespace goat::gfx {
+
+PassQuery::~PassQuery() {
+    if (this->queries[0][0] != 0)
+        glDeleteQueries(QUERY_FRAMES * 2, &this->queries[0][0]);
+}
+
+void PassQuery::begin() {
+    assert(!this->active);
+    if (this->queries[0][0] == 0)
+        glGenQueries(QUERY_FRAMES * 2, &this->queries[0][0]);
+
+    // The slot was last used `QUERY_FRAMES` frames ago: its results are almost always available by now
+    auto slot = this->queries[this->frame];
+    if (this->pending[this->frame]) {
+        GLuint64 samples = 0, elapsed = 0;
+        glGetQueryObjectui64v(slot[0], GL_QUERY_RESULT, &samples);
+        glGetQueryObjectui64v(slot[1], GL_QUERY_RESULT, &elapsed);
+        this->result = PassQueryResult{
+            .samples = samples,
+            .gpu_ms = static_cast<double>(elapsed) / 1'000'000.0,
+            .valid = true,
+        };
+        this->pending[this->frame] = false;
+    }
+    glBeginQuery(GL_SAMPLES_PASSED, slot[0]);
+    glBeginQuery(GL_TIME_ELAPSED, slot[1]);
+    this->active = true;
+}
+
+void PassQuery::end() {
+    assert(this->active);
+    glEndQuery(GL_SAMPLES_PASSED);
+    glEndQuery(GL_TIME_ELAPSED);
+    this->pending[this->frame] = true;
+    this->frame = (this->frame + 1) % QUERY_FRAMES;
+    this->active = false;
+}
+
+}  // namespace goat::gfx
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <cstdint>
+
+#include "../constants.hpp"
+
+namespace goat::gfx {
+
+// The number of frames a pass query keeps in flight before reading a result back
+static constexpr uint QUERY_FRAMES = 3U;
+
+struct PassQueryResult {
+    // The samples that passed the depth test (each one ran the fragment shader)
+    uint64_t samples = 0UL;
+    // The GPU time spent in the pass
+    double gpu_ms = 0.0;
+    // False until a result has been read back
+    bool valid = false;
+};
+
+/**
+ * @brief Measures a render pass on the GPU with a GL_SAMPLES_PASSED and a GL_TIME_ELAPSED query. Queries are
+ *        cycled over `QUERY_FRAMES` frames and read back when their slot comes around again, so the result lags
+ *        a few frames behind but reading it never stalls the pipeline.
+ *
+ * @note Queries of the same type cannot nest: passes measured with different PassQuery objects must not overlap.
+ */
+class PassQuery {
+   private:
+    // A samples and a time query per frame
+    GLuint queries[QUERY_FRAMES][2]{};
+    bool pending[QUERY_FRAMES]{};
+    uint frame = 0U;
+    bool active = false;
+    PassQueryResult result{};
+
+   public:
+    PassQuery() = default;
+    PassQuery(const PassQuery &) = delete;
+    ~PassQuery();
+
+    PassQuery &operator=(const PassQuery &) = delete;
+
+    // Start measuring the pass (creating the queries on first use)
+    void begin();
+    void end();
+
+    // The result of the latest frame read back
+    const PassQueryResult &getResult() const {
+        return this->result;
+    }
+};
+
+}  // namespace goat::gfx
@@ -1,11 +1,16 @@
 #include "RenderContext.hpp"
 
+#include <algorithm>
+
+#include "gfx/TextureLoader.hpp"
+
 namespace goat::gfx {
 RenderContext::RenderContext() : uv_count(0U), program(glCreateProgram()), vbos({}), shaders({}), textures({}){};
 
 RenderContext::~RenderContext() {
     LOG(DEBUG) << "free(RenderContext<" << this << ">)";
     if (this->program) {
+        GLState::get().forgetProgram(this->program);
         glDeleteProgram(this->program);
     }
 }
@@ -48,13 +53,34 @@ void RenderContext::compile() {
         throw std::runtime_error(err.str());
     }
 
-    // (Re-)assign uniforms to textures
+    this->reflectUniforms();
+
+    // Attach the shared per-frame uniform block, if the program declares it
+    GLuint frame_block = glGetUniformBlockIndex(this->program, FRAME_UNIFORM_BLOCK);
+    if (frame_block != GL_INVALID_INDEX) {
+        glUniformBlockBinding(this->program, frame_block, FRAME_UNIFORM_BINDING);
+#ifdef __DEBUG__
+        LOG(DEBUG) << " glUniformBlockBinding(" << this->program << ", " << frame_block << ", " << FRAME_UNIFORM_BINDING
+                   << ")";
+#endif
+    }
+
+    this->model_uniform = this->findUniform("model");
+    this->layer_uniform = this->findUniform(TEXTURE_LAYER_UNIFORM);
+
+    // (Re-)assign uniforms to textures, which requires the program to be bound
+    GLState::get().useProgram(this->program);
+    auto array_uniform = this->findUniform(TEXTURE_ARRAY_UNIFORM);
+    if (array_uniform.valid())
+        this->setInt(array_uniform, static_cast<int>(TEXTURE_ARRAY_UNIT));
+    this->material_id = 0U;
     for (const auto &texture : this->textures) {
         auto uniform_name = texture->uniform_name;
 #ifdef __DEBUG__
         LOG(DEBUG) << "Setting uniform " << texture->uniform_name << " to texture #" << texture->index;
 #endif
         this->setInt(texture->uniform_name, texture->index);
+        this->material_id = this->material_id * 31U + texture->texture->getHandle();
     }
 
     // TODO: I'm sure this will cause problems later
@@ -92,6 +118,12 @@ void RenderContext::add(const std::shared_ptr<Shader> &shader) {
  */
 void RenderContext::add(const std::shared_ptr<Texture> &texture, const std::string uniform_name) {
     auto index = this->uv_count;
+    if (index >= TEXTURE_ARRAY_UNIT) {
+        std::stringstream err;
+        err << "Too many textures in RenderContext (texture unit " << TEXTURE_ARRAY_UNIT
+            << " is reserved for texture arrays)";
+        throw std::runtime_error(err.str());
+    }
     ++this->uv_count;
 
     for (auto uv : this->textures) {
@@ -118,9 +150,14 @@ void RenderContext::add(const std::shared_ptr<Texture> &texture, const std::stri
  *        Additionally, attach it to the `uniform_target` for each available vertex shader
  * @param path The path to the texture file
  * @param uniform_name The name of the texture uniform in the shader program
+ * @param loader The loader reading and uploading the texture in the background, which binds a placeholder until
+ *        it is done (loaded right away without one)
  */
-void RenderContext::loadTexture(std::string path, std::string uniform_name) {
-    this->add(std::make_shared<Texture>(path), uniform_name);
+void RenderContext::loadTexture(std::string path, std::string uniform_name, TextureLoader *loader) {
+    if (loader != nullptr)
+        this->add(loader->load(path), uniform_name);
+    else
+        this->add(std::make_shared<Texture>(path), uniform_name);
 }
 
 /**
@@ -133,60 +170,155 @@ void RenderContext::loadShader(std::string path, const ShaderType type) {
 }
 
 /**
- * @brief Return the address for a uniform property
+ * @brief Draw every VBO in the context once for each model matrix. The matrices are streamed into each VBO's
+ *        instance buffer, which is created on first use.
+ * @param models The model matrix of each instance to render
  */
-GLint RenderContext::getUniform(const std::string &name) const {
-    GLint idx = static_cast<GLint>(glGetUniformLocation(this->program, name.c_str()));
-    if (idx <= -1)
-        throw std::runtime_error("Uniform of name '" + name + "' was not found");
+void RenderContext::renderInstanced(const std::vector<mat4> &models) {
+    if (models.empty())
+        return;
+
 #ifdef __DEBUG__
-    LOG(DEBUG) << " glGetUniformLocation(" << this->program << ", \"" << name << "\") resolved to " << idx;
+    auto startTime = std::chrono::high_resolution_clock::now();
+#endif
+
+    for (const auto &vbo : this->vbos) {
+        if (!vbo->isInstanced())
+            vbo->enableInstancing();
+        vbo->use();
+        vbo->uploadInstances(models);
+        vbo->drawInstanced(models.size());
+    }
+
+#ifdef __DEBUG__
+    auto endTime = std::chrono::high_resolution_clock::now();
+    auto duration = duration_cast<std::chrono::microseconds>(endTime - startTime);
+    LOG(DEBUG) << "RenderContext::renderInstanced() took " << duration.count() << " μs (" << this->vbos.size()
+               << " VBOs, " << models.size() << " instances)";
 #endif
-    return idx;
+}
+
+/**
+ * @brief Query every active uniform of the linked program and cache its location, so that setting a uniform
+ *        never has to go through `glGetUniformLocation` again. Uniforms inside uniform blocks have no location
+ *        and are skipped.
+ */
+void RenderContext::reflectUniforms() {
+    GLint count{};
+    GLint max_length{};
+    glGetProgramiv(this->program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(this->program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+
+    this->uniforms.clear();
+    this->uniforms.reserve(count);
+    std::vector<GLchar> name_buffer(std::max(max_length, 1));
+    for (GLint i = 0; i < count; i++) {
+        GLsizei length{};
+        GLint size{};
+        GLenum type{};
+        glGetActiveUniform(this->program, static_cast<GLuint>(i), static_cast<GLsizei>(name_buffer.size()), &length,
+                           &size, &type, name_buffer.data());
+
+        std::string name(name_buffer.data(), length);
+        GLint location = glGetUniformLocation(this->program, name.c_str());
+        if (location <= -1)
+            continue;
+
+        // Arrays are reported as "name[0]", but are addressed by their base name
+        if (name.ends_with("[0]"))
+            name.resize(name.size() - 3);
+
+#ifdef __DEBUG__
+        LOG(DEBUG) << " uniform \"" << name << "\" location=" << location << " type=" << type << " size=" << size;
+#endif
+        this->uniforms.push_back(UniformInfo{.name = name, .location = location, .type = type, .size = size});
+    }
+
+    std::sort(this->uniforms.begin(), this->uniforms.end(),
+              [](const UniformInfo &a, const UniformInfo &b) { return a.name < b.name; });
+}
+
+UniformHandle RenderContext::findUniform(std::string_view name) const {
+    auto it = std::lower_bound(this->uniforms.begin(), this->uniforms.end(), name,
+                               [](const UniformInfo &info, std::string_view name) { return info.name < name; });
+    if (it == this->uniforms.end() || it->name != name)
+        return UniformHandle{};
+    return UniformHandle{.location = it->location};
+}
+
+UniformHandle RenderContext::uniform(std::string_view name) const {
+    auto handle = this->findUniform(name);
+    if (!handle.valid())
+        throw std::runtime_error("Uniform of name '" + std::string(name) + "' was not found");
+    return handle;
+}
+
+/**
+ * @brief Return the address for a uniform property
+ */
+GLint RenderContext::getUniform(const std::string &name) const {
+    return this->uniform(name).location;
 }
 
 void RenderContext::setBool(const std::string &name, bool value) const {
+    this->setBool(this->uniform(name), value);
+}
+
+void RenderContext::setBool(UniformHandle handle, bool value) const {
     assert(this->program > 0);
-    GLint uniformAddr = static_cast<GLint>(this->getUniform(name));
 #ifdef __DEBUG__
-    LOG(DEBUG) << " glUniform1i(" << uniformAddr << ", " << value << ") uniform=" << name;
+    LOG(DEBUG) << " glUniform1i(" << handle.location << ", " << value << ")";
 #endif
-    glUniform1i(uniformAddr, value);
+    glUniform1i(handle.location, value);
 }
 
 void RenderContext::setInt(const std::string &name, int value) const {
+    this->setInt(this->uniform(name), value);
+}
+
+void RenderContext::setInt(UniformHandle handle, int value) const {
     assert(this->program > 0);
-    GLint uniformAddr = static_cast<GLint>(this->getUniform(name));
 #ifdef __DEBUG__
-    LOG(DEBUG) << " glUniform1i(" << uniformAddr << ", " << value << ") uniform=" << name;
+    LOG(DEBUG) << " glUniform1i(" << handle.location << ", " << value << ")";
 #endif
-    glUniform1i(uniformAddr, value);
+    glUniform1i(handle.location, value);
 }
 
 void RenderContext::setUInt(const std::string &name, uint value) const {
+    this->setUInt(this->uniform(name), value);
+}
+
+void RenderContext::setUInt(UniformHandle handle, uint value) const {
     assert(this->program > 0);
-    GLint uniformAddr = static_cast<GLint>(this->getUniform(name));
 #ifdef __DEBUG__
-    LOG(DEBUG) << " glUniform1ui(" << uniformAddr << ", " << value << ") uniform=" << name;
+    LOG(DEBUG) << " glUniform1ui(" << handle.location << ", " << value << ")";
 #endif
-    glUniform1ui(uniformAddr, value);
+    glUniform1ui(handle.location, value);
 }
 
 void RenderContext::setFloat(const std::string &name, float value) const {
+    this->setFloat(this->uniform(name), value);
+}
+
+void RenderContext::setFloat(UniformHandle handle, float value) const {
     assert(this->program > 0);
-    GLint uniformAddr = static_cast<GLint>(this->getUniform(name));
 #ifdef __DEBUG__
-    LOG(DEBUG) << " glUniform1f(" << uniformAddr << ", " << value << ") uniform=" << name;
+    LOG(DEBUG) << " glUniform1f(" << handle.location << ", " << value << ")";
 #endif
-    glUniform1f(uniformAddr, value);
+    glUniform1f(handle.location, value);
 }
 
 template <typename T>
 void RenderContext::setVector(const std::string &name, T *value, size_t count) {
+    this->setVector(this->uniform(name), value, count);
+}
+
+template <typename T>
+void RenderContext::setVector(UniformHandle handle, T *value, size_t count) {
     assert(this->program > 0);
     assert(count > 0 && count <= 4);
 
-    GLint uniformAddr = static_cast<GLint>(this->getUniform(name));
+    GLint uniformAddr = handle.location;
     const T *data = &value[0];
     if constexpr (std::is_floating_point<T>::value) {
 #ifdef __DEBUG__
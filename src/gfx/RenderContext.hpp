@@ -2,15 +2,19 @@
 
 #include <chrono>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "constants.hpp"
+#include "gfx/GLState.hpp"
 #include "gfx/Shader.hpp"
 #include "gfx/VBO.hpp"
 #include "world/Camera.hpp"
 
 namespace goat::gfx {
 
+class TextureLoader;
+
 /**
  * @brief A RenderContext contains a collection of VBOs, shader programs, and textures that are used to render a scene.
  *        Each object added to the context is visible and can/will be associated with any other objects
@@ -23,7 +27,17 @@ class RenderContext {
     std::vector<std::shared_ptr<VBO>> vbos;
     std::vector<std::shared_ptr<Shader>> shaders;
     std::vector<std::shared_ptr<BoundTexture>> textures;
-
+    // Active uniforms of the linked program, sorted by name (populated by `compile`)
+    std::vector<UniformInfo> uniforms;
+    // The `model` matrix uniform (invalid for programs that take the model matrix per instance)
+    UniformHandle model_uniform{};
+    // The `texture_layer` uniform selecting the texture array layer of non-instanced draws (optional)
+    UniformHandle layer_uniform{};
+    // Identifies the set of bound textures, used to group draws that share them (populated by `compile`)
+    uint material_id = 0U;
+
+    // Populate the uniform table from the linked program
+    void reflectUniforms();
     // Apply a VBO to the render context
     void add(const std::shared_ptr<VBO> &vbo);
     // Apply a texture to the render context
@@ -38,8 +52,8 @@ class RenderContext {
 
     void compile();
 
-    // Load a texture from a file path and attach it to the render context
-    void loadTexture(std::string path, std::string uniform_target);
+    // Load a texture from a file path and attach it to the render context (in the background with a loader)
+    void loadTexture(std::string path, std::string uniform_target, TextureLoader *loader = nullptr);
 
     // Load a shader from a file path and attach it to the render context
     void loadShader(std::string path, const ShaderType type);
@@ -48,9 +62,54 @@ class RenderContext {
         this->add(vbo);
     }
 
+    // Return the OpenGL handle of the shader program
+    GLuint getProgram() const {
+        return this->program;
+    }
+
+    // Return the identifier of the set of textures bound by `use`
+    uint getMaterialId() const {
+        return this->material_id;
+    }
+
+    // Return the `model` uniform handle of the program
+    UniformHandle getModelUniform() const {
+        return this->model_uniform;
+    }
+
+    // Return the `texture_layer` uniform handle of the program
+    UniformHandle getLayerUniform() const {
+        return this->layer_uniform;
+    }
+
+    // Return every VBO drawn by the context
+    const std::vector<std::shared_ptr<VBO>> &getVBOs() const {
+        return this->vbos;
+    }
+
+    bool isCompiled() const {
+        return this->compiled;
+    }
+
+    // Returns the number of VBOs drawn by a single call to `render`
+    size_t size() const {
+        return this->vbos.size();
+    }
+
     // Return the location of a uniform in the shader program
     int getUniform(const std::string &name) const;
 
+    // Resolve a uniform handle by name, throwing if the uniform is not active in the program
+    UniformHandle uniform(std::string_view name) const;
+
+    // Resolve a uniform handle by name, returning an invalid handle if the uniform is not active in the program
+    UniformHandle findUniform(std::string_view name) const;
+
+    // Return every active uniform of the linked program
+    const std::vector<UniformInfo> &getUniforms() const {
+        return this->uniforms;
+    }
+
     // Render the scene from the game loop
     void render(world::Camera *camera) {
 #ifdef __DEBUG__
@@ -71,45 +130,59 @@ class RenderContext {
 #endif
     }
 
+    // Render every VBO once per model matrix using a single instanced draw call per VBO
+    void renderInstanced(const std::vector<mat4> &models);
+
     // Use the shader program for this frame
     void use() const {
 #ifdef __DEBUG__
         LOG(DEBUG) << "RenderContext<" << this << ">::use()";
 #endif
-        glUseProgram(this->program);
+        auto &state = GLState::get();
+        state.useProgram(this->program);
 
         // Apply texture indices
         for (const auto &bound_texture : this->textures) {
-            assert(bound_texture->index <= 31);
+            assert(bound_texture->index < TEXTURE_ARRAY_UNIT);
             auto texture = bound_texture->texture.get();
-            glActiveTexture(static_cast<GLenum>(GL_TEXTURE0 + bound_texture->index));
-            glBindTexture(GL_TEXTURE_2D, texture->getHandle());
+            state.bindTexture(bound_texture->index, GL_TEXTURE_2D, texture->getHandle());
 #ifdef __DEBUG__
-            LOG(DEBUG) << " glActiveTexture(GL_TEXTURE" << bound_texture->index << ") path=" << texture->getPath();
-            LOG(DEBUG) << " glBindTexture(GL_TEXTURE_2D, " << texture->getHandle() << ")";
+            LOG(DEBUG) << " texture unit " << bound_texture->index << " path=" << texture->getPath();
 #endif
         }
-#ifdef __DEBUG__
-        LOG(DEBUG) << " glUseProgram(" << this->program << ")";
-#endif
+    }
+
+    // Report the size on screen, in pixels, of an object drawn with the context's textures (see `Texture::request`)
+    void requestTextures(float pixels) const {
+        for (const auto &bound_texture : this->textures)
+            bound_texture->texture->request(pixels);
     }
 
     // Set a boolean value to a shader uniform (really an int)
     void setBool(const std::string &name, bool value) const;
+    void setBool(UniformHandle handle, bool value) const;
     // Set an integer to a shader uniform
     void setInt(const std::string &name, int value) const;
+    void setInt(UniformHandle handle, int value) const;
     // Set an unsigned integer to a shader uniform
     void setUInt(const std::string &name, uint value) const;
+    void setUInt(UniformHandle handle, uint value) const;
     // Set a float to a shader uniform
     void setFloat(const std::string &name, float value) const;
+    void setFloat(UniformHandle handle, float value) const;
     // Set a multi-dimensional array (matrix) to a shader uniform
 
     template <typename T = const float>
     void setMatrix(const std::string &name, T *value, size_t count) {
+        this->setMatrix(this->uniform(name), value, count);
+    }
+
+    template <typename T = const float>
+    void setMatrix(UniformHandle handle, T *value, size_t count) {
         assert(this->program > 0);
         assert(count > 0 && count <= 4);
 
-        GLint uniformAddr = static_cast<GLint>(this->getUniform(name));
+        GLint uniformAddr = handle.location;
         const T *data = &value[0];
         if (std::is_floating_point<T>::value) {
 #ifdef __DEBUG__
@@ -131,6 +204,8 @@ class RenderContext {
     // Set a vector to a shader uniform
     template <typename T = const float>
     void setVector(const std::string &name, T *value, size_t count);
+    template <typename T = const float>
+    void setVector(UniformHandle handle, T *value, size_t count);
 };
 
 }  // namespace goat::gfx
\ No newline at end of file
@@ -0,0 +1,68 @@
+#include "RenderQueue.hpp"
+
+#include <algorithm>
+#include <array>
+
+namespace goat::gfx {
+
+uint64_t SortKey::make(RenderPass pass, uint32_t program, uint32_t material, uint32_t vao, float depth) {
+    constexpr uint64_t depth_max = (1ULL << DEPTH_BITS) - 1;
+    auto quantized = static_cast<uint64_t>(std::clamp(depth, 0.0f, 1.0f) * static_cast<float>(depth_max));
+    auto state = (static_cast<uint64_t>(program) & ((1ULL << PROGRAM_BITS) - 1)) << PROGRAM_SHIFT |
+                 (static_cast<uint64_t>(material) & ((1ULL << MATERIAL_BITS) - 1)) << MATERIAL_SHIFT |
+                 (static_cast<uint64_t>(vao) & ((1ULL << VAO_BITS) - 1)) << VAO_SHIFT;
+    auto pass_bits = (static_cast<uint64_t>(pass) & ((1ULL << PASS_BITS) - 1)) << PASS_SHIFT;
+
+    // Translucent draws blend over what is behind them, so blending order beats state changes: the inverted
+    // depth moves above the state fields and the draws come out back to front
+    if (pass == RenderPass::TRANSLUCENT)
+        return pass_bits | (depth_max - quantized) << (PASS_SHIFT - DEPTH_BITS) | state >> DEPTH_BITS;
+
+    return pass_bits | state | quantized << DEPTH_SHIFT;
+}
+
+void radix_sort(std::vector<SortEntry> &entries, std::vector<SortEntry> &scratch) {
+    constexpr size_t digits = sizeof(uint64_t);
+    constexpr size_t radix = 256;
+    if (entries.size() < 2)
+        return;
+
+    // Build the histogram of every digit in a single pass over the keys
+    std::array<std::array<uint32_t, radix>, digits> histograms{};
+    for (const auto &entry : entries) {
+        auto key = entry.key;
+        for (size_t digit = 0; digit < digits; digit++) {
+            ++histograms[digit][key & 0xFF];
+            key >>= 8;
+        }
+    }
+
+    scratch.resize(entries.size());
+    auto *src = &entries;
+    auto *dst = &scratch;
+    const auto count = static_cast<uint32_t>(entries.size());
+    for (size_t digit = 0; digit < digits; digit++) {
+        auto &histogram = histograms[digit];
+        auto shift = digit * 8;
+
+        // Every key shares this digit, so this pass would not move anything
+        if (histogram[((*src)[0].key >> shift) & 0xFF] == count)
+            continue;
+
+        uint32_t offset = 0;
+        for (auto &bucket : histogram) {
+            auto size = bucket;
+            bucket = offset;
+            offset += size;
+        }
+
+        for (const auto &entry : *src)
+            (*dst)[histogram[(entry.key >> shift) & 0xFF]++] = entry;
+        std::swap(src, dst);
+    }
+
+    if (src != &entries)
+        entries.swap(scratch);
+}
+
+}  // namespace goat::gfx
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "gfx/constants.hpp"
+
+namespace goat::gfx {
+
+/**
+ * @brief Packs the state of a draw into a 64-bit key, so that sorting the keys groups draws by pass, then by
+ *        program, material and VAO, and finally by depth:
+ *
+ *     [63..62] pass      (2 bits)
+ *     [61..50] program   (12 bits)
+ *     [49..38] material  (12 bits)
+ *     [37..24] VAO       (14 bits, see `VBO::getSortId`)
+ *     [23..0]  depth     (24 bits)
+ *
+ *        Translucent draws must be blended back to front, so their inverted depth takes the place of the state
+ *        fields, which shift down by 24 bits (keeping their order as a tie-breaker).
+ *
+ * @note Handles wider than their field are truncated; a collision only costs a state change, never correctness.
+ */
+struct SortKey {
+    static constexpr uint64_t PASS_BITS = 2;
+    static constexpr uint64_t PROGRAM_BITS = 12;
+    static constexpr uint64_t MATERIAL_BITS = 12;
+    static constexpr uint64_t VAO_BITS = 14;
+    static constexpr uint64_t DEPTH_BITS = 24;
+
+    static constexpr uint64_t DEPTH_SHIFT = 0;
+    static constexpr uint64_t VAO_SHIFT = DEPTH_SHIFT + DEPTH_BITS;
+    static constexpr uint64_t MATERIAL_SHIFT = VAO_SHIFT + VAO_BITS;
+    static constexpr uint64_t PROGRAM_SHIFT = MATERIAL_SHIFT + MATERIAL_BITS;
+    static constexpr uint64_t PASS_SHIFT = PROGRAM_SHIFT + PROGRAM_BITS;
+    static_assert(PASS_SHIFT + PASS_BITS == 64, "SortKey fields must fill 64 bits");
+
+    // Build a key. `depth` is the view distance normalized to [0, 1] (values outside are clamped)
+    static uint64_t make(RenderPass pass, uint32_t program, uint32_t material, uint32_t vao, float depth);
+
+    static RenderPass pass(uint64_t key) {
+        return static_cast<RenderPass>(key >> PASS_SHIFT);
+    }
+
+    // The quantized depth of a SOLID key (translucent keys store it inverted in other bits)
+    static uint32_t depth(uint64_t key) {
+        return static_cast<uint32_t>(key & ((1ULL << DEPTH_BITS) - 1));
+    }
+};
+
+// A sort key and the index of the draw it belongs to
+struct SortEntry {
+    uint64_t key;
+    uint32_t item;
+};
+
+/**
+ * @brief Sort entries by key with a least-significant-digit radix sort (8 bits per pass). Passes over digits
+ *        that are identical for every key are skipped, which is the common case for the high (pass/program) bytes.
+ *        The sort is stable, so draws with equal keys keep their submission order.
+ * @param entries The entries to sort (sorted in place)
+ * @param scratch Temporary storage, resized as needed and reusable between calls
+ */
+void radix_sort(std::vector<SortEntry> &entries, std::vector<SortEntry> &scratch);
+
+/**
+ * @brief Collects draws for a frame as (key, item) pairs, sorts them to minimize state changes and hands them
+ *        back in submission order. The item is an index into whatever draw list the caller keeps.
+ */
+class RenderQueue {
+   private:
+    std::vector<SortEntry> entries;
+    std::vector<SortEntry> scratch;
+
+   public:
+    // Remove all draws, keeping the allocated storage
+    void clear() {
+        this->entries.clear();
+    }
+
+    void reserve(size_t count) {
+        this->entries.reserve(count);
+    }
+
+    void push(uint64_t key, uint32_t item) {
+        this->entries.push_back(SortEntry{.key = key, .item = item});
+    }
+
+    // Sort the queued draws by key
+    void sort() {
+        radix_sort(this->entries, this->scratch);
+    }
+
+    size_t size() const {
+        return this->entries.size();
+    }
+
+    // Return the queued draws (in submission order once `sort` has been called)
+    const std::vector<SortEntry> &getEntries() const {
+        return this->entries;
+    }
+};
+
+}  // namespace goat::gfx
@@ -0,0 +1,148 @@
+#include "StreamBuffer.hpp"
+
+#include <easylogging++.h>
+
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+#include "gfx/GLState.hpp"
+
+namespace goat::gfx {
+
+namespace {
+
+const char *mode_name(StreamMode mode) {
+    switch (mode) {
+        case StreamMode::PERSISTENT:
+            return "persistent";
+        case StreamMode::UNSYNCHRONIZED:
+            return "unsynchronized";
+        case StreamMode::ORPHAN:
+            return "orphan";
+    }
+    return "unknown";
+}
+
+}  // namespace
+
+StreamBuffer::StreamBuffer(size_t frame_size, StreamMode mode) : mode(mode), frame_size(frame_size) {
+    if (frame_size == 0)
+        throw std::runtime_error("A stream buffer needs room for at least one byte per frame");
+    if (this->mode == StreamMode::PERSISTENT && !StreamBuffer::persistentSupported())
+        this->mode = StreamMode::UNSYNCHRONIZED;
+
+    // Buffers are created and written through the copy target, to leave the vertex and uniform bindings alone
+    auto &state = GLState::get();
+    glGenBuffers(1, &this->buffer);
+    state.bindBuffer(GL_COPY_WRITE_BUFFER, this->buffer);
+    if (this->mode == StreamMode::PERSISTENT) {
+        constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_COPY_WRITE_BUFFER, STREAM_FRAMES * frame_size, nullptr, flags);
+        this->mapped =
+            static_cast<uint8_t *>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, STREAM_FRAMES * frame_size, flags));
+        if (this->mapped == nullptr)
+            throw std::runtime_error("Failed to map the stream buffer persistently");
+    } else {
+        auto size = this->mode == StreamMode::ORPHAN ? frame_size : STREAM_FRAMES * frame_size;
+        glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    }
+    LOG(INFO) << "Created a " << mode_name(this->mode) << " stream buffer (" << STREAM_FRAMES << " x "
+              << frame_size / 1024 << "KB)";
+}
+
+StreamBuffer::~StreamBuffer() {
+    for (auto &fence : this->fences)
+        if (fence != nullptr)
+            glDeleteSync(fence);
+    if (this->buffer == 0)
+        return;
+    auto &state = GLState::get();
+    if (this->mapped != nullptr) {
+        state.bindBuffer(GL_COPY_WRITE_BUFFER, this->buffer);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    }
+    state.forgetBuffer(this->buffer);
+    glDeleteBuffers(1, &this->buffer);
+}
+
+bool StreamBuffer::persistentSupported() {
+    return GLAD_GL_VERSION_4_4 != 0 || GLAD_GL_ARB_buffer_storage != 0;
+}
+
+void StreamBuffer::beginFrame() {
+    this->frame = (this->frame + 1) % STREAM_FRAMES;
+    this->head = 0UL;
+    this->in_frame = true;
+
+    if (this->mode == StreamMode::ORPHAN) {
+        // The driver hands out new storage while the GPU keeps reading the old one
+        GLState::get().bindBuffer(GL_COPY_WRITE_BUFFER, this->buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, this->frame_size, nullptr, GL_STREAM_DRAW);
+        return;
+    }
+
+    auto &fence = this->fences[this->frame];
+    if (fence == nullptr)
+        return;
+    // Only flush and wait when the region is still in use: with 3 frames in flight this is rare
+    if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+        auto start = std::chrono::high_resolution_clock::now();
+        GLenum result;
+        do {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000);
+        } while (result == GL_TIMEOUT_EXPIRED);
+        auto waited = std::chrono::high_resolution_clock::now() - start;
+        this->stats.stalls++;
+        this->stats.stall_us += std::chrono::duration<double, std::micro>(waited).count();
+        if (result == GL_WAIT_FAILED)
+            LOG(ERROR) << "Waiting on the stream buffer fence failed";
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void StreamBuffer::endFrame() {
+    this->in_frame = false;
+    if (this->mode == StreamMode::ORPHAN)
+        return;
+    this->fences[this->frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+StreamRange StreamBuffer::write(const void *data, size_t bytes, size_t alignment) {
+    assert(this->in_frame);
+    auto start = (this->head + alignment - 1) / alignment * alignment;
+    if (bytes == 0 || start + bytes > this->frame_size) {
+        this->stats.overflows++;
+        return StreamRange{};
+    }
+    this->head = start + bytes;
+    auto offset = this->mode == StreamMode::ORPHAN ? start : this->frame * this->frame_size + start;
+
+    switch (this->mode) {
+        case StreamMode::PERSISTENT:
+            std::memcpy(this->mapped + offset, data, bytes);
+            break;
+        case StreamMode::UNSYNCHRONIZED: {
+            GLState::get().bindBuffer(GL_COPY_WRITE_BUFFER, this->buffer);
+            constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+            auto target = glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, bytes, flags);
+            if (target == nullptr) {
+                this->stats.overflows++;
+                return StreamRange{};
+            }
+            std::memcpy(target, data, bytes);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+            break;
+        }
+        case StreamMode::ORPHAN:
+            GLState::get().bindBuffer(GL_COPY_WRITE_BUFFER, this->buffer);
+            glBufferSubData(GL_COPY_WRITE_BUFFER, offset, bytes, data);
+            break;
+    }
+    this->stats.bytes += bytes;
+    this->stats.writes++;
+    return StreamRange{.buffer = this->buffer, .offset = offset, .size = bytes};
+}
+
+}  // namespace goat::gfx
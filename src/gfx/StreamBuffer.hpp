@@ -0,0 +1,113 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <cstddef>
+
+#include "../constants.hpp"
+
+namespace goat::gfx {
+
+// The number of frames a stream buffer cycles through (the CPU writes one while the GPU may read the two others)
+static constexpr uint STREAM_FRAMES = 3U;
+// The bytes each frame can stream by default, and the default alignment of each write
+static constexpr size_t DEFAULT_STREAM_SIZE = 8UL * 1024UL * 1024UL;
+static constexpr size_t DEFAULT_STREAM_ALIGNMENT = 16UL;
+
+// How a stream buffer gets data to the GPU
+enum class StreamMode {
+    // Written through a pointer kept mapped for the buffer's lifetime (OpenGL 4.4 or ARB_buffer_storage)
+    PERSISTENT,
+    // Each write maps its range with GL_MAP_UNSYNCHRONIZED_BIT (OpenGL 3.0), relying on the fences alone
+    UNSYNCHRONIZED,
+    // A single frame sized buffer, orphaned every frame and filled with glBufferSubData
+    ORPHAN,
+};
+
+// A range written to a stream buffer, valid until the end of the frame it was written in
+struct StreamRange {
+    GLuint buffer = 0U;
+    size_t offset = 0UL;
+    size_t size = 0UL;
+
+    bool valid() const {
+        return this->buffer != 0U;
+    }
+};
+
+struct StreamStats {
+    size_t bytes = 0UL;
+    size_t writes = 0UL;
+    // Writes that did not fit in the frame's region (the caller has to upload them some other way)
+    size_t overflows = 0UL;
+    // Frames that had to wait for the GPU to finish reading their region, and the time spent waiting
+    size_t stalls = 0UL;
+    double stall_us = 0.0;
+};
+
+/**
+ * @brief A ring buffer for data rewritten every frame (instance attributes, uniforms, debug geometry). The buffer
+ *        is split into `STREAM_FRAMES` regions: each frame writes into the next region, and a fence placed at the
+ *        end of the frame guards it until the GPU is done reading it, so the CPU never overwrites data in flight
+ *        and the driver never has to copy or reallocate storage.
+ *
+ * @note Call `beginFrame` before the first write of a frame and `endFrame` once every draw reading the frame's
+ *       data has been issued. The same buffer can be bound to any target (vertex attributes, uniform ranges).
+ */
+class StreamBuffer {
+   private:
+    GLuint buffer = 0U;
+    StreamMode mode;
+    size_t frame_size;
+    // The persistently mapped storage (PERSISTENT only)
+    uint8_t *mapped = nullptr;
+    GLsync fences[STREAM_FRAMES]{};
+    uint frame = 0U;
+    // The next free byte in the current frame's region
+    size_t head = 0UL;
+    bool in_frame = false;
+    StreamStats stats{};
+
+   public:
+    /**
+     * @param frame_size The bytes each frame can write
+     * @param mode The preferred mode: PERSISTENT falls back to UNSYNCHRONIZED when buffer storage is not supported
+     */
+    StreamBuffer(size_t frame_size = DEFAULT_STREAM_SIZE, StreamMode mode = StreamMode::PERSISTENT);
+    StreamBuffer(const StreamBuffer &) = delete;
+    ~StreamBuffer();
+
+    StreamBuffer &operator=(const StreamBuffer &) = delete;
+
+    // Returns true if the current context supports persistently mapped buffers
+    static bool persistentSupported();
+
+    // Move to the next frame's region, waiting for the GPU to release it if needed
+    void beginFrame();
+    // Fence the frame's region
+    void endFrame();
+
+    /**
+     * @brief Copy data into the current frame's region
+     * @return The range written, or an invalid range if the frame has no room left for it
+     */
+    StreamRange write(const void *data, size_t bytes, size_t alignment = DEFAULT_STREAM_ALIGNMENT);
+
+    StreamMode getMode() const {
+        return this->mode;
+    }
+
+    size_t getFrameSize() const {
+        return this->frame_size;
+    }
+
+    const StreamStats &getStats() const {
+        return this->stats;
+    }
+
+    void resetStats() {
+        this->stats = StreamStats{};
+    }
+};
+
+}  // namespace goat::gfx
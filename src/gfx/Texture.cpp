@@ -2,20 +2,45 @@
 
 #include <glad/gl.h>
 
+#include <algorithm>
 #include <string>
 
+#include "gfx/GLState.hpp"
+
 namespace goat::gfx {
 
 Texture::Texture(std::string path) : path(path), handle(0U) {
     gli::texture texture = gli::load(path);
     assert(!texture.empty());
 
+    this->handle = Texture::create(texture);
+    for (std::size_t Layer = 0; Layer < texture.layers(); ++Layer)
+        for (std::size_t Face = 0; Face < texture.faces(); ++Face)
+            for (std::size_t Level = 0; Level < texture.levels(); ++Level)
+                Texture::upload(texture, Layer, Face, Level, 0, Texture::rowCount(texture, Level),
+                                texture.data(Layer, Face, Level));
+}
+
+Texture::~Texture() {
+    LOG(DEBUG) << "free(Texture" << this << ")";
+    if (this->handle != 0 && !this->pending) {
+        GLState::get().forgetTexture(this->handle);
+        glDeleteTextures(1, &this->handle);
+    }
+}
+
+GLuint Texture::getHandle() const {
+    return this->handle;
+}
+
+GLuint Texture::create(const gli::texture &texture) {
     gli::gl GL(gli::gl::PROFILE_GL33);
     gli::gl::format const format = GL.translate(texture.format(), texture.swizzles());
     GLenum target = GL.translate(texture.target());
 
-    glGenTextures(1, &this->handle);
-    glBindTexture(target, this->handle);
+    GLuint handle = 0U;
+    glGenTextures(1, &handle);
+    GLState::get().bindTexture(target, handle);
 
     glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, 0);
     glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(texture.levels() - 1));
@@ -35,54 +60,97 @@ Texture::Texture(std::string path) : path(path), handle(0U) {
             assert(0);
             break;
     }
+    return handle;
+}
 
-    for (std::size_t Layer = 0; Layer < texture.layers(); ++Layer)
-        for (std::size_t Face = 0; Face < texture.faces(); ++Face)
-            for (std::size_t Level = 0; Level < texture.levels(); ++Level) {
-                GLsizei const LayerGL = static_cast<GLsizei>(Layer);
-                glm::tvec3<GLsizei> Extent(texture.extent(Level));
-                target = gli::is_target_cube(texture.target())
-                             ? static_cast<GLenum>(GL_TEXTURE_CUBE_MAP_POSITIVE_X + Face)
-                             : target;
-
-                switch (texture.target()) {
-                    case gli::TARGET_2D:
-                    case gli::TARGET_CUBE:
-                        if (gli::is_compressed(texture.format()))
-                            glCompressedTexSubImage2D(target, static_cast<GLint>(Level), 0, 0, Extent.x, Extent.y,
-                                                      format.Internal, static_cast<GLsizei>(texture.size(Level)),
-                                                      texture.data(Layer, Face, Level));
-                        else
-                            glTexSubImage2D(target, static_cast<GLint>(Level), 0, 0, Extent.x, Extent.y,
-                                            format.External, format.Type, texture.data(Layer, Face, Level));
-                        break;
-                    case gli::TARGET_3D:
-                    case gli::TARGET_CUBE_ARRAY:
-                        if (gli::is_compressed(texture.format()))
-                            glCompressedTexSubImage3D(target, static_cast<GLint>(Level), 0, 0, 0, Extent.x, Extent.y,
-                                                      Extent.z, format.Internal,
-                                                      static_cast<GLsizei>(texture.size(Level)),
-                                                      texture.data(Layer, Face, Level));
-                        else
-                            glTexSubImage3D(target, static_cast<GLint>(Level), 0, 0, 0, Extent.x, Extent.y,
-                                            texture.target() == gli::TARGET_3D ? Extent.z : LayerGL, format.External,
-                                            format.Type, texture.data(Layer, Face, Level));
-                        break;
-                    default:
-                        assert(0);
-                        break;
-                }
-            }
+GLuint Texture::createStreamed(const gli::texture &texture, size_t base_level) {
+    assert(texture.target() == gli::TARGET_2D || texture.target() == gli::TARGET_CUBE);
+    gli::gl GL(gli::gl::PROFILE_GL33);
+    GLenum target = GL.translate(texture.target());
+
+    GLuint handle = 0U;
+    glGenTextures(1, &handle);
+    GLState::get().bindTexture(target, handle);
+
+    // Mutable storage, so that each level can be allocated and freed on its own
+    glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(base_level));
+    glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(texture.levels() - 1));
+    for (size_t level = base_level; level < texture.levels(); level++)
+        Texture::allocate(texture, level);
+    return handle;
 }
 
-Texture::~Texture() {
-    LOG(DEBUG) << "free(Texture" << this << ")";
-    if (this->handle != 0)
-        glDeleteTextures(1, &this->handle);
+void Texture::allocate(const gli::texture &texture, size_t level, bool release) {
+    gli::gl GL(gli::gl::PROFILE_GL33);
+    gli::gl::format const format = GL.translate(texture.format(), texture.swizzles());
+    glm::tvec3<GLsizei> Extent = release ? glm::tvec3<GLsizei>(0) : glm::tvec3<GLsizei>(texture.extent(level));
+    auto size = release ? 0 : static_cast<GLsizei>(texture.size(level));
+    auto Level = static_cast<GLint>(level);
+
+    // A null pointer would be read as an offset into a bound pixel unpack buffer
+    GLState::get().bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    for (size_t face = 0; face < texture.faces(); face++) {
+        GLenum target = gli::is_target_cube(texture.target())
+                            ? static_cast<GLenum>(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face)
+                            : GL.translate(texture.target());
+        if (gli::is_compressed(texture.format()))
+            glCompressedTexImage2D(target, Level, format.Internal, Extent.x, Extent.y, 0, size, nullptr);
+        else
+            glTexImage2D(target, Level, format.Internal, Extent.x, Extent.y, 0, format.External, format.Type,
+                         nullptr);
+    }
 }
 
-GLuint Texture::getHandle() const {
-    return this->handle;
+size_t Texture::rowCount(const gli::texture &texture, size_t level) {
+    if (texture.target() != gli::TARGET_2D && texture.target() != gli::TARGET_CUBE)
+        return 1UL;
+    auto height = static_cast<size_t>(texture.extent(level).y);
+    auto block = gli::is_compressed(texture.format()) ? static_cast<size_t>(gli::block_extent(texture.format()).y)
+                                                      : 1UL;
+    return (height + block - 1) / block;
+}
+
+void Texture::upload(const gli::texture &texture, size_t layer, size_t face, size_t level, size_t first_row,
+                     size_t rows, const void *data) {
+    gli::gl GL(gli::gl::PROFILE_GL33);
+    gli::gl::format const format = GL.translate(texture.format(), texture.swizzles());
+    GLenum target = GL.translate(texture.target());
+    target = gli::is_target_cube(texture.target()) ? static_cast<GLenum>(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face)
+                                                   : target;
+
+    GLsizei const LayerGL = static_cast<GLsizei>(layer);
+    glm::tvec3<GLsizei> Extent(texture.extent(level));
+    auto Level = static_cast<GLint>(level);
+    bool compressed = gli::is_compressed(texture.format());
+    switch (texture.target()) {
+        case gli::TARGET_2D:
+        case gli::TARGET_CUBE: {
+            // Rows of blocks for compressed formats: the last one may be cut short by the edge of the level
+            auto total = Texture::rowCount(texture, level);
+            auto block = compressed ? static_cast<GLsizei>(gli::block_extent(texture.format()).y) : 1;
+            auto y = static_cast<GLsizei>(first_row) * block;
+            auto height = std::min(static_cast<GLsizei>(rows) * block, Extent.y - y);
+            if (compressed)
+                glCompressedTexSubImage2D(target, Level, 0, y, Extent.x, height, format.Internal,
+                                          static_cast<GLsizei>(texture.size(level) / total * rows), data);
+            else
+                glTexSubImage2D(target, Level, 0, y, Extent.x, height, format.External, format.Type, data);
+            break;
+        }
+        case gli::TARGET_3D:
+        case gli::TARGET_CUBE_ARRAY:
+            if (compressed)
+                glCompressedTexSubImage3D(target, Level, 0, 0, 0, Extent.x, Extent.y, Extent.z, format.Internal,
+                                          static_cast<GLsizei>(texture.size(level)), data);
+            else
+                glTexSubImage3D(target, Level, 0, 0, 0, Extent.x, Extent.y,
+                                texture.target() == gli::TARGET_3D ? Extent.z : LayerGL, format.External,
+                                format.Type, data);
+            break;
+        default:
+            assert(0);
+            break;
+    }
 }
 
-}  // namespace goat::gfx
\ No newline at end of file
+}  // namespace goat::gfx
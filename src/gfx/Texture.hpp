@@ -4,6 +4,7 @@
 #include <GL/glext.h>
 #include <easylogging++.h>
 
+#include <algorithm>
 #include <gli/gli.hpp>
 #include <string>
 
@@ -16,6 +17,16 @@ class Texture {
     std::string path;
     // The OpenGL handle to the texture
     GLuint handle;
+    // Set while a `TextureLoader` loads the texture in the background: `handle` is the loader's placeholder until
+    // every level is uploaded, and is not owned by the texture
+    bool pending = false;
+    // The largest size on screen, in pixels, of the objects drawn with the texture since its loader last looked
+    // (only read when the texture is streamed)
+    float coverage = 0.0f;
+
+    friend class TextureLoader;
+    // A texture drawn with a placeholder until its loader is done with it
+    Texture(std::string path, GLuint placeholder) : path(path), handle(placeholder), pending(true) {}
 
    public:
     Texture(std::string _path);
@@ -24,6 +35,36 @@ class Texture {
     std::string getPath() const {
         return this->path;
     }
+    // Returns false while the texture is still being loaded in the background
+    bool isLoaded() const {
+        return !this->pending;
+    }
+    // Report the size on screen, in pixels, of an object drawn with the texture this frame (on the GL thread)
+    void request(float pixels) {
+        this->coverage = std::max(this->coverage, pixels);
+    }
+
+    // Create a texture with storage for every level of a decoded file, leaving it bound. Returns its handle
+    static GLuint create(const gli::texture &texture);
+    // Create a 2D or cube texture sampled from `base_level`, with storage for the levels from there on only (see
+    // `allocate`), leaving it bound. Returns its handle
+    static GLuint createStreamed(const gli::texture &texture, size_t base_level);
+    /**
+     * @brief Allocate the storage of one level of the bound texture made by `createStreamed`, for every face, or
+     *        free it when `release` is set. Levels below the texture's base level may be freed, since they are
+     *        never sampled.
+     */
+    static void allocate(const gli::texture &texture, size_t level, bool release = false);
+    /**
+     * @brief Upload the rows [first_row, first_row + rows) of one layer, face and level of a decoded file to the
+     *        bound texture. Rows count blocks for compressed formats, and only 2D and cube textures can be uploaded
+     *        in parts (the other targets take the whole level).
+     * @param data The first row's data, or its offset in the bound pixel unpack buffer
+     */
+    static void upload(const gli::texture &texture, size_t layer, size_t face, size_t level, size_t first_row,
+                       size_t rows, const void *data);
+    // Returns the number of rows `upload` splits a level of a decoded file into (1 if it cannot be split)
+    static size_t rowCount(const gli::texture &texture, size_t level);
 };
 
 }  // namespace goat::gfx
@@ -0,0 +1,143 @@
+#include "TextureArray.hpp"
+
+#include <easylogging++.h>
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+#include "gfx/GLState.hpp"
+
+namespace goat::gfx {
+
+TextureArray::TextureArray(const TextureFormat &format, uint capacity)
+    : handle(0U), format(format), capacity(capacity) {
+    assert(capacity > 0);
+    glGenTextures(1, &this->handle);
+    GLState::get().bindTexture(GL_TEXTURE_2D_ARRAY, this->handle);
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(format.levels - 1));
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, static_cast<GLsizei>(format.levels), format.internal,
+                   static_cast<GLsizei>(format.width), static_cast<GLsizei>(format.height),
+                   static_cast<GLsizei>(capacity));
+
+#ifdef __DEBUG__
+    LOG(DEBUG) << "glTexStorage3D(GL_TEXTURE_2D_ARRAY, " << format.levels << ", " << format.internal << ", "
+               << format.width << ", " << format.height << ", " << capacity << ")";
+#endif
+}
+
+TextureArray::~TextureArray() {
+    LOG(DEBUG) << "free(TextureArray" << this << ")";
+    if (this->handle != 0) {
+        GLState::get().forgetTexture(this->handle);
+        glDeleteTextures(1, &this->handle);
+    }
+}
+
+bool TextureArray::allocate(uint &layer) {
+    if (!this->free_layers.empty()) {
+        layer = this->free_layers.back();
+        this->free_layers.pop_back();
+        return true;
+    }
+    if (this->next_layer == this->capacity)
+        return false;
+    layer = this->next_layer++;
+    return true;
+}
+
+void TextureArray::release(uint layer) {
+    assert(layer < this->next_layer);
+    assert(std::find(this->free_layers.begin(), this->free_layers.end(), layer) == this->free_layers.end());
+    this->free_layers.push_back(layer);
+}
+
+void TextureArray::upload(uint layer, const gli::texture &texture) {
+    assert(layer < this->capacity);
+    GLState::get().bindTexture(GL_TEXTURE_2D_ARRAY, this->handle);
+
+    auto layer_gl = static_cast<GLint>(layer);
+    for (std::size_t Level = 0; Level < this->format.levels; ++Level) {
+        glm::tvec3<GLsizei> Extent(texture.extent(Level));
+        if (this->format.compressed)
+            glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, static_cast<GLint>(Level), 0, 0, layer_gl, Extent.x,
+                                      Extent.y, 1, this->format.internal, static_cast<GLsizei>(texture.size(Level)),
+                                      texture.data(0, 0, Level));
+        else
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, static_cast<GLint>(Level), 0, 0, layer_gl, Extent.x, Extent.y, 1,
+                            this->format.external, this->format.type, texture.data(0, 0, Level));
+    }
+}
+
+TextureArrayAllocator::TextureArrayAllocator(uint layers_per_array) : layers_per_array(layers_per_array) {
+    GLint max_layers{};
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers);
+    if (max_layers > 0)
+        this->layers_per_array = std::min(this->layers_per_array, static_cast<uint>(max_layers));
+}
+
+/**
+ * @brief Load a DDS texture into the first array with a free layer and the same format, size and mip count,
+ *        creating a new array of `layers_per_array` layers when there is none.
+ * @param path The path to the texture file
+ * @return The array and layer holding the texture
+ */
+TextureSlot TextureArrayAllocator::load(const std::string &path) {
+    auto it = this->loaded.find(path);
+    if (it != this->loaded.end())
+        return it->second;
+
+    gli::texture texture = gli::load(path);
+    if (texture.empty() || texture.target() != gli::TARGET_2D) {
+        std::stringstream err;
+        err << "Texture '" << path << "' is not a 2D texture and cannot be stored in a texture array";
+        throw std::runtime_error(err.str());
+    }
+
+    gli::gl GL(gli::gl::PROFILE_GL33);
+    gli::gl::format const gl_format = GL.translate(texture.format(), texture.swizzles());
+    gli::tvec3<GLsizei> const extent(texture.extent());
+    auto format = TextureFormat{
+        .internal = static_cast<GLenum>(gl_format.Internal),
+        .external = static_cast<GLenum>(gl_format.External),
+        .type = static_cast<GLenum>(gl_format.Type),
+        .compressed = gli::is_compressed(texture.format()),
+        .width = static_cast<uint>(extent.x),
+        .height = static_cast<uint>(extent.y),
+        .levels = static_cast<uint>(texture.levels()),
+    };
+
+    TextureSlot slot{};
+    for (const auto &array : this->arrays) {
+        if (array->getFormat() == format && array->allocate(slot.layer)) {
+            slot.array = array;
+            break;
+        }
+    }
+    if (!slot.valid()) {
+        slot.array = std::make_shared<TextureArray>(format, this->layers_per_array);
+        slot.array->allocate(slot.layer);
+        this->arrays.push_back(slot.array);
+        LOG(INFO) << "[gfx] created texture array #" << this->arrays.size() << " (" << format.width << "x"
+                  << format.height << ", " << this->layers_per_array << " layers) for '" << path << "'";
+    }
+
+    slot.array->upload(slot.layer, texture);
+    this->loaded[path] = slot;
+#ifdef __DEBUG__
+    LOG(DEBUG) << "Loaded texture '" << path << "' into array " << slot.array->getHandle() << " layer " << slot.layer;
+#endif
+    return slot;
+}
+
+void TextureArrayAllocator::release(const std::string &path) {
+    auto it = this->loaded.find(path);
+    if (it == this->loaded.end())
+        return;
+    it->second.array->release(it->second.layer);
+    this->loaded.erase(it);
+}
+
+}  // namespace goat::gfx
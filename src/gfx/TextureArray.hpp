@@ -0,0 +1,112 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <gli/gli.hpp>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../constants.hpp"
+#include "gfx/constants.hpp"
+
+namespace goat::gfx {
+
+// The storage format shared by every layer of a texture array
+struct TextureFormat {
+    GLenum internal;
+    GLenum external;
+    GLenum type;
+    bool compressed;
+    uint width;
+    uint height;
+    uint levels;
+
+    auto operator<=>(const TextureFormat &) const = default;
+};
+
+/**
+ * @brief A `GL_TEXTURE_2D_ARRAY` with a fixed number of layers of the same format and size.
+ *        Layers are handed out by `allocate` and returned with `release`.
+ */
+class TextureArray {
+   private:
+    // The OpenGL handle to the texture
+    GLuint handle;
+    TextureFormat format;
+    uint capacity;
+    // The next layer that has never been allocated, and layers that were released since
+    uint next_layer = 0U;
+    std::vector<uint> free_layers{};
+
+   public:
+    TextureArray(const TextureFormat &format, uint capacity);
+    TextureArray(const TextureArray &) = delete;
+    TextureArray &operator=(const TextureArray &) = delete;
+    ~TextureArray();
+
+    // Reserve a layer, returning false if the array is full
+    bool allocate(uint &layer);
+    // Return a layer to the array so it can be reused
+    void release(uint layer);
+    // Upload every mip level of a 2D texture into a layer
+    void upload(uint layer, const gli::texture &texture);
+
+    GLuint getHandle() const {
+        return this->handle;
+    }
+
+    const TextureFormat &getFormat() const {
+        return this->format;
+    }
+
+    // Returns the number of layers currently in use
+    size_t size() const {
+        return this->next_layer - this->free_layers.size();
+    }
+
+    bool full() const {
+        return this->free_layers.empty() && this->next_layer == this->capacity;
+    }
+};
+
+// A texture stored as one layer of a texture array
+struct TextureSlot {
+    std::shared_ptr<TextureArray> array{};
+    uint layer = 0U;
+
+    bool valid() const {
+        return this->array != nullptr;
+    }
+};
+
+/**
+ * @brief Groups textures loaded from DDS files into texture arrays by format and size, so that objects using
+ *        any of the textures in an array can be drawn without binding a texture in between: the shader picks
+ *        the layer from the `texture_layer` uniform (or per-instance attribute) instead.
+ */
+class TextureArrayAllocator {
+   private:
+    // The number of layers allocated for each new array
+    uint layers_per_array;
+    std::vector<std::shared_ptr<TextureArray>> arrays{};
+    // Loaded textures by path, so loading the same file twice shares its layer
+    std::map<std::string, TextureSlot> loaded{};
+
+   public:
+    TextureArrayAllocator(uint layers_per_array = DEFAULT_ARRAY_LAYERS);
+
+    // Load a texture from a file path into a layer of an array matching its format
+    TextureSlot load(const std::string &path);
+
+    // Free the layer used by a loaded texture
+    void release(const std::string &path);
+
+    // Return every array created so far
+    const std::vector<std::shared_ptr<TextureArray>> &getArrays() const {
+        return this->arrays;
+    }
+};
+
+}  // namespace goat::gfx
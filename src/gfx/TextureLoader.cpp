@@ -0,0 +1,356 @@
+#include "TextureLoader.hpp"
+
+#include <glad/gl.h>
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+
+#include "gfx/GLState.hpp"
+
+namespace goat::gfx {
+
+namespace {
+
+size_t align(size_t bytes, size_t alignment) {
+    return (bytes + alignment - 1) / alignment * alignment;
+}
+
+// The bytes of one level of a decoded file, over every face and layer
+size_t level_bytes(const gli::texture &data, size_t level) {
+    return data.size(level) * data.faces() * data.layers();
+}
+
+}  // namespace
+
+TextureLoader::TextureLoader(jobs::JobSystem *jobs, size_t frame_budget, size_t memory_budget)
+    : jobs(jobs), frame_budget(frame_budget), memory_budget(memory_budget), staging(frame_budget) {
+    // A mid grey texel, bound in place of every texture still loading
+    const uint8_t texel[4] = {128, 128, 128, 255};
+    auto &state = GLState::get();
+    state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glGenTextures(1, &this->placeholder);
+    state.bindTexture(GL_TEXTURE_2D, this->placeholder);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, texel);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    LOG(INFO) << "Loading textures in the background (" << frame_budget / 1024 << "KB uploaded per frame)";
+    if (memory_budget > 0)
+        LOG(INFO) << "Streaming texture levels within " << memory_budget / 1024 / 1024 << "MB";
+}
+
+TextureLoader::~TextureLoader() {
+    if (this->jobs != nullptr)
+        this->jobs->wait(this->decoding);
+    // Finer levels of streamed textures are uploaded into the textures' own handles
+    for (const auto &upload : this->uploads)
+        if (upload->handle != 0 && upload->stream == nullptr) {
+            GLState::get().forgetTexture(upload->handle);
+            glDeleteTextures(1, &upload->handle);
+        }
+    GLState::get().forgetTexture(this->placeholder);
+    glDeleteTextures(1, &this->placeholder);
+}
+
+/**
+ * @brief Start loading a texture: its file is read and decoded by a job (or right away when the job system has no
+ *        background workers), and uploaded by the following calls to `update`.
+ * @param path The path to the texture file
+ */
+std::shared_ptr<Texture> TextureLoader::load(const std::string &path) {
+    auto texture = std::shared_ptr<Texture>(new Texture(path, this->placeholder));
+    auto upload = std::make_unique<Upload>();
+    upload->texture = texture;
+    upload->path = path;
+    {
+        std::lock_guard<std::mutex> lock(this->decoded_mutex);
+        this->requested++;
+    }
+
+    if (this->jobs != nullptr && this->jobs->size() > 1) {
+        // Jobs are copyable functions, so the upload is handed over as a raw pointer
+        auto pending = upload.release();
+        this->jobs->run([this, pending]() { this->decode(std::unique_ptr<Upload>(pending)); }, &this->decoding);
+    } else {
+        this->decode(std::move(upload));
+    }
+    return texture;
+}
+
+void TextureLoader::decode(std::unique_ptr<Upload> upload) {
+    // A file that cannot be read is dropped by `finish` like any other failed load, so the loader still goes idle
+    try {
+        upload->data = gli::load(upload->path);
+    } catch (const std::exception &e) {
+        LOG(ERROR) << "Failed to read texture " << upload->path << ": " << e.what();
+        upload->data = gli::texture();
+    }
+    auto target = upload->data.target();
+    upload->failed = upload->data.empty() || (target != gli::TARGET_2D && target != gli::TARGET_CUBE &&
+                                              target != gli::TARGET_3D && target != gli::TARGET_CUBE_ARRAY);
+    if (!upload->failed) {
+        upload->end_level = upload->data.levels();
+        // Streamed textures start from the first level of their mip tail
+        upload->streamed = this->memory_budget > 0 && upload->data.levels() > 1 &&
+                           (target == gli::TARGET_2D || target == gli::TARGET_CUBE);
+        if (upload->streamed) {
+            while (upload->first_level + 1 < upload->end_level) {
+                auto extent = upload->data.extent(upload->first_level);
+                if (static_cast<size_t>(std::max(extent.x, extent.y)) <= STREAM_TAIL_SIZE)
+                    break;
+                upload->first_level++;
+            }
+            upload->level = upload->first_level;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(this->decoded_mutex);
+    this->decoded.push_back(std::move(upload));
+}
+
+void TextureLoader::update() {
+    {
+        std::lock_guard<std::mutex> lock(this->decoded_mutex);
+        for (auto &upload : this->decoded)
+            this->uploads.push_back(std::move(upload));
+        this->decoded.clear();
+    }
+    if (this->memory_budget > 0)
+        this->updateStreams();
+    if (this->uploads.empty())
+        return;
+
+    this->staging.beginFrame();
+    size_t spent = 0UL;
+    while (!this->uploads.empty() && spent < this->frame_budget) {
+        auto &upload = *this->uploads.front();
+        if (!upload.failed && !upload.texture.expired() && !this->advance(upload, spent))
+            break;
+        this->finish(upload);
+        this->uploads.pop_front();
+    }
+    // Textures uploaded from client memory elsewhere must not read from the staging buffer
+    GLState::get().bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    this->staging.endFrame();
+
+    if (spent > 0) {
+        this->stats.bytes += spent;
+        this->stats.frames++;
+        this->stats.max_frame_bytes = std::max(this->stats.max_frame_bytes, spent);
+    }
+}
+
+/**
+ * @brief Upload the next bands of rows of a texture, level after level, until it is complete or the frame's budget
+ *        is spent. A band that could never fit in a frame's budget is uploaded from client memory in a frame of
+ *        its own, rather than stalling the texture forever.
+ */
+bool TextureLoader::advance(Upload &upload, size_t &spent) {
+    const auto &data = upload.data;
+    auto &state = GLState::get();
+    if (upload.handle == 0) {
+        upload.handle = upload.streamed ? Texture::createStreamed(data, upload.first_level) : Texture::create(data);
+        upload.target = gli::gl(gli::gl::PROFILE_GL33).translate(data.target());
+    } else {
+        state.bindTexture(upload.target, upload.handle);
+    }
+    upload.frames++;
+
+    while (upload.layer < data.layers()) {
+        auto rows = Texture::rowCount(data, upload.level);
+        auto row_bytes = data.size(upload.level) / rows;
+        auto available = this->frame_budget - spent;
+        auto band = std::min(rows - upload.row, available > DEFAULT_STREAM_ALIGNMENT
+                                                    ? (available - DEFAULT_STREAM_ALIGNMENT) / row_bytes
+                                                    : 0UL);
+        auto source = static_cast<const uint8_t *>(data.data(upload.layer, upload.face, upload.level)) +
+                      upload.row * row_bytes;
+        if (band == 0) {
+            if (spent > 0)
+                return false;
+            state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            band = 1;
+            Texture::upload(data, upload.layer, upload.face, upload.level, upload.row, band, source);
+            spent += row_bytes;
+            this->stats.oversized++;
+        } else {
+            auto range = this->staging.write(source, band * row_bytes);
+            if (!range.valid())
+                return false;
+            state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, range.buffer);
+            Texture::upload(data, upload.layer, upload.face, upload.level, upload.row, band,
+                            reinterpret_cast<const void *>(range.offset));
+            spent += align(band * row_bytes, DEFAULT_STREAM_ALIGNMENT);
+        }
+        upload.bytes += band * row_bytes;
+
+        // Move on to the next level, face and layer once every row of this one is uploaded
+        upload.row += band;
+        if (upload.row < rows)
+            continue;
+        upload.row = 0UL;
+        if (++upload.level < upload.end_level)
+            continue;
+        upload.level = upload.first_level;
+        if (++upload.face < data.faces())
+            continue;
+        upload.face = 0UL;
+        upload.layer++;
+    }
+    return true;
+}
+
+void TextureLoader::finish(Upload &upload) {
+    auto texture = upload.texture.lock();
+    if (upload.stream != nullptr) {
+        // A finer level of a streamed texture: sample from it now that it is complete
+        upload.stream->busy = false;
+        if (texture == nullptr)
+            return;
+        GLState::get().bindTexture(upload.target, upload.handle);
+        glTexParameteri(upload.target, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(upload.first_level));
+        upload.stream->base = upload.first_level;
+        this->stats.streamed_in++;
+#ifdef __DEBUG__
+        LOG(DEBUG) << "Streamed in level " << upload.first_level << " of " << upload.path;
+#endif
+        return;
+    }
+
+    this->finished++;
+    if (texture == nullptr || upload.failed) {
+        if (upload.failed)
+            LOG(ERROR) << "Failed to load texture " << upload.path << ", keeping its placeholder";
+        if (upload.handle != 0) {
+            GLState::get().forgetTexture(upload.handle);
+            glDeleteTextures(1, &upload.handle);
+        }
+        return;
+    }
+
+    texture->handle = upload.handle;
+    texture->pending = false;
+    this->stats.loaded++;
+    LOG(INFO) << "Loaded texture " << upload.path << " (" << upload.bytes / 1024 << "KB uploaded over "
+              << upload.frames << " frames" << (upload.streamed ? ", streaming finer levels)" : ")");
+    if (!upload.streamed)
+        return;
+
+    auto stream = std::make_unique<Stream>();
+    stream->texture = texture;
+    stream->data = upload.data;
+    stream->handle = upload.handle;
+    stream->target = upload.target;
+    stream->base = upload.first_level;
+    stream->tail = upload.first_level;
+    stream->wanted = upload.first_level;
+    for (auto level = upload.first_level; level < upload.end_level; level++)
+        stream->bytes += level_bytes(upload.data, level);
+    this->resident += stream->bytes;
+    this->streams.push_back(std::move(stream));
+}
+
+/**
+ * @brief Estimate the finest level each streamed texture was drawn at last frame, from the largest size on screen
+ *        of the objects drawn with it: one texel per pixel across the object. Then free the levels finer than
+ *        needed while over the memory budget, and queue the next finer level of the textures that need one, when
+ *        it fits in the budget (after evicting levels other textures do not need). Textures stream one level at a
+ *        time, coarse to fine, and a texture that was not drawn only gives its levels up under memory pressure.
+ */
+void TextureLoader::updateStreams() {
+    std::erase_if(this->streams, [this](const std::unique_ptr<Stream> &stream) {
+        if (stream->busy || !stream->texture.expired())
+            return false;
+        this->resident -= stream->bytes;
+        return true;
+    });
+
+    for (auto &stream : this->streams) {
+        auto texture = stream->texture.lock();
+        if (texture == nullptr)
+            continue;
+        stream->wanted = stream->tail;
+        if (texture->coverage > 0.0f) {
+            auto extent = stream->data.extent(0);
+            auto texels = static_cast<float>(std::max(extent.x, extent.y));
+            auto level = std::floor(std::log2(texels / texture->coverage));
+            stream->wanted = level <= 0.0f ? 0UL : std::min(static_cast<size_t>(level), stream->tail);
+        }
+        texture->coverage = 0.0f;
+    }
+
+    while (this->resident > this->memory_budget && this->evict()) {
+    }
+
+    for (auto &stream : this->streams) {
+        if (stream->busy || stream->base <= stream->wanted || stream->texture.expired())
+            continue;
+        auto level = stream->base - 1;
+        auto bytes = level_bytes(stream->data, level);
+        while (this->resident + bytes > this->memory_budget && this->evict()) {
+        }
+        if (this->resident + bytes > this->memory_budget)
+            continue;
+
+        GLState::get().bindTexture(stream->target, stream->handle);
+        Texture::allocate(stream->data, level);
+        stream->bytes += bytes;
+        this->resident += bytes;
+        stream->busy = true;
+
+        auto upload = std::make_unique<Upload>();
+        upload->texture = stream->texture;
+        upload->path = stream->texture.lock()->getPath();
+        upload->data = stream->data;
+        upload->handle = stream->handle;
+        upload->target = stream->target;
+        upload->level = level;
+        upload->streamed = true;
+        upload->first_level = level;
+        upload->end_level = level + 1;
+        upload->stream = stream.get();
+        this->uploads.push_back(std::move(upload));
+    }
+}
+
+bool TextureLoader::evict() {
+    Stream *victim = nullptr;
+    for (auto &stream : this->streams) {
+        if (stream->busy || stream->base >= stream->wanted || stream->texture.expired())
+            continue;
+        if (victim == nullptr || stream->wanted - stream->base > victim->wanted - victim->base)
+            victim = stream.get();
+    }
+    if (victim == nullptr)
+        return false;
+
+    // Sample from the next coarser level before freeing the finest one
+    auto level = victim->base;
+    auto bytes = level_bytes(victim->data, level);
+    GLState::get().bindTexture(victim->target, victim->handle);
+    glTexParameteri(victim->target, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(level + 1));
+    Texture::allocate(victim->data, level, true);
+    victim->base = level + 1;
+    victim->bytes -= bytes;
+    this->resident -= bytes;
+    this->stats.evicted++;
+#ifdef __DEBUG__
+    LOG(DEBUG) << "Evicted level " << level << " of " << victim->texture.lock()->getPath();
+#endif
+    return true;
+}
+
+bool TextureLoader::idle() {
+    return this->getStats().pending == 0;
+}
+
+TextureLoadStats TextureLoader::getStats() {
+    std::lock_guard<std::mutex> lock(this->decoded_mutex);
+    auto stats = this->stats;
+    stats.pending = this->requested - this->finished;
+    stats.streaming = this->streams.size();
+    stats.resident_bytes = this->resident;
+    return stats;
+}
+
+}  // namespace goat::gfx
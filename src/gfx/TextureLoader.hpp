@@ -0,0 +1,151 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "gfx/StreamBuffer.hpp"
+#include "gfx/Texture.hpp"
+#include "jobs/JobSystem.hpp"
+
+namespace goat::gfx {
+
+// The bytes of texture data uploaded per frame by default
+static constexpr size_t DEFAULT_TEXTURE_UPLOAD_BUDGET = 4UL * 1024UL * 1024UL;
+// The largest mip level (in texels on its longest side) of the tail uploaded up front by streamed textures
+static constexpr size_t STREAM_TAIL_SIZE = 64UL;
+
+struct TextureLoadStats {
+    // Textures fully uploaded, and textures still being read or uploaded
+    size_t loaded = 0UL;
+    size_t pending = 0UL;
+    // Bytes uploaded, the frames that uploaded anything and the most uploaded by one of them
+    size_t bytes = 0UL;
+    size_t frames = 0UL;
+    size_t max_frame_bytes = 0UL;
+    // Uploads too large for a frame's budget, made from client memory in a frame of their own
+    size_t oversized = 0UL;
+    // Streamed textures, the bytes of their allocated levels, and the levels streamed in and evicted
+    size_t streaming = 0UL;
+    size_t resident_bytes = 0UL;
+    size_t streamed_in = 0UL;
+    size_t evicted = 0UL;
+};
+
+/**
+ * @brief Loads textures in the background. `load` returns a texture drawn with a 1x1 placeholder straight away,
+ *        while a job reads and decodes its file; `update`, called once per frame on the GL thread, then copies the
+ *        decoded levels into a pixel unpack staging buffer and uploads them, at most `frame_budget` bytes per frame
+ *        (large 2D levels are uploaded in bands of rows). The texture switches to its own handle once complete.
+ *
+ *        With a memory budget, 2D and cube textures are streamed: only their mip tail (the levels up to
+ *        `STREAM_TAIL_SIZE` texels) is uploaded before they are drawn, and finer levels are uploaded one at a time
+ *        while the objects drawn with them need them (see `Texture::request`), with GL_TEXTURE_BASE_LEVEL clamped to
+ *        the finest level complete. When the levels allocated go over the budget, the finest levels of the textures
+ *        drawn coarser than they are resident are freed again.
+ *
+ * @note The staging buffer is a `StreamBuffer`, so a frame's staging region is only rewritten once the GPU has
+ *       read it. Textures dropped before they finish loading are discarded. Streamed textures keep their decoded
+ *       file in memory, to stream levels back in after evicting them.
+ */
+class TextureLoader {
+   private:
+    struct Stream;
+
+    // A texture being read or uploaded, and how far its upload got
+    struct Upload {
+        std::weak_ptr<Texture> texture;
+        std::string path;
+        gli::texture data;
+        GLuint handle = 0U;
+        GLenum target = 0U;
+        // The next layer, face, level and row to upload
+        size_t layer = 0UL;
+        size_t face = 0UL;
+        size_t level = 0UL;
+        size_t row = 0UL;
+        size_t bytes = 0UL;
+        size_t frames = 0UL;
+        bool failed = false;
+        // Only the levels [first_level, end_level) are uploaded: the mip tail of a streamed texture, or one finer
+        // level uploaded into the existing texture of `stream`
+        bool streamed = false;
+        size_t first_level = 0UL;
+        size_t end_level = 0UL;
+        Stream *stream = nullptr;
+    };
+
+    // A streamed texture, once its mip tail is uploaded (its handle belongs to the texture)
+    struct Stream {
+        std::weak_ptr<Texture> texture;
+        gli::texture data;
+        GLuint handle = 0U;
+        GLenum target = 0U;
+        // The finest level sampled, the first level of the mip tail, and the finest level drawn last frame
+        size_t base = 0UL;
+        size_t tail = 0UL;
+        size_t wanted = 0UL;
+        // The bytes of the levels allocated
+        size_t bytes = 0UL;
+        // Set while a finer level is being uploaded
+        bool busy = false;
+    };
+
+    jobs::JobSystem *jobs;
+    size_t frame_budget;
+    // The most bytes the levels of streamed textures may take (0 uploads every level of every texture)
+    size_t memory_budget;
+    StreamBuffer staging;
+    GLuint placeholder = 0U;
+    // Textures decoded by the jobs, waiting for the GL thread, and the jobs still running
+    std::mutex decoded_mutex;
+    std::vector<std::unique_ptr<Upload>> decoded;
+    jobs::JobCounter decoding{};
+    // Textures being uploaded, in the order they were loaded (GL thread only)
+    std::deque<std::unique_ptr<Upload>> uploads;
+    // Textures passed to `load`, and textures uploaded or dropped
+    size_t requested = 0UL;
+    size_t finished = 0UL;
+    // Streamed textures, and the bytes of their allocated levels (GL thread only)
+    std::vector<std::unique_ptr<Stream>> streams;
+    size_t resident = 0UL;
+    TextureLoadStats stats{};
+
+    // Read and decode a texture file (on a worker thread)
+    void decode(std::unique_ptr<Upload> upload);
+    // Upload as much of a texture as the rest of the frame's budget allows, returning true once it is complete
+    bool advance(Upload &upload, size_t &spent);
+    // Hand a complete texture its handle, or drop it when it was released or failed to load
+    void finish(Upload &upload);
+    // Pick the level each streamed texture is needed at, evicting and queueing levels to follow
+    void updateStreams();
+    // Free the finest level of the streamed texture resident at the finest level it does not need, if any
+    bool evict();
+
+   public:
+    /**
+     * @param jobs The job system decoding the files (decoded on the calling thread without background workers)
+     * @param frame_budget The most bytes `update` uploads per frame
+     * @param memory_budget The most bytes the levels of streamed textures may take (0 to load textures whole)
+     */
+    TextureLoader(jobs::JobSystem *jobs = nullptr, size_t frame_budget = DEFAULT_TEXTURE_UPLOAD_BUDGET,
+                  size_t memory_budget = 0UL);
+    TextureLoader(const TextureLoader &) = delete;
+    ~TextureLoader();
+
+    TextureLoader &operator=(const TextureLoader &) = delete;
+
+    // Start loading a texture file, returning it drawn with the placeholder until it is uploaded
+    std::shared_ptr<Texture> load(const std::string &path);
+    // Stream levels in and out, and upload the decoded textures within the frame's budget (on the GL thread, once
+    // per frame, before drawing)
+    void update();
+    // Returns true once every texture loaded so far is drawable (streamed textures may still stream finer levels)
+    bool idle();
+
+    TextureLoadStats getStats();
+};
+
+}  // namespace goat::gfx
@@ -4,46 +4,167 @@
 #include <easylogging++.h>
 #include <glad/gl.h>
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
 namespace goat::gfx {
 
 VBO::VBO(BufferType bufferType, DrawType drawType, DataType dataType, const std::vector<uint> &indices)
     : ebo(0U), entry_count(0UL), drawType(drawType), dataType(dataType), bufferType(bufferType) {
     assert(bufferType == BufferType::ARRAY || bufferType == BufferType::ELEMENT);
-    assert(dataType == DataType::FLOAT || dataType == DataType::INT || dataType == DataType::UNSIGNED_INT);
     assert(drawType == DrawType::STATIC || drawType == DrawType::DYNAMIC);
 
     glGenVertexArrays(1, &this->vao);
     glGenBuffers(1, &this->vbo);
 
-    if (indices.size() > 0) {
+    if (indices.size() > 0)
+        this->setIndices(indices);
+}
+
+VBO::VBO(std::shared_ptr<GeometryArena> arena, const std::vector<VAOBound> &format, const void *data, size_t bytes,
+         const std::vector<uint> &indices)
+    : vao(0U),
+      vbo(0U),
+      ebo(0U),
+      arena(std::move(arena)),
+      entry_count(0UL),
+      drawType(DrawType::STATIC),
+      dataType(DataType::FLOAT),
+      bufferType(BufferType::ARRAY) {
+    for (const auto &bound : format)
+        this->addAttributeBound(bound);
+    size_t stride = this->stride();
+    if (stride == 0 || bytes % stride != 0)
+        throw std::runtime_error("The vertex data does not match the attribute bounds of the arena VBO");
+
+    this->entry_count = bytes / stride;
+    this->vertex_bytes = bytes;
+    this->geometry = this->arena->add(format, data, static_cast<uint32_t>(this->entry_count), indices);
+    this->index_count = indices.size();
+    auto pool = this->arena->range(this->geometry).pool;
+    this->vao = this->arena->vertexArray(pool);
+    this->bound_sources = this->arena->instanceSources(pool);
+}
+
+/**
+ * @brief Upload the index data to the EBO. When every index fits in 16 bits (i.e. the mesh has at most 65536
+ *        vertices) the indices are narrowed to GL_UNSIGNED_SHORT, halving the index bandwidth.
+ * @param indices The triangle list indices
+ */
+void VBO::setIndices(const std::vector<uint> &indices) {
+    if (indices.empty())
+        throw std::runtime_error("Cannot create an element buffer without indices");
+    if (this->arena != nullptr)
+        throw std::runtime_error("The indices of a VBO in a geometry arena cannot be replaced");
+
+    if (this->ebo == 0) {
         LOG(DEBUG) << "Creating element buffer for VBO " << &this->vbo;
         glGenBuffers(1, &this->ebo);
-        glBindVertexArray(this->vao);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->ebo);
+    }
+    GLState::get().bindVertexArray(this->vao);
+    GLState::get().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->ebo);
+
+    auto max_index = *std::max_element(indices.begin(), indices.end());
+    if (max_index <= std::numeric_limits<uint16_t>::max()) {
+        std::vector<uint16_t> narrow(indices.begin(), indices.end());
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, narrow.size() * sizeof(uint16_t), &narrow[0], GL_STATIC_DRAW);
+        this->index_type = GL_UNSIGNED_SHORT;
+    } else {
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint), &indices[0], GL_STATIC_DRAW);
+        this->index_type = GL_UNSIGNED_INT;
     }
+    this->index_count = indices.size();
+    // The element buffer binding is VAO state, so the depth-only VAO needs it too
+    if (this->depth_vao > 0) {
+        GLState::get().bindVertexArray(this->depth_vao);
+        GLState::get().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->ebo);
+    }
+
+#ifdef __DEBUG__
+    LOG(DEBUG) << "Uploaded " << this->index_count << " indices ("
+               << (this->index_type == GL_UNSIGNED_SHORT ? "16" : "32") << "-bit) to EBO " << this->ebo;
+#endif
 }
 
 VBO::~VBO() {
-    glDeleteVertexArrays(1, &this->vao);
-    glDeleteBuffers(1, &this->vbo);
-    if (this->ebo > 0)
+    auto &state = GLState::get();
+    if (this->arena != nullptr) {
+        // The VAO and buffers belong to the pool, which the other meshes still draw from
+        this->arena->remove(this->geometry);
+        if (this->instance_vbo > 0) {
+            this->bound_sources->instance_offset = InstanceSources::UNKNOWN;
+            this->bound_sources->layer_offset = InstanceSources::UNKNOWN;
+        }
+    } else {
+        state.forgetVertexArray(this->vao);
+        state.forgetBuffer(this->vbo);
+        glDeleteVertexArrays(1, &this->vao);
+        glDeleteBuffers(1, &this->vbo);
+    }
+    if (this->ebo > 0) {
+        state.forgetBuffer(this->ebo);
         glDeleteBuffers(1, &this->ebo);
+    }
+    if (this->instance_vbo > 0) {
+        state.forgetBuffer(this->instance_vbo);
+        glDeleteBuffers(1, &this->instance_vbo);
+    }
+    if (this->layer_vbo > 0) {
+        state.forgetBuffer(this->layer_vbo);
+        glDeleteBuffers(1, &this->layer_vbo);
+    }
+    if (this->depth_vao > 0) {
+        state.forgetVertexArray(this->depth_vao);
+        glDeleteVertexArrays(1, &this->depth_vao);
+    }
+    if (this->position_vbo > 0) {
+        state.forgetBuffer(this->position_vbo);
+        glDeleteBuffers(1, &this->position_vbo);
+    }
 }
 
 VBO::VBO(VBO &&other)
     : vao(other.vao),
       vbo(other.vbo),
       ebo(other.ebo),
+      arena(std::move(other.arena)),
+      geometry(other.geometry),
+      instance_vbo(other.instance_vbo),
+      instance_capacity(other.instance_capacity),
+      layer_vbo(other.layer_vbo),
+      layer_capacity(other.layer_capacity),
+      instance_source(other.instance_source),
+      instance_offset(other.instance_offset),
+      layer_source(other.layer_source),
+      layer_offset(other.layer_offset),
+      bound_sources(other.bound_sources),
+      position_vbo(other.position_vbo),
+      depth_vao(other.depth_vao),
+      position_index(other.position_index),
+      instance_index(other.instance_index),
       entry_count(other.entry_count),
+      index_count(other.index_count),
+      index_type(other.index_type),
       drawType(other.drawType),
       dataType(other.dataType),
       bufferType(other.bufferType),
-      bounds(other.bounds) {
+      bounds(other.bounds),
+      vertex_bytes(other.vertex_bytes),
+      dirty(std::move(other.dirty)) {
     other.vao = 0U;
     other.vbo = 0U;
     other.ebo = 0U;
+    other.geometry = INVALID_GEOMETRY;
+    other.instance_vbo = 0U;
+    other.instance_capacity = 0UL;
+    other.layer_vbo = 0U;
+    other.layer_capacity = 0UL;
+    other.position_vbo = 0U;
+    other.depth_vao = 0U;
     other.entry_count = 0UL;
+    other.index_count = 0UL;
+    other.vertex_bytes = 0UL;
 }
 
 VBO &VBO::operator=(VBO &&other) {
@@ -53,25 +174,67 @@ VBO &VBO::operator=(VBO &&other) {
     vao = other.vao;
     vbo = other.vbo;
     ebo = other.ebo;
+    arena = std::move(other.arena);
+    geometry = other.geometry;
+    instance_vbo = other.instance_vbo;
+    instance_capacity = other.instance_capacity;
+    layer_vbo = other.layer_vbo;
+    layer_capacity = other.layer_capacity;
+    position_vbo = other.position_vbo;
+    depth_vao = other.depth_vao;
+    position_index = other.position_index;
+    instance_source = other.instance_source;
+    instance_offset = other.instance_offset;
+    layer_source = other.layer_source;
+    layer_offset = other.layer_offset;
+    bound_sources = other.bound_sources;
+    instance_index = other.instance_index;
     entry_count = other.entry_count;
+    index_count = other.index_count;
+    index_type = other.index_type;
     drawType = other.drawType;
     dataType = other.dataType;
     bufferType = other.bufferType;
     bounds = std::move(other.bounds);
+    vertex_bytes = other.vertex_bytes;
+    dirty = std::move(other.dirty);
 
     other.vao = 0;
     other.vbo = 0;
     other.ebo = 0;
+    other.geometry = INVALID_GEOMETRY;
+    other.instance_vbo = 0;
+    other.instance_capacity = 0;
+    other.layer_vbo = 0;
+    other.layer_capacity = 0;
+    other.position_vbo = 0;
+    other.depth_vao = 0;
     other.entry_count = 0;
+    other.index_count = 0;
+    other.vertex_bytes = 0;
     return *this;
 };
 
 void VBO::use() const {
 #ifdef __DEBUG__
     assert(this->bounds.size() > 0);
-    LOG(DEBUG) << " glBindVertexArray(" << this->vao << ")";
 #endif
-    glBindVertexArray(this->vao);
+    GLState::get().bindVertexArray(this->vao);
+}
+
+void VBO::useDepth() const {
+#ifdef __DEBUG__
+    assert(this->bounds.size() > 0);
+#endif
+    GLState::get().bindVertexArray(this->depth_vao > 0 ? this->depth_vao : this->vao);
+}
+
+uint VBO::firstIndex() const {
+    return this->arena != nullptr ? this->arena->range(this->geometry).first_index : 0U;
+}
+
+int VBO::baseVertex() const {
+    return this->arena != nullptr ? this->arena->range(this->geometry).base_vertex : 0;
 }
 
 void VBO::draw() const {
@@ -80,11 +243,12 @@ void VBO::draw() const {
     assert(this->entry_count > 0);
 #endif
 
-    if (false && this->ebo > 0) {
-        // TODO: GL_UNSIGNED_INT not always accurate
-        glDrawElements(GL_TRIANGLES, this->entry_count, GL_UNSIGNED_INT, 0);
+    if (this->arena != nullptr) {
+        this->drawRange(0UL, this->index_count);
+    } else if (this->ebo > 0) {
+        glDrawElements(GL_TRIANGLES, this->index_count, this->index_type, 0);
 #ifdef __DEBUG__
-        LOG(DEBUG) << " glDrawElements(GL_TRIANGLES, " << this->entry_count << ", GL_UNSIGNED_INT, 0)";
+        LOG(DEBUG) << " glDrawElements(GL_TRIANGLES, " << this->index_count << ", " << this->index_type << ", 0)";
 #endif
     } else {
         glDrawArrays(GL_TRIANGLES, 0, this->entry_count);
@@ -94,11 +258,408 @@ void VBO::draw() const {
     }
 }
 
+void VBO::drawRange(size_t first, size_t count) const {
+#ifdef __DEBUG__
+    assert(this->bounds.size() > 0);
+    assert(first + count <= this->index_count);
+#endif
+    if (this->arena != nullptr) {
+        this->applyInstanceSources();
+        // The mesh's indices are relative to its first vertex in the pool
+        auto range = this->arena->range(this->geometry);
+        auto offset = (range.first_index + first) * sizeof(uint32_t);
+        glDrawElementsBaseVertex(GL_TRIANGLES, count, GL_UNSIGNED_INT, (void *)offset, range.base_vertex);
+#ifdef __DEBUG__
+        LOG(DEBUG) << " glDrawElementsBaseVertex(GL_TRIANGLES, " << count << ", GL_UNSIGNED_INT, (void *)" << offset
+                   << ", " << range.base_vertex << ")";
+#endif
+        return;
+    }
+    if (this->ebo == 0)
+        throw std::runtime_error("Range draws require an element buffer");
+
+    auto offset = first * (this->index_type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t));
+    glDrawElements(GL_TRIANGLES, count, this->index_type, (void *)offset);
+#ifdef __DEBUG__
+    LOG(DEBUG) << " glDrawElements(GL_TRIANGLES, " << count << ", " << this->index_type << ", (void *)" << offset
+               << ")";
+#endif
+}
+
+void VBO::drawInstanced(size_t instances) const {
+#ifdef __DEBUG__
+    assert(this->bounds.size() > 0);
+    assert(this->entry_count > 0);
+    assert(this->instance_vbo > 0);
+#endif
+
+    if (this->arena != nullptr) {
+        this->applyInstanceSources();
+        auto range = this->arena->range(this->geometry);
+        auto offset = static_cast<size_t>(range.first_index) * sizeof(uint32_t);
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, this->index_count, GL_UNSIGNED_INT, (void *)offset, instances,
+                                          range.base_vertex);
+#ifdef __DEBUG__
+        LOG(DEBUG) << " glDrawElementsInstancedBaseVertex(GL_TRIANGLES, " << this->index_count
+                   << ", GL_UNSIGNED_INT, (void *)" << offset << ", " << instances << ", " << range.base_vertex << ")";
+#endif
+    } else if (this->ebo > 0) {
+        glDrawElementsInstanced(GL_TRIANGLES, this->index_count, this->index_type, 0, instances);
+#ifdef __DEBUG__
+        LOG(DEBUG) << " glDrawElementsInstanced(GL_TRIANGLES, " << this->index_count << ", " << this->index_type
+                   << ", 0, " << instances << ")";
+#endif
+    } else {
+        glDrawArraysInstanced(GL_TRIANGLES, 0, this->entry_count, instances);
+#ifdef __DEBUG__
+        LOG(DEBUG) << " glDrawArraysInstanced(GL_TRIANGLES, 0, " << this->entry_count << ", " << instances << ")";
+#endif
+    }
+}
+
+void VBO::drawIndirect(size_t first, size_t count) const {
+#ifdef __DEBUG__
+    assert(this->bounds.size() > 0);
+    assert(this->instance_vbo > 0);
+#endif
+    if (this->ebo == 0 && this->arena == nullptr)
+        throw std::runtime_error("Indirect draws require an element buffer");
+    if (this->arena != nullptr)
+        this->applyInstanceSources();
+
+    auto offset = first * sizeof(DrawElementsIndirectCommand);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, this->index_type, (void *)offset, count,
+                                sizeof(DrawElementsIndirectCommand));
+#ifdef __DEBUG__
+    LOG(DEBUG) << " glMultiDrawElementsIndirect(GL_TRIANGLES, " << this->index_type << ", (void *)" << offset << ", "
+               << count << ", " << sizeof(DrawElementsIndirectCommand) << ")";
+#endif
+}
+
+/**
+ * @brief Create the per-instance buffer for this VBO and bind a mat4 attribute to it. A mat4 attribute
+ *        occupies four consecutive vec4 slots, each of which advances once per instance. The slot after the
+ *        matrix (`index + 4`) holds the texture array layer of each instance.
+ * @param index The first attribute index of the model matrix in the shader program
+ */
+void VBO::enableInstancing(uint index) {
+    if (this->instance_vbo > 0)
+        throw std::runtime_error("Instancing already enabled for VBO");
+    for (auto bound : this->bounds)
+        if (bound.index >= index && bound.index <= index + 4)
+            throw std::runtime_error("Instance attribute overlaps an existing attribute bound");
+
+    this->instance_index = index;
+    glGenBuffers(1, &this->instance_vbo);
+    this->enableInstanceArrays(this->vao);
+    if (this->depth_vao > 0)
+        this->enableInstanceArrays(this->depth_vao);
+    this->pointInstances(this->instance_vbo, 0UL);
+    // Until per-instance layers are uploaded every instance reads layer 0
+    glVertexAttribI1ui(index + 4, 0U);
+}
+
+void VBO::enableInstanceArrays(GLuint array) const {
+    GLState::get().bindVertexArray(array);
+    for (uint column = 0; column < 4; column++) {
+        glEnableVertexAttribArray(this->instance_index + column);
+        glVertexAttribDivisor(this->instance_index + column, 1);
+#ifdef __DEBUG__
+        LOG(DEBUG) << "glVertexAttribDivisor(" << this->instance_index + column << ", 1)";
+#endif
+    }
+}
+
+void VBO::instancePointers(GLuint array, GLuint buffer, size_t offset) const {
+    auto &state = GLState::get();
+    state.bindVertexArray(array);
+    state.bindBuffer(GL_ARRAY_BUFFER, buffer);
+    for (uint column = 0; column < 4; column++) {
+        auto column_offset = offset + sizeof(vec4) * column;
+        glVertexAttribPointer(this->instance_index + column, 4, GL_FLOAT, GL_FALSE, sizeof(mat4),
+                              (void *)column_offset);
+#ifdef __DEBUG__
+        LOG(DEBUG) << "glVertexAttribPointer(" << this->instance_index + column << ", 4, GL_FLOAT, GL_FALSE, "
+                   << sizeof(mat4) << ", (void *)" << column_offset << ")";
+#endif
+    }
+}
+
+void VBO::pointInstances(GLuint buffer, size_t offset) {
+    this->instance_source = buffer;
+    this->instance_offset = offset;
+    this->applyInstanceSources();
+}
+
+void VBO::pointLayers(GLuint buffer, size_t offset) {
+    this->layer_source = buffer;
+    this->layer_offset = offset;
+    this->applyInstanceSources();
+}
+
+/**
+ * @brief Point the instance attributes of the VAO at the sources of this VBO, unless they already do. VBOs with
+ *        their own VAO only change the sources through `pointInstances`/`pointLayers`; VBOs of an arena pool share
+ *        the pool's VAO, so they also check before each draw that another VBO did not point it elsewhere.
+ */
+void VBO::applyInstanceSources() const {
+    if (this->instance_vbo == 0)
+        return;
+    auto &bound = *this->bound_sources;
+    if (this->instance_source != bound.instance_source || this->instance_offset != bound.instance_offset) {
+        // Depth-only draws are positioned by the same per-instance matrices (layers only matter for shading)
+        this->instancePointers(this->vao, this->instance_source, this->instance_offset);
+        if (this->depth_vao > 0)
+            this->instancePointers(this->depth_vao, this->instance_source, this->instance_offset);
+        bound.instance_source = this->instance_source;
+        bound.instance_offset = this->instance_offset;
+    }
+    if (this->layer_source == bound.layer_source && this->layer_offset == bound.layer_offset)
+        return;
+
+    auto &state = GLState::get();
+    auto layer_index = this->instance_index + 4;
+    state.bindVertexArray(this->vao);
+    if (this->layer_source != 0) {
+        state.bindBuffer(GL_ARRAY_BUFFER, this->layer_source);
+        glVertexAttribIPointer(layer_index, 1, GL_UNSIGNED_INT, sizeof(uint), (void *)this->layer_offset);
+        if (bound.layer_source == 0) {
+            glEnableVertexAttribArray(layer_index);
+            glVertexAttribDivisor(layer_index, 1);
+        }
+#ifdef __DEBUG__
+        LOG(DEBUG) << "glVertexAttribIPointer(" << layer_index << ", 1, GL_UNSIGNED_INT, " << sizeof(uint)
+                   << ", (void *)" << this->layer_offset << ")";
+#endif
+    } else {
+        glDisableVertexAttribArray(layer_index);
+        glVertexAttribI1ui(layer_index, 0U);
+    }
+    bound.layer_source = this->layer_source;
+    bound.layer_offset = this->layer_offset;
+}
+
+/**
+ * @brief Split interleaved vertex data into two streams: the attribute at `position_index` goes to its own
+ *        tightly packed buffer and every other attribute stays interleaved in the main buffer. A second VAO
+ *        reads the position stream alone, so depth-only passes fetch nothing but positions (see `useDepth`).
+ * @param data The interleaved vertex data, laid out as for `applyAttributeBounds`
+ * @param bytes The size of the data
+ * @param position_index The attribute index of the position
+ */
+void VBO::applySplitBounds(const void *data, size_t bytes, uint position_index) {
+    if (this->bounds.size() == 0)
+        throw std::runtime_error("No attribute bounds set");
+    if (this->arena != nullptr)
+        throw std::runtime_error("VBOs in a geometry arena share interleaved pools and cannot be split");
+    auto position = std::find_if(this->bounds.begin(), this->bounds.end(),
+                                 [position_index](const VAOBound &bound) { return bound.index == position_index; });
+    if (position == this->bounds.end())
+        throw std::runtime_error("The position attribute of a split VBO must be one of its bounds");
+
+    size_t stride = this->stride();
+    size_t position_offset = 0UL;
+    for (auto it = this->bounds.begin(); it != position; ++it)
+        position_offset += it->bytes();
+    size_t position_bytes = position->bytes();
+    size_t rest_stride = stride - position_bytes;
+    this->entry_count = bytes / stride;
+    this->vertex_bytes = 0UL;
+    this->dirty.clear();
+    this->position_index = position_index;
+
+    // De-interleave: the position of every vertex, then the remaining attributes of every vertex
+    auto source = static_cast<const uint8_t *>(data);
+    std::vector<uint8_t> positions(this->entry_count * position_bytes);
+    std::vector<uint8_t> rest(this->entry_count * rest_stride);
+    for (size_t i = 0; i < this->entry_count; i++) {
+        auto vertex = source + i * stride;
+        std::memcpy(&positions[i * position_bytes], vertex + position_offset, position_bytes);
+        std::memcpy(&rest[i * rest_stride], vertex, position_offset);
+        std::memcpy(&rest[i * rest_stride + position_offset], vertex + position_offset + position_bytes,
+                    rest_stride - position_offset);
+    }
+
+    auto &state = GLState::get();
+    if (this->position_vbo == 0)
+        glGenBuffers(1, &this->position_vbo);
+    state.bindBuffer(GL_ARRAY_BUFFER, this->position_vbo);
+    glBufferData(GL_ARRAY_BUFFER, positions.size(), positions.data(), static_cast<GLenum>(this->drawType));
+    if (!rest.empty()) {
+        state.bindBuffer(GL_ARRAY_BUFFER, this->vbo);
+        glBufferData(GL_ARRAY_BUFFER, rest.size(), rest.data(), static_cast<GLenum>(this->drawType));
+    }
+
+    auto pointer = [](const VAOBound &bound, size_t stride, size_t offset) {
+        auto normalized = bound.normalized ? GL_TRUE : GL_FALSE;
+        glVertexAttribPointer(bound.index, bound.entries, (GLenum)bound.type, normalized, stride, (void *)offset);
+        glEnableVertexAttribArray(bound.index);
+#ifdef __DEBUG__
+        LOG(DEBUG) << "glVertexAttribPointer(" << bound.index << ", " << bound.entries << ", " << (GLenum)bound.type
+                   << ", " << (bound.normalized ? "GL_TRUE" : "GL_FALSE") << ", " << stride << ", (void *)" << offset
+                   << ")";
+#endif
+    };
+
+    state.bindVertexArray(this->vao);
+    state.bindBuffer(GL_ARRAY_BUFFER, this->vbo);
+    size_t offset = 0UL;
+    for (const auto &bound : this->bounds) {
+        if (bound.index == position_index)
+            continue;
+        pointer(bound, rest_stride, offset);
+        offset += bound.bytes();
+    }
+    state.bindBuffer(GL_ARRAY_BUFFER, this->position_vbo);
+    pointer(*position, position_bytes, 0UL);
+
+    if (this->depth_vao == 0) {
+        glGenVertexArrays(1, &this->depth_vao);
+        state.bindVertexArray(this->depth_vao);
+        if (this->ebo > 0)
+            state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->ebo);
+        if (this->instance_vbo > 0) {
+            this->enableInstanceArrays(this->depth_vao);
+            this->instancePointers(this->depth_vao, this->instance_source, this->instance_offset);
+        }
+    } else {
+        state.bindVertexArray(this->depth_vao);
+    }
+    state.bindBuffer(GL_ARRAY_BUFFER, this->position_vbo);
+    pointer(*position, position_bytes, 0UL);
+}
+
+/**
+ * @brief Upload a range of vertex data. Writes go through GL_COPY_WRITE_BUFFER, so neither the array buffer
+ *        binding nor the VAO (which holds the element buffer binding) is disturbed.
+ */
+void VBO::updateRange(size_t offset, const void *data, size_t bytes, UpdateMode mode) {
+    if (this->position_vbo > 0)
+        throw std::runtime_error("Range updates are not supported on VBOs split into position and attribute streams");
+    if (this->arena != nullptr)
+        throw std::runtime_error("Range updates are not supported on VBOs in a geometry arena");
+    if (offset + bytes > this->vertex_bytes)
+        throw std::runtime_error("VBO range update is outside of the vertex data");
+    if (mode == UpdateMode::ORPHAN && (offset != 0 || bytes != this->vertex_bytes))
+        throw std::runtime_error("Orphaning a VBO replaces all of its data, the update must cover the whole buffer");
+    if (bytes == 0)
+        return;
+
+    GLState::get().bindBuffer(GL_COPY_WRITE_BUFFER, this->vbo);
+    switch (mode) {
+        case UpdateMode::SUB_DATA:
+            glBufferSubData(GL_COPY_WRITE_BUFFER, offset, bytes, data);
+            break;
+        case UpdateMode::ORPHAN:
+            glBufferData(GL_COPY_WRITE_BUFFER, bytes, nullptr, static_cast<GLenum>(this->drawType));
+            glBufferSubData(GL_COPY_WRITE_BUFFER, 0, bytes, data);
+            break;
+        case UpdateMode::MAP_RANGE:
+        case UpdateMode::MAP_UNSYNCHRONIZED: {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+            if (mode == UpdateMode::MAP_UNSYNCHRONIZED)
+                flags |= GL_MAP_UNSYNCHRONIZED_BIT;
+            auto target = glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, bytes, flags);
+            if (target == nullptr)
+                throw std::runtime_error("Failed to map the VBO range");
+            std::memcpy(target, data, bytes);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+            break;
+        }
+    }
+#ifdef __DEBUG__
+    LOG(DEBUG) << " VBO range update (" << offset << ", " << bytes << ", mode " << static_cast<int>(mode) << ")";
+#endif
+}
+
+size_t VBO::flushRanges(const void *data, size_t bytes, UpdateMode mode) {
+    if (bytes != this->vertex_bytes)
+        throw std::runtime_error("VBO flush expects the complete vertex data");
+    if (this->dirty.empty())
+        return 0UL;
+
+    size_t uploaded = 0UL;
+    if (mode == UpdateMode::ORPHAN) {
+        this->updateRange(0, data, bytes, mode);
+        uploaded = bytes;
+    } else {
+        auto source = static_cast<const uint8_t *>(data);
+        for (const auto &range : this->dirty.get()) {
+            this->updateRange(range.offset, source + range.offset, range.size, mode);
+            uploaded += range.size;
+        }
+    }
+    this->dirty.clear();
+    return uploaded;
+}
+
+void VBO::stream(GLuint buffer, size_t &capacity, const void *data, size_t bytes) {
+    GLState::get().bindBuffer(GL_ARRAY_BUFFER, buffer);
+    if (bytes > capacity) {
+        glBufferData(GL_ARRAY_BUFFER, bytes, data, GL_STREAM_DRAW);
+        capacity = bytes;
+    } else {
+        glBufferData(GL_ARRAY_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, data);
+    }
+}
+
+/**
+ * @brief Upload the model matrices for the next instanced draw. The buffers only grow; when the data fits
+ *        the existing storage is orphaned so the driver does not have to wait on the previous frame.
+ * @param models The model matrix of each instance
+ * @param layers The texture array layer of each instance (every instance reads layer 0 when null)
+ * @param count The number of instances
+ */
+void VBO::uploadInstances(const mat4 *models, const uint *layers, size_t count) {
+    assert(this->instance_vbo > 0);
+    if (count == 0)
+        return;
+
+    VBO::stream(this->instance_vbo, this->instance_capacity, models, count * sizeof(mat4));
+    this->pointInstances(this->instance_vbo, 0UL);
+
+    if (layers != nullptr) {
+        if (this->layer_vbo == 0)
+            glGenBuffers(1, &this->layer_vbo);
+        VBO::stream(this->layer_vbo, this->layer_capacity, layers, count * sizeof(uint));
+    }
+    this->pointLayers(layers == nullptr ? 0U : this->layer_vbo, 0UL);
+}
+
+/**
+ * @brief Upload the model matrices for the next instanced draw into a stream buffer. The attributes only need
+ *        new pointers (VAO state) rather than new buffer storage, which the driver would have to allocate or
+ *        copy; the data stays valid until the stream buffer's frame ends.
+ * @param stream A stream buffer inside a frame (between `beginFrame` and `endFrame`)
+ * @param models The model matrix of each instance
+ * @param layers The texture array layer of each instance (every instance reads layer 0 when null)
+ * @param count The number of instances
+ */
+void VBO::uploadInstances(StreamBuffer &stream, const mat4 *models, const uint *layers, size_t count) {
+    assert(this->instance_vbo > 0);
+    if (count == 0)
+        return;
+
+    auto matrices = stream.write(models, count * sizeof(mat4));
+    auto layer_range = layers == nullptr ? StreamRange{} : stream.write(layers, count * sizeof(uint));
+    if (!matrices.valid() || (layers != nullptr && !layer_range.valid())) {
+        this->uploadInstances(models, layers, count);
+        return;
+    }
+    this->pointInstances(matrices.buffer, matrices.offset);
+    this->pointLayers(layer_range.buffer, layer_range.offset);
+}
+
 GLuint VBO::getVBO() const {
+    if (this->arena != nullptr)
+        return this->arena->vertexBuffer(this->arena->range(this->geometry).pool);
     return this->vbo;
 }
 
 GLuint VBO::getEBO() const {
+    if (this->arena != nullptr)
+        return this->arena->indexBuffer(this->arena->range(this->geometry).pool);
     return this->ebo;
 }
 
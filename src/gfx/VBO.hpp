@@ -2,9 +2,15 @@
 
 #include <glad/gl.h>
 
+#include <memory>
 #include <numeric>
 
-#include "constants.hpp"
+#include "../constants.hpp"
+#include "gfx/DirtyRanges.hpp"
+#include "gfx/GLState.hpp"
+#include "gfx/GeometryArena.hpp"
+#include "gfx/StreamBuffer.hpp"
+#include "gfx/constants.hpp"
 #include "gfx/structs.hpp"
 
 namespace goat::gfx {
@@ -14,16 +20,49 @@ namespace goat::gfx {
  *        used to render individual points into shapes.
  *
  * @note Providing the `&indices` parameter will create an Element Buffer Object (EBO) automatically,
- *       that can be used for rendering indexed vertices.
+ *       that is used for rendering indexed vertices. Indices are stored as 16-bit when they all fit.
+ *       A VBO can also draw a mesh stored in a `GeometryArena` instead of its own buffers.
  */
 class VBO {
    private:
+    // The bits of an arena mesh's handle kept below its VAO in `getSortId`
+    static constexpr uint32_t ARENA_SORT_BITS = 8U;
+
     // Internal OpenGL handles for the VAO, VBO, and EBO (optional)
     GLuint vao;
     GLuint vbo;
     GLuint ebo;
+    // The arena storing the vertex and index data instead (optional): the VAO is then the one of the mesh's pool,
+    // shared with the other meshes of the pool, and the VBO owns no buffers besides the per-instance ones
+    std::shared_ptr<GeometryArena> arena{};
+    GeometryHandle geometry = INVALID_GEOMETRY;
+    // Per-instance attribute buffer holding model matrices (optional, see `enableInstancing`)
+    GLuint instance_vbo = 0U;
+    // The allocated size (in bytes) of the instance buffer
+    size_t instance_capacity = 0UL;
+    // Per-instance texture array layer buffer (optional, created by the first `uploadInstances` with layers)
+    GLuint layer_vbo = 0U;
+    size_t layer_capacity = 0UL;
+    // The buffers and byte offsets the instance attributes of this VBO read from: the instance buffers, or ranges
+    // of a stream buffer (a layer source of 0 means every instance reads the constant layer 0)
+    GLuint instance_source = 0U;
+    size_t instance_offset = 0UL;
+    GLuint layer_source = 0U;
+    size_t layer_offset = 0UL;
+    // What the VAO's instance attributes currently point at (shared with the other VBOs of an arena pool)
+    std::shared_ptr<InstanceSources> bound_sources = std::make_shared<InstanceSources>();
+    // The tightly packed position stream of a split VBO, the VAO reading only it, and the position's attribute index
+    // (optional, see `applySplitAttributeBounds`)
+    GLuint position_vbo = 0U;
+    GLuint depth_vao = 0U;
+    uint position_index = 0U;
+    // The first attribute index of the per-instance model matrix
+    uint instance_index = INSTANCE_ATTRIBUTE_INDEX;
     // The total number of entries
     size_t entry_count;
+    // The number of indices in the EBO, and their type (GL_UNSIGNED_SHORT when every index fits in 16 bits)
+    size_t index_count = 0UL;
+    GLenum index_type = GL_UNSIGNED_INT;
     // The type of draw to use
     DrawType drawType;
     // The type of data to store
@@ -32,16 +71,52 @@ class VBO {
     BufferType bufferType;
     // Registered array sizing data for automatically configuring the VBO and attribute pointers
     std::vector<VAOBound> bounds = {};
+    // The size (in bytes) of the vertex data uploaded by `applyAttributeBounds`, and the ranges changed since
+    size_t vertex_bytes = 0UL;
+    DirtyRanges dirty{};
+
+    // Upload the dirty ranges from a copy of the whole vertex data, returning the bytes sent
+    size_t flushRanges(const void *data, size_t bytes, UpdateMode mode);
+
+    // Upload streamed data to a buffer, growing it when needed and orphaning its previous storage otherwise
+    static void stream(GLuint buffer, size_t &capacity, const void *data, size_t bytes);
+    // Read the per-instance model matrix and layer attributes from a buffer offset
+    void pointInstances(GLuint buffer, size_t offset);
+    void pointLayers(GLuint buffer, size_t offset);
+    // Point the VAO's instance attributes at this VBO's sources (VAO state, only set when they point elsewhere)
+    void applyInstanceSources() const;
+    // Enable the per-instance model matrix attributes of a VAO, and point them at a buffer offset
+    void enableInstanceArrays(GLuint array) const;
+    void instancePointers(GLuint array, GLuint buffer, size_t offset) const;
+    // De-interleave the vertex data into the position and attribute streams (see `applySplitAttributeBounds`)
+    void applySplitBounds(const void *data, size_t bytes, uint position_index);
 
     // Calculate the total size of the array buffer
     size_t stride() const {
         return std::accumulate(this->bounds.begin(), this->bounds.end(), static_cast<size_t>(0UL),
-                               [](size_t acc, VAOBound bound) { return acc + bound.data_size * bound.entries; });
+                               [](size_t acc, VAOBound bound) { return acc + bound.bytes(); });
     }
 
    public:
     VBO(BufferType bufferType, DrawType drawType, DataType dataType,
         const std::vector<uint> &indices = std::vector<uint>{});
+
+    /**
+     * @brief Store a mesh in a geometry arena and draw it from there: meshes sharing a pool share its VAO, so
+     *        drawing one after the other does not switch VAOs. The vertex data cannot be updated or split into
+     *        streams afterwards, and the mesh is removed from the arena with the VBO.
+     *
+     * @param arena The arena holding the mesh
+     * @param format The attribute bounds of the vertex data (see `mesh::quantize`)
+     * @param points The interleaved vertex data, laid out as for `applyAttributeBounds`
+     * @param indices The triangle list indices (always stored as 32-bit in the arena)
+     */
+    template <typename T = float>
+    VBO(std::shared_ptr<GeometryArena> arena, const std::vector<VAOBound> &format, const std::vector<T> &points,
+        const std::vector<uint> &indices)
+        : VBO(std::move(arena), format, points.data(), points.size() * sizeof(T), indices) {}
+    VBO(std::shared_ptr<GeometryArena> arena, const std::vector<VAOBound> &format, const void *data, size_t bytes,
+        const std::vector<uint> &indices);
     VBO(const VBO &) = delete;
     VBO(VBO &&);
     ~VBO();
@@ -49,20 +124,126 @@ class VBO {
     VBO &operator=(const VBO &) = delete;
     VBO &operator=(VBO &&);
 
+    GLuint getVAO() const {
+        return this->vao;
+    }
     GLuint getVBO() const;
     GLuint getEBO() const;
 
+    /**
+     * @brief Identify the geometry when sorting draws (see `SortKey`): the VAO, or for a mesh in an arena the VAO
+     *        it shares with its pool above the mesh's handle. The draws of each mesh stay together (so they can be
+     *        instanced), and the meshes of a pool next to each other (so the VAO is not switched between them).
+     */
+    uint32_t getSortId() const {
+        if (this->arena == nullptr)
+            return this->vao;
+        return this->vao << ARENA_SORT_BITS | (this->geometry & ((1U << ARENA_SORT_BITS) - 1U));
+    }
+
     // Apply the vertex buffer in the current frame being rendered
     void use() const;
 
+    // Apply the position-only VAO of a split VBO for a depth-only pass (the full VAO when the VBO is not split)
+    void useDepth() const;
+
+    // Returns true if the positions are stored in their own stream (see `applySplitAttributeBounds`)
+    bool hasPositionStream() const {
+        return this->position_vbo > 0;
+    }
+
+    // The first index and the base vertex of the mesh in the index and vertex buffers (0 unless it is in an arena)
+    uint firstIndex() const;
+    int baseVertex() const;
+
     // Draw the vertex buffer in the current frame being rendered
     void draw() const;
 
+    // Draw `count` indices of the mesh starting at its index `first` (requires an EBO or an arena)
+    void drawRange(size_t first, size_t count) const;
+
+    // Draw `instances` copies of the vertex buffer in a single call, using the uploaded instance data
+    void drawInstanced(size_t instances) const;
+
+    /**
+     * @brief Draw `count` commands of the bound GL_DRAW_INDIRECT_BUFFER with one glMultiDrawElementsIndirect call,
+     *        starting at command `first` (requires OpenGL 4.3 and an EBO or an arena). Per-instance attributes are
+     *        read from each command's `base_instance` onwards, and arena meshes need the commands to carry their
+     *        `firstIndex` and `baseVertex`.
+     */
+    void drawIndirect(size_t first, size_t count) const;
+
+    // Create the per-instance model matrix buffer, occupying attribute indices [index, index + 3]
+    void enableInstancing(uint index = INSTANCE_ATTRIBUTE_INDEX);
+
+    // Stream per-instance model matrices (and optionally texture array layers) into the instance buffers
+    void uploadInstances(const std::vector<mat4> &models, const std::vector<uint> &layers = {}) {
+        assert(layers.empty() || layers.size() == models.size());
+        this->uploadInstances(models.data(), layers.empty() ? nullptr : layers.data(), models.size());
+    }
+    // Write the per-instance data to this frame's region of a stream buffer instead, and read the attributes from
+    // there (falls back to the instance buffers when the frame's region is full)
+    void uploadInstances(StreamBuffer &stream, const std::vector<mat4> &models, const std::vector<uint> &layers = {}) {
+        assert(layers.empty() || layers.size() == models.size());
+        this->uploadInstances(stream, models.data(), layers.empty() ? nullptr : layers.data(), models.size());
+    }
+    // The same for `count` instances stored anywhere (`layers` is null when every instance reads layer 0)
+    void uploadInstances(const mat4 *models, const uint *layers, size_t count);
+    void uploadInstances(StreamBuffer &stream, const mat4 *models, const uint *layers, size_t count);
+
+    // Returns true if `enableInstancing` has been called on this VBO
+    bool isInstanced() const {
+        return this->instance_vbo > 0;
+    }
+
     // Returns the number of elements to render for this VBO
     size_t size() const {
         return this->entry_count;
     }
 
+    // Returns the size in bytes of the vertex data
+    size_t bytes() const {
+        return this->vertex_bytes;
+    }
+
+    /**
+     * @brief Replace part of the vertex data without touching the attribute pointers.
+     * @param offset The byte offset of the data in the vertex buffer
+     * @param data The new data
+     * @param bytes The size of the data (the range must lie within the uploaded vertex data)
+     * @param mode How to upload it: ORPHAN only applies when the range covers the whole buffer
+     */
+    void updateRange(size_t offset, const void *data, size_t bytes, UpdateMode mode = UpdateMode::SUB_DATA);
+
+    // Mark `count` items of the vertex data, starting at item `first`, as changed (see `flush`)
+    template <typename T = float>
+    void markDirty(size_t first, size_t count) {
+        this->dirty.add(first * sizeof(T), count * sizeof(T));
+    }
+
+    // Returns the ranges changed since the last `flush`
+    const DirtyRanges &getDirtyRanges() const {
+        return this->dirty;
+    }
+
+    /**
+     * @brief Upload the ranges marked dirty since the last flush from the complete vertex data, which must have
+     *        the size of the data passed to `applyAttributeBounds`. ORPHAN mode uploads everything.
+     * @return The number of bytes uploaded
+     */
+    template <typename T = float>
+    size_t flush(const std::vector<T> &points, UpdateMode mode = UpdateMode::SUB_DATA) {
+        return this->flushRanges(points.data(), points.size() * sizeof(T), mode);
+    }
+
+    // Returns the number of indices drawn for this VBO (0 if it is not indexed)
+    size_t indexCount() const {
+        return this->index_count;
+    }
+
+    // Upload (or replace) the index data, creating the EBO if necessary
+    void setIndices(const std::vector<uint> &indices);
+
     /**
      * @brief Configure attribute bounds for passing attributes to shaders from streamed vector data.
      *
@@ -72,10 +253,35 @@ class VBO {
      */
     template <typename T = float>
     void addAttributeBound(uint index, uint entries, size_t item_size = sizeof(T)) {
-        for (auto bound : this->bounds)
-            if (bound.index == index)
+        this->addAttributeBound(VAOBound{index, item_size, entries, this->dataType, false});
+    }
+
+    /**
+     * @brief Configure an attribute bound stored in a compact format (e.g. half floats or normalized shorts).
+     *        The vertex data for such a VBO is streamed as raw bytes, see `mesh::quantize`.
+     *
+     * @param index The index of the attribute in the shader program
+     * @param entries The number of entries in the attribute (e.g. 3 for a vec3, always 4 for packed types)
+     * @param type The component type of the attribute
+     * @param normalized Whether integer components are normalized to [0, 1]/[-1, 1] when read by the shader
+     */
+    void addAttributeBound(uint index, uint entries, DataType type, bool normalized = false) {
+        if (is_packed_type(type) && entries != 4)
+            throw std::runtime_error("Packed 2_10_10_10 attributes must have 4 entries");
+        this->addAttributeBound(VAOBound{index, data_type_size(type), entries, type, normalized});
+    }
+
+    // Configure an attribute bound from a complete description
+    void addAttributeBound(const VAOBound &bound) {
+        for (auto existing : this->bounds)
+            if (existing.index == bound.index)
                 throw std::runtime_error("Attribute index already bound");
-        this->bounds.push_back({index, item_size, entries});
+        this->bounds.push_back(bound);
+    }
+
+    // Return the registered attribute bounds
+    const std::vector<VAOBound> &getAttributeBounds() const {
+        return this->bounds;
     }
 
     /**
@@ -86,36 +292,55 @@ class VBO {
     void applyAttributeBounds(const std::vector<T> &points) {
         if (this->bounds.size() == 0)
             throw std::runtime_error("No attribute bounds set");
+        if (this->position_vbo > 0)
+            throw std::runtime_error("VBO is split into position and attribute streams");
+        if (this->arena != nullptr)
+            throw std::runtime_error("The vertex data of a VBO in a geometry arena cannot be replaced");
 
         this->use();
-        uint elements_per_entry = 0U;
-        for (auto bound : this->bounds)
-            elements_per_entry += bound.entries;
-
-        assert(this->bounds.size() > 0 && elements_per_entry > 0);
-        this->entry_count = points.size() / elements_per_entry;
         size_t stride = this->stride();
+        assert(stride > 0);
+        this->entry_count = points.size() * sizeof(T) / stride;
+        this->vertex_bytes = points.size() * sizeof(T);
+        this->dirty.clear();
 
-        glBindVertexArray(this->vao);
-        glBindBuffer(static_cast<GLenum>(this->bufferType), this->vbo);
+        auto &state = GLState::get();
+        state.bindVertexArray(this->vao);
+        state.bindBuffer(static_cast<GLenum>(this->bufferType), this->vbo);
         glBufferData(static_cast<GLenum>(this->bufferType), points.size() * sizeof(T), &points[0],
                      static_cast<GLenum>(drawType));
 
         size_t offset{};
         for (auto bound : this->bounds) {
-            LOG(INFO) << "Applying attribute bound (i=" << bound.index
-                      << ") (stride=" << (bound.data_size * bound.entries) << ") (offset=" << offset << ")";
-            // vbo_set_attr_pointer(this->dataType, bound.entries, bound.index, stride, offset);
-            glVertexAttribPointer(bound.index, bound.entries, (GLenum)this->dataType, GL_FALSE, stride, (void *)offset);
+            auto normalized = bound.normalized ? GL_TRUE : GL_FALSE;
+            glVertexAttribPointer(bound.index, bound.entries, (GLenum)bound.type, normalized, stride, (void *)offset);
             glEnableVertexAttribArray(bound.index);
 #ifdef __DEBUG__
-            LOG(DEBUG) << "glVertexAttribPointer(" << bound.index << ", " << bound.entries << ", "
-                       << (GLenum)this->dataType << ", GL_FALSE, " << stride << ", (void *)" << offset << ")";
+            LOG(DEBUG) << "Applying attribute bound (i=" << bound.index << ") (stride=" << bound.bytes()
+                       << ") (offset=" << offset << ")";
+            LOG(DEBUG) << "glVertexAttribPointer(" << bound.index << ", " << bound.entries << ", " << (GLenum)bound.type
+                       << ", " << (bound.normalized ? "GL_TRUE" : "GL_FALSE") << ", " << stride << ", (void *)"
+                       << offset << ")";
             LOG(DEBUG) << "glEnableVertexAttribArray(" << bound.index << ")";
 #endif
-            offset += bound.entries * bound.data_size;
+            offset += bound.bytes();
         }
     }
+
+    /**
+     * @brief Apply the registered attribute bounds as two vertex streams instead of one: the position attribute in
+     *        its own tightly packed buffer, the other attributes interleaved in a second one. The data is given in
+     *        the interleaved layout `applyAttributeBounds` takes. Depth-only passes bind just the position stream
+     *        through `useDepth`, so they do not fetch the other attributes.
+     *
+     * @param points The interleaved vertex data
+     * @param position_index The attribute index of the position (0 by default)
+     * @note Split VBOs do not support range updates (`updateRange`, `flush`)
+     */
+    template <typename T = float>
+    void applySplitAttributeBounds(const std::vector<T> &points, uint position_index = 0U) {
+        this->applySplitBounds(points.data(), points.size() * sizeof(T), position_index);
+    }
 };
 
 }  // namespace goat::gfx
\ No newline at end of file
@@ -6,10 +6,28 @@ namespace goat::gfx {
 
 static constexpr unsigned int DEFAULT_SCREEN_WIDTH = 1600U;
 static constexpr unsigned int DEFAULT_SCREEN_HEIGHT = 900U;
+// The first attribute index used by per-instance model matrices (a mat4 spans 4 attribute slots)
+static constexpr unsigned int INSTANCE_ATTRIBUTE_INDEX = 2U;
+// The uniform buffer binding point of the per-frame `FrameData` block shared by every shader program
+static constexpr unsigned int FRAME_UNIFORM_BINDING = 0U;
+static constexpr const char *FRAME_UNIFORM_BLOCK = "FrameData";
+// The texture unit reserved for `TextureArray` layers, and the sampler/layer uniforms that read them
+static constexpr unsigned int TEXTURE_ARRAY_UNIT = 15U;
+static constexpr const char *TEXTURE_ARRAY_UNIFORM = "texture_array";
+static constexpr const char *TEXTURE_LAYER_UNIFORM = "texture_layer";
+// The number of layers allocated at once for each texture array
+static constexpr unsigned int DEFAULT_ARRAY_LAYERS = 16U;
+// The shader storage binding points of the GPU culling shader's instance and draw command buffers
+static constexpr unsigned int CULL_INSTANCE_BINDING = 0U;
+static constexpr unsigned int CULL_COMMAND_BINDING = 1U;
+// The number of instances culled by each compute work group (`local_size_x` in shaders/cull.comp)
+static constexpr unsigned int CULL_GROUP_SIZE = 64U;
 
 enum class ShaderType {
     VERTEX = GL_VERTEX_SHADER,
     FRAGMENT = GL_FRAGMENT_SHADER,
+    // Requires OpenGL 4.3
+    COMPUTE = GL_COMPUTE_SHADER,
 };
 
 enum class BufferType {
@@ -21,10 +39,41 @@ enum class DrawType {
     DYNAMIC = GL_DYNAMIC_DRAW,
 };
 
+// How `VBO` range updates send changed vertex data to the GPU
+enum class UpdateMode {
+    // glBufferSubData per range (the driver copies the data, or waits if the GPU still reads the buffer)
+    SUB_DATA,
+    // Orphan the storage and upload the whole buffer (never waits on the GPU, but always sends every byte)
+    ORPHAN,
+    // Map each range with glMapBufferRange and GL_MAP_INVALIDATE_RANGE_BIT, and copy the data into it
+    MAP_RANGE,
+    // As MAP_RANGE with GL_MAP_UNSYNCHRONIZED_BIT: the caller guarantees no pending draw reads those ranges
+    MAP_UNSYNCHRONIZED,
+};
+
 enum class DataType {
     FLOAT = GL_FLOAT,
     INT = GL_INT,
     UNSIGNED_INT = GL_UNSIGNED_INT,
+    // Compact vertex attribute types (see `mesh/Quantize.hpp` for the CPU-side encoders)
+    HALF_FLOAT = GL_HALF_FLOAT,
+    SHORT = GL_SHORT,
+    UNSIGNED_SHORT = GL_UNSIGNED_SHORT,
+    BYTE = GL_BYTE,
+    UNSIGNED_BYTE = GL_UNSIGNED_BYTE,
+    // Four components packed into 32 bits: 10 bits each for xyz, 2 bits for w
+    INT_2_10_10_10_REV = GL_INT_2_10_10_10_REV,
+    UNSIGNED_INT_2_10_10_10_REV = GL_UNSIGNED_INT_2_10_10_10_REV,
+};
+
+// Render passes in submission order (a sort key's highest bits)
+enum class RenderPass {
+    // Opaque geometry, drawn front to back
+    SOLID = 0,
+    // Alpha-blended geometry, drawn back to front after all solid geometry
+    TRANSLUCENT = 1,
+    // Geometry drawn on top of the scene
+    OVERLAY = 2,
 };
 
 enum class ObjectLifetime {
@@ -16,11 +16,82 @@ struct BoundTexture {
     const std::string uniform_name;
 };
 
+// An active uniform reflected from a linked shader program
+struct UniformInfo {
+    std::string name;
+    GLint location;
+    GLenum type;
+    GLint size;
+};
+
+// A pre-resolved uniform location, used to set uniforms without a string lookup
+struct UniformHandle {
+    GLint location = -1;
+
+    bool valid() const {
+        return this->location > -1;
+    }
+};
+
+// Return true for the types that pack all four components of an attribute into a single 32-bit value
+inline bool is_packed_type(DataType type) {
+    return type == DataType::INT_2_10_10_10_REV || type == DataType::UNSIGNED_INT_2_10_10_10_REV;
+}
+
+// Return the size in bytes of a single component of the given type (of the whole attribute for packed types)
+inline size_t data_type_size(DataType type) {
+    switch (type) {
+        case DataType::BYTE:
+        case DataType::UNSIGNED_BYTE:
+            return 1;
+        case DataType::HALF_FLOAT:
+        case DataType::SHORT:
+        case DataType::UNSIGNED_SHORT:
+            return 2;
+        default:
+            return 4;
+    }
+}
+
+// The layout of each draw read by glMultiDrawElementsIndirect from the GL_DRAW_INDIRECT_BUFFER
+struct DrawElementsIndirectCommand {
+    uint count;
+    uint instance_count;
+    uint first_index;
+    int base_vertex;
+    uint base_instance;
+};
+static_assert(sizeof(DrawElementsIndirectCommand) == 20, "Indirect draw commands must be tightly packed");
+
+// The buffers and byte offsets the per-instance attributes of a VAO read from, shared by every VBO drawing with that
+// VAO (the VBOs of a `GeometryArena` pool) so that each one re-points the attributes only when another changed them
+struct InstanceSources {
+    // An offset no source is at, so the next VBO using the VAO re-points its attributes (e.g. after a buffer the VAO
+    // reads from was deleted, as its name can be reused)
+    static constexpr size_t UNKNOWN = ~static_cast<size_t>(0UL);
+
+    GLuint instance_source = 0U;
+    size_t instance_offset = 0UL;
+    // A layer source of 0 means every instance reads the constant layer 0
+    GLuint layer_source = 0U;
+    size_t layer_offset = 0UL;
+};
+
 // A small struct for storing attribute bounds for VBOs
 struct VAOBound {
     GLuint index;
     size_t data_size;
     uint entries;
+    // The component type of the attribute
+    DataType type = DataType::FLOAT;
+    // Whether integer components are mapped to [0, 1] (unsigned) or [-1, 1] (signed) when read by the shader
+    bool normalized = false;
+
+    // The number of bytes the attribute occupies in each vertex, padded to keep attributes 4-byte aligned
+    size_t bytes() const {
+        auto size = is_packed_type(this->type) ? this->data_size : this->data_size * this->entries;
+        return (size + 3) & ~static_cast<size_t>(3);
+    }
 };
 
 }  // namespace goat::gfx
\ No newline at end of file
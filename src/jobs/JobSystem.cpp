@@ -0,0 +1,201 @@
+#include "JobSystem.hpp"
+
+#include <easylogging++.h>
+
+#include <exception>
+
+namespace goat::jobs {
+
+namespace {
+
+// The pool the calling thread belongs to, and its index in it
+struct WorkerSlot {
+    const JobSystem *system = nullptr;
+    int index = -1;
+};
+thread_local WorkerSlot current_slot{};
+
+// A cheap per-thread random number, to spread steal attempts over the victims
+uint32_t next_random() {
+    thread_local uint32_t state = static_cast<uint32_t>(std::hash<std::thread::id>{}(std::this_thread::get_id())) | 1U;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+}  // namespace
+
+JobSystem::JobSystem(uint threads) {
+    if (threads == 0)
+        threads = std::max(1U, std::thread::hardware_concurrency());
+    this->thread_count = threads;
+    for (uint i = 0; i < threads; i++)
+        this->deques.push_back(std::make_unique<WorkStealingDeque<Job>>());
+
+    current_slot = WorkerSlot{.system = this, .index = 0};
+    for (uint i = 1; i < threads; i++)
+        this->threads.emplace_back(&JobSystem::workerLoop, this, i);
+    LOG(INFO) << "Started job system with " << threads << " threads";
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(this->sleep_mutex);
+        this->stopping.store(true);
+    }
+    this->wake.notify_all();
+    for (auto &thread : this->threads)
+        thread.join();
+    if (current_slot.system == this)
+        current_slot = WorkerSlot{};
+
+    // Jobs still queued were never waited on: drop them
+    for (auto &deque : this->deques)
+        while (auto job = deque->steal())
+            delete job;
+    for (auto job : this->injected)
+        delete job;
+}
+
+int JobSystem::currentWorker() const {
+    return current_slot.system == this ? current_slot.index : -1;
+}
+
+void JobSystem::run(std::function<void()> fn, JobCounter *counter, JobCounter *after) {
+    auto job = new Job{.fn = std::move(fn), .counter = counter};
+    if (counter != nullptr)
+        counter->pending.fetch_add(1);
+    if (after != nullptr && !after->done()) {
+        std::lock_guard<std::mutex> lock(after->mutex);
+        // Checked again under the lock: the last job of `after` releases the waiting jobs while holding it
+        if (!after->done()) {
+            after->waiting.push_back(job);
+            return;
+        }
+    }
+    this->push(job);
+}
+
+void JobSystem::push(Job *job) {
+    auto worker = this->currentWorker();
+    if (worker >= 0) {
+        this->deques[worker]->push(job);
+    } else {
+        std::lock_guard<std::mutex> lock(this->injected_mutex);
+        this->injected.push_back(job);
+    }
+
+    this->epoch.fetch_add(1);
+    if (this->sleepers.load() > 0) {
+        // Taking the lock orders the notification after a worker that is about to sleep starts waiting
+        { std::lock_guard<std::mutex> lock(this->sleep_mutex); }
+        this->wake.notify_one();
+    }
+}
+
+Job *JobSystem::find(int worker) {
+    if (worker >= 0)
+        if (auto job = this->deques[worker]->pop())
+            return job;
+
+    {
+        std::lock_guard<std::mutex> lock(this->injected_mutex);
+        if (!this->injected.empty()) {
+            auto job = this->injected.back();
+            this->injected.pop_back();
+            return job;
+        }
+    }
+
+    auto count = this->thread_count;
+    auto start = next_random() % count;
+    for (uint i = 0; i < count; i++) {
+        auto victim = (start + i) % count;
+        if (static_cast<int>(victim) == worker)
+            continue;
+        if (auto job = this->deques[victim]->steal()) {
+            this->stolen.fetch_add(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+void JobSystem::execute(Job *job) {
+    auto counter = job->counter;
+    try {
+        job->fn();
+    } catch (...) {
+        if (counter != nullptr) {
+            // Kept for `wait`, before `pending` is lowered so the waiting thread sees it
+            std::lock_guard<std::mutex> lock(counter->mutex);
+            if (!counter->error)
+                counter->error = std::current_exception();
+        } else {
+            // Nothing waits on the job to report its exception to
+            try {
+                throw;
+            } catch (const std::exception &e) {
+                LOG(ERROR) << "Job failed: " << e.what();
+            } catch (...) {
+                LOG(ERROR) << "Job failed with an unknown exception";
+            }
+        }
+    }
+    this->executed.fetch_add(1, std::memory_order_relaxed);
+
+    delete job;
+    if (counter == nullptr)
+        return;
+    counter->releasing.fetch_add(1);
+    if (counter->pending.fetch_sub(1) == 1) {
+        // The last job of the group: start the jobs waiting for it
+        std::vector<Job *> ready;
+        {
+            std::lock_guard<std::mutex> lock(counter->mutex);
+            ready.swap(counter->waiting);
+        }
+        for (auto next : ready)
+            this->push(next);
+    }
+    // The last access to the counter, which its owner may destroy as soon as it is done
+    counter->releasing.fetch_sub(1);
+}
+
+void JobSystem::workerLoop(uint index) {
+    current_slot = WorkerSlot{.system = this, .index = static_cast<int>(index)};
+    while (!this->stopping.load()) {
+        auto seen = this->epoch.load();
+        if (auto job = this->find(static_cast<int>(index))) {
+            this->execute(job);
+            continue;
+        }
+
+        // Nothing found since `seen`: sleep until something is pushed
+        std::unique_lock<std::mutex> lock(this->sleep_mutex);
+        this->sleepers.fetch_add(1);
+        this->wake.wait(lock, [this, seen]() { return this->stopping.load() || this->epoch.load() != seen; });
+        this->sleepers.fetch_sub(1);
+    }
+}
+
+void JobSystem::wait(JobCounter &counter) {
+    auto worker = this->currentWorker();
+    while (!counter.done()) {
+        if (auto job = this->find(worker))
+            this->execute(job);
+        else
+            std::this_thread::yield();
+    }
+
+    std::exception_ptr error{};
+    {
+        std::lock_guard<std::mutex> lock(counter.mutex);
+        error.swap(counter.error);
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
+
+}  // namespace goat::jobs
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../constants.hpp"
+#include "jobs/WorkStealingDeque.hpp"
+
+namespace goat::jobs {
+
+// The number of chunks `parallelFor` splits work into per thread when no grain size is given (for load balancing)
+static constexpr size_t PARALLEL_FOR_CHUNKS_PER_THREAD = 4UL;
+
+class JobCounter;
+
+// A unit of work, and the counter it decrements once run
+struct Job {
+    std::function<void()> fn;
+    JobCounter *counter = nullptr;
+};
+
+/**
+ * @brief Counts the jobs of a group still to run. Waiting on a counter (`JobSystem::wait`) runs other jobs until
+ *        it reaches 0, and jobs submitted `after` a counter only start once it does, which chains groups of jobs
+ *        into a dependency graph. The first exception thrown by one of its jobs is kept and rethrown by `wait`
+ *        once every job has run (the jobs submitted `after` the counter still start).
+ *
+ * @note A counter must outlive the jobs counted by it or waiting on it: wait on it before destroying it.
+ */
+class JobCounter {
+   private:
+    friend class JobSystem;
+
+    std::atomic<uint> pending{0U};
+    // The jobs of the group still finishing: the last one touches the counter after `pending` reaches 0, so the
+    // counter is only done (and may be destroyed) once this is 0 too
+    std::atomic<uint> releasing{0U};
+    // Jobs waiting for the counter to reach 0, and the first exception thrown by a job of the group
+    std::mutex mutex;
+    std::vector<Job *> waiting{};
+    std::exception_ptr error{};
+
+   public:
+    JobCounter() = default;
+    JobCounter(const JobCounter &) = delete;
+    JobCounter &operator=(const JobCounter &) = delete;
+
+    bool done() const {
+        // `releasing` is raised before `pending` is lowered, so it must be read after it
+        return this->pending.load() == 0 && this->releasing.load() == 0;
+    }
+};
+
+struct JobStats {
+    // Jobs run, and how many of them were stolen from another thread's deque
+    size_t executed = 0UL;
+    size_t stolen = 0UL;
+};
+
+/**
+ * @brief A fixed pool of worker threads sharing jobs through work-stealing deques. The thread creating the system
+ *        is worker 0: it does not run jobs in the background, but runs them while it waits on a counter, so a pool
+ *        of N threads starts N - 1 of them. Each worker pushes the jobs it submits to its own deque and pops them
+ *        back (most recent first, while their data is warm in its cache); idle workers steal the oldest jobs of
+ *        the others. Threads outside of the pool submit through a shared, locked queue.
+ */
+class JobSystem {
+   private:
+    uint thread_count;
+    std::vector<std::unique_ptr<WorkStealingDeque<Job>>> deques{};
+    std::vector<std::thread> threads{};
+    // Jobs submitted from threads outside of the pool
+    std::mutex injected_mutex;
+    std::vector<Job *> injected{};
+    // Idle workers sleep until a job is pushed (`epoch` changes) or the system stops
+    std::mutex sleep_mutex;
+    std::condition_variable wake;
+    std::atomic<uint64_t> epoch{0UL};
+    std::atomic<uint> sleepers{0U};
+    std::atomic<bool> stopping{false};
+    std::atomic<size_t> executed{0UL};
+    std::atomic<size_t> stolen{0UL};
+
+    // The index of the calling thread in this pool (-1 outside of it)
+    int currentWorker() const;
+    void push(Job *job);
+    // Take a job from the worker's deque, the shared queue, or another worker (nullptr if there are none)
+    Job *find(int worker);
+    void execute(Job *job);
+    void workerLoop(uint index);
+
+   public:
+    /**
+     * @param threads The number of threads, including the calling thread (0 for one per hardware thread)
+     */
+    explicit JobSystem(uint threads = 0U);
+    JobSystem(const JobSystem &) = delete;
+    ~JobSystem();
+
+    JobSystem &operator=(const JobSystem &) = delete;
+
+    /**
+     * @brief Submit a job
+     * @param fn The work to run on any thread of the pool
+     * @param counter Incremented now and decremented once the job has run (optional)
+     * @param after Only start the job once this counter reaches 0 (optional)
+     */
+    void run(std::function<void()> fn, JobCounter *counter = nullptr, JobCounter *after = nullptr);
+
+    // Run jobs on the calling thread until the counter reaches 0, then rethrow the first exception thrown by one of
+    // its jobs (if any, which clears it)
+    void wait(JobCounter &counter);
+
+    /**
+     * @brief Call `fn(begin, end)` over chunks of [0, count) spread across the pool, returning once every chunk has
+     *        run. The calling thread runs the first chunk itself. If any chunk throws, the first exception is
+     *        rethrown once every chunk has run (they reference `fn`), the calling thread's own taking precedence.
+     * @param grain The number of items per chunk (0 to split the range into a few chunks per thread)
+     */
+    template <typename F>
+    void parallelFor(size_t count, size_t grain, F &&fn) {
+        if (count == 0)
+            return;
+        if (grain == 0)
+            grain = std::max<size_t>(1UL, (count + this->thread_count * PARALLEL_FOR_CHUNKS_PER_THREAD - 1) /
+                                              (this->thread_count * PARALLEL_FOR_CHUNKS_PER_THREAD));
+        if (this->thread_count == 1 || count <= grain) {
+            fn(size_t{0}, count);
+            return;
+        }
+
+        JobCounter counter;
+        for (size_t begin = grain; begin < count; begin += grain) {
+            auto end = std::min(begin + grain, count);
+            this->run([&fn, begin, end]() { fn(begin, end); }, &counter);
+        }
+        try {
+            fn(size_t{0}, grain);
+        } catch (...) {
+            try {
+                this->wait(counter);
+            } catch (...) {
+            }
+            throw;
+        }
+        this->wait(counter);
+    }
+
+    // The number of threads in the pool (including the thread that created it)
+    uint size() const {
+        return this->thread_count;
+    }
+
+    JobStats getStats() const {
+        return JobStats{.executed = this->executed.load(), .stolen = this->stolen.load()};
+    }
+};
+
+}  // namespace goat::jobs
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace goat::jobs {
+
+// The initial number of items a deque holds before growing
+static constexpr int64_t DEFAULT_DEQUE_CAPACITY = 256;
+
+/**
+ * @brief A Chase-Lev work-stealing deque of pointers (Chase & Lev, "Dynamic Circular Work-Stealing Deque", 2005;
+ *        with the C11 memory orderings of Lê et al., "Correct and Efficient Work-Stealing for Weak Memory Models",
+ *        2013). The owning thread pushes and pops at the bottom without locking; any other thread may steal from
+ *        the top. The ring grows when full; replaced rings are kept until the deque is destroyed, as a thief may
+ *        still be reading one.
+ *
+ * @note `push` and `pop` must only be called by the owning thread. `pop` and `steal` return nullptr when the deque
+ *       is empty or a race for the last item was lost.
+ */
+template <typename T>
+class WorkStealingDeque {
+   private:
+    struct Ring {
+        int64_t capacity;
+        std::unique_ptr<std::atomic<T *>[]> items;
+
+        explicit Ring(int64_t capacity) : capacity(capacity), items(new std::atomic<T *>[capacity]) {}
+
+        T *get(int64_t i) const {
+            return this->items[i & (this->capacity - 1)].load(std::memory_order_relaxed);
+        }
+
+        void put(int64_t i, T *item) {
+            this->items[i & (this->capacity - 1)].store(item, std::memory_order_relaxed);
+        }
+    };
+
+    // Thieves take from the top, the owner from the bottom (on separate cache lines to avoid false sharing)
+    alignas(64) std::atomic<int64_t> top{0};
+    alignas(64) std::atomic<int64_t> bottom{0};
+    std::atomic<Ring *> ring;
+    // Every ring ever allocated (owned by the owning thread)
+    std::vector<std::unique_ptr<Ring>> rings{};
+
+   public:
+    explicit WorkStealingDeque(int64_t capacity = DEFAULT_DEQUE_CAPACITY) {
+        // The capacity must be a power of two for the index mask
+        int64_t size = 1;
+        while (size < capacity)
+            size <<= 1;
+        this->rings.push_back(std::make_unique<Ring>(size));
+        this->ring.store(this->rings.back().get(), std::memory_order_relaxed);
+    }
+    WorkStealingDeque(const WorkStealingDeque &) = delete;
+    WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+    void push(T *item) {
+        auto b = this->bottom.load(std::memory_order_relaxed);
+        auto t = this->top.load(std::memory_order_acquire);
+        auto current = this->ring.load(std::memory_order_relaxed);
+        if (b - t > current->capacity - 1) {
+            auto grown = std::make_unique<Ring>(current->capacity * 2);
+            for (auto i = t; i < b; i++)
+                grown->put(i, current->get(i));
+            current = grown.get();
+            this->rings.push_back(std::move(grown));
+            this->ring.store(current, std::memory_order_release);
+        }
+        current->put(b, item);
+        // A release store rather than a release fence and a relaxed store: the same on x86 and ARM, and visible to
+        // ThreadSanitizer, which does not model standalone fences
+        this->bottom.store(b + 1, std::memory_order_release);
+    }
+
+    T *pop() {
+        auto b = this->bottom.load(std::memory_order_relaxed) - 1;
+        auto current = this->ring.load(std::memory_order_relaxed);
+        this->bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto t = this->top.load(std::memory_order_relaxed);
+        if (t > b) {
+            this->bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        auto item = current->get(b);
+        if (t == b) {
+            // The last item: race the thieves for it
+            if (!this->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                item = nullptr;
+            this->bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    T *steal() {
+        auto t = this->top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto b = this->bottom.load(std::memory_order_acquire);
+        if (t >= b)
+            return nullptr;
+        auto item = this->ring.load(std::memory_order_acquire)->get(t);
+        if (!this->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return nullptr;
+        return item;
+    }
+
+    // An estimate of the number of items (exact only when no other thread is using the deque)
+    int64_t size() const {
+        auto b = this->bottom.load(std::memory_order_relaxed);
+        auto t = this->top.load(std::memory_order_relaxed);
+        return b > t ? b - t : 0;
+    }
+};
+
+}  // namespace goat::jobs
@@ -3,6 +3,7 @@
 #include <stdlib.h>
 
 #include <chrono>
+#include <cmath>
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -30,7 +31,14 @@ INITIALIZE_EASYLOGGINGPP
 #include <glm/gtc/type_ptr.hpp>
 
 #include "Window.hpp"
+#include "bench/bench.hpp"
 #include "constants.hpp"
+#include "gfx/TextureLoader.hpp"
+#include "jobs/JobSystem.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/Optimize.hpp"
+#include "mesh/Quantize.hpp"
+#include "mesh/Simplify.hpp"
 #include "world/GameObject.hpp"
 #include "world/Scene.hpp"
 
@@ -58,61 +66,269 @@ const std::vector<float> vertices{
 
 };
 
-const std::vector<unsigned int> indices{0, 1, 3, 1, 2, 3};
 const glm::vec3 cubePositions[] = {glm::vec3(0.0f, 0.0f, 0.0f),    glm::vec3(2.0f, 5.0f, -15.0f),
                                    glm::vec3(-1.5f, -2.2f, -2.5f), glm::vec3(-3.8f, -2.0f, -12.3f),
                                    glm::vec3(2.4f, -0.4f, -3.5f),  glm::vec3(-1.7f, 3.0f, -7.5f),
                                    glm::vec3(1.3f, -2.0f, -2.5f),  glm::vec3(1.5f, 2.0f, -2.5f),
                                    glm::vec3(1.5f, 0.2f, -1.5f),   glm::vec3(-1.3f, 1.0f, -1.5f)};
 
-void run_game() {
+// Command line options for the demo scene
+struct DemoOptions {
+    // Render every cube with a single instanced draw call
+    bool instanced = false;
+    // Number of cubes to place in the scene (anything past the hand-placed 10 is laid out on a grid)
+    size_t cube_count = 10;
+    // Draw every object, even the ones outside of the camera frustum
+    bool no_culling = false;
+    // Cull through the scene's BVH instead of testing every object
+    bool bvh = false;
+    // Hide cubes behind the cubes in front of them with the software occlusion buffer
+    bool occlusion = false;
+    // Cull and draw the cubes on the GPU with compute shaders and multi-draw-indirect (requests an OpenGL 4.3 context)
+    bool gpu_culling = false;
+    // Create the cubes as STATIC objects, merged into chunked world-space batches
+    bool static_batching = false;
+    // Draw spheres with distance-based levels of detail instead of cubes
+    bool lod = false;
+    // Stream the frame uniforms and instance data through a fenced ring buffer ("persistent", "unsynchronized" or
+    // "orphan", empty to upload them to their own buffers)
+    std::string stream{};
+    // Lay down depth in a position-only prepass before shading (the cube VBOs store positions in their own stream)
+    bool depth_prepass = false;
+    // The number of threads of the job system, including the game loop's (0 for one per hardware thread)
+    uint threads = 0U;
+    // Draw on a render thread from snapshots of the scene while the next frame is simulated (without the ImGui menu)
+    bool render_thread = false;
+    // Texture the cubes from texture array layers instead of a single bound texture
+    bool texture_array = false;
+    // Read textures on the job system and upload them over several frames, drawing a placeholder meanwhile
+    bool async_textures = false;
+    // The most texture data uploaded per frame when loading textures in the background, in KB
+    size_t texture_budget = DEFAULT_TEXTURE_UPLOAD_BUDGET / 1024;
+    // Stream the finer mip levels of textures by their size on screen within this many MB (0 loads them whole)
+    size_t texture_memory = 0UL;
+    // Run a headless benchmark by name instead of the demo ("list" prints every benchmark)
+    std::string bench{};
+};
+
+/**
+ * @brief Return the world position of the nth cube. The first 10 cubes keep their hand-placed positions,
+ *        the rest fill a grid in front of the camera for benchmarking large object counts.
+ */
+glm::vec3 cube_position(size_t n, size_t count) {
+    constexpr size_t fixed_count = sizeof(cubePositions) / sizeof(cubePositions[0]);
+    if (n < fixed_count)
+        return cubePositions[n];
+
+    constexpr float spacing = 1.5f;
+    auto side = static_cast<size_t>(std::ceil(std::cbrt(static_cast<double>(count))));
+    auto i = n - fixed_count;
+    auto x = static_cast<float>(i % side) - side / 2.0f;
+    auto y = static_cast<float>((i / side) % side) - side / 2.0f;
+    auto z = static_cast<float>(i / (side * side));
+    return glm::vec3(x * spacing, y * spacing, -5.0f - z * spacing);
+}
+
+DemoOptions parse_options(int argc, char *argv[]) {
+    DemoOptions options{};
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--instanced") {
+            options.instanced = true;
+        } else if (arg == "--no-culling") {
+            options.no_culling = true;
+        } else if (arg == "--bvh") {
+            options.bvh = true;
+        } else if (arg == "--occlusion") {
+            options.occlusion = true;
+        } else if (arg == "--gpu-culling") {
+            options.gpu_culling = true;
+        } else if (arg == "--static") {
+            options.static_batching = true;
+        } else if (arg == "--lod") {
+            options.lod = true;
+        } else if (arg == "--depth-prepass") {
+            options.depth_prepass = true;
+        } else if (arg == "--render-thread") {
+            options.render_thread = true;
+        } else if (arg == "--texture-array") {
+            options.texture_array = true;
+        } else if (arg == "--async-textures") {
+            options.async_textures = true;
+        } else if (arg == "--texture-budget" && i + 1 < argc) {
+            options.async_textures = true;
+            options.texture_budget = std::stoul(argv[++i]);
+        } else if (arg == "--stream-textures" && i + 1 < argc) {
+            options.async_textures = true;
+            options.texture_memory = std::stoul(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            options.threads = static_cast<uint>(std::stoul(argv[++i]));
+        } else if (arg == "--cubes" && i + 1 < argc) {
+            options.cube_count = std::stoul(argv[++i]);
+        } else if (arg == "--stream" && i + 1 < argc) {
+            options.stream = argv[++i];
+        } else if (arg == "--bench" && i + 1 < argc) {
+            options.bench = argv[++i];
+        }
+    }
+    return options;
+}
+
+void run_game(const DemoOptions &options) {
     glfwSetErrorCallback([](int error, const char *description) {
         LOG(ERROR) << "Fatal Error: " << description << "(Code " << error << ")";
     });
 
+    auto gl_target = options.gpu_culling ? gl::glAPI::OPENGL4_3 : gl::glAPI::OPENGL3_3;
     std::unique_ptr<GameWindow> window =
-        std::make_unique<GameWindow>("Hello, World!", EngineConfig{.gl_target = gl::glAPI::OPENGL3_3});
+        std::make_unique<GameWindow>("Hello, World!", EngineConfig{.gl_target = gl_target});
 
     // Load GLAD
     if (!gladLoadGL(glfwGetProcAddress))
         throw std::runtime_error("Failed to load OpenGL functions via GLAD");
+    if (options.gpu_culling && !GPUCuller::supported())
+        LOG(WARNING) << "GPU culling requires OpenGL 4.3, culling on the CPU instead";
+
+    // Worker threads for the per-object work of the scene (the game loop's thread is worker 0)
+    auto job_system = std::make_unique<jobs::JobSystem>(options.threads);
+    // Uploads the textures read by the job system within a per-frame budget, on the thread drawing the frames
+    auto texture_loader = options.async_textures
+                              ? std::make_unique<TextureLoader>(job_system.get(), options.texture_budget * 1024,
+                                                                options.texture_memory * 1024 * 1024)
+                              : nullptr;
 
     window->createCamera();
     window->setFeature(gl::glFeature::DEPTH_TESTING);
 
-    // Create our 3D scene and add our cube vertices
-    world::Scene *scene = world::Scene::create("Main Scene", std::shared_ptr<world::Camera>(window->getCamera()));
+    // Create our 3D scene and add our cube vertices. The render thread draws with its own copy of the camera, updated
+    // from every snapshot, while the window's camera is moved by the simulation
+    auto camera = options.render_thread ? std::make_shared<world::Camera>(*window->getCamera())
+                                        : std::shared_ptr<world::Camera>(window->getCamera());
+    world::Scene *scene = world::Scene::create("Main Scene", camera);
 
-    // Create the VBO buffer for our cube
-    auto vbo = std::make_shared<VBO>(BufferType::ARRAY, DrawType::STATIC, DataType::FLOAT, indices);
-    vbo->addAttributeBound(0, 3);  // XYZ
-    vbo->addAttributeBound(1, 2);  // UV
-    vbo->applyAttributeBounds(vertices);
+    // Positions are stored as half floats and UVs as normalized 16-bit integers (12 bytes per vertex instead of 20)
+    const std::vector<VAOBound> format = {
+        {0, 0, 3, DataType::HALF_FLOAT, false},     // XYZ
+        {1, 0, 2, DataType::UNSIGNED_SHORT, true},  // UV
+    };
+    // The cube and every level of detail share the buffers and VAO of one arena pool, so switching between them does
+    // not rebind the VAO. The depth prepass splits positions into their own stream instead, which the arena's
+    // interleaved pools cannot hold, so those VBOs keep buffers of their own
+    std::shared_ptr<GeometryArena> arena = options.depth_prepass ? nullptr : std::make_shared<GeometryArena>();
+    auto upload = [&format, &arena](const mesh::Mesh &mesh) {
+        auto quantized = mesh::quantize(mesh, format);
+        mesh::logQuantization(mesh, quantized);
+        if (arena != nullptr)
+            return std::make_shared<VBO>(arena, quantized.bounds, quantized.vertices, quantized.indices);
+        auto vbo = std::make_shared<VBO>(BufferType::ARRAY, DrawType::STATIC, DataType::FLOAT, quantized.indices);
+        for (const auto &bound : quantized.bounds)
+            vbo->addAttributeBound(bound);
+        vbo->applySplitAttributeBounds(quantized.vertices);
+        return vbo;
+    };
+
+    // Create the VBO buffer for our cube, merging the shared corners of the triangle list into indexed vertices
+    auto cube = mesh::deduplicate(vertices, 5);
+    std::shared_ptr<const world::LODChain> lods{};
+    if (options.lod) {
+        // A dense sphere the size of a cube, simplified offline into coarser levels with one VBO each
+        cube = mesh::sphere(64, 128, 0.5f);
+        auto chain = std::make_shared<world::LODChain>();
+        for (auto &level : mesh::buildLODChain(cube)) {
+            mesh::optimize(level.mesh);
+            chain->levels.push_back(world::LODLevel{.vbo = upload(level.mesh), .error = level.error});
+        }
+        lods = chain;
+    }
+    mesh::optimize(cube);
+    auto vbo = lods ? lods->levels.front().vbo : upload(cube);
+
+    // Textures that can be picked per object when drawing from texture arrays
+    TextureArrayAllocator texture_arrays{};
+    std::vector<TextureSlot> cube_textures{};
+    if (options.texture_array) {
+        cube_textures.push_back(texture_arrays.load("textures/gaga.dds"));
+        cube_textures.push_back(texture_arrays.load("textures/da_baby_car.dds"));
+    }
 
     // Create cube objects
-    for (int i = 0; i < 10; i++) {
-        auto cube_obj = world::GameObject::create(cubePositions[i], ObjectLifetime::SCENE);
+    auto cube_bounds = world::AABB::fromPoints(cube.vertices.data(), cube.vertexCount(), cube.vertex_size);
+    auto cube_occluder = options.occlusion ? world::Occluder::fromPoints(cube.vertices.data(), cube.vertexCount(),
+                                                                         cube.vertex_size, cube.indices)
+                                           : nullptr;
+    scene->objects.reserve(options.cube_count);
+    auto lifetime = options.static_batching ? ObjectLifetime::STATIC : ObjectLifetime::SCENE;
+    auto cube_mesh = options.static_batching ? std::make_shared<const mesh::Mesh>(cube) : nullptr;
+    for (size_t i = 0; i < options.cube_count; i++) {
+        auto cube_obj = world::GameObject::create(cube_position(i, options.cube_count), lifetime);
+        cube_obj->bounds = cube_bounds;
+        cube_obj->mesh = cube_mesh;
+        cube_obj->occluder = cube_occluder;
+        cube_obj->lods = lods;
+        if (!cube_textures.empty())
+            cube_obj->texture = cube_textures[i % cube_textures.size()];
         scene->objects.push_back(cube_obj);
     }
+    scene->instanced = options.instanced || options.gpu_culling;
+    scene->culling = !options.no_culling;
+    scene->spatial_index = options.bvh;
+    scene->occlusion_culling = options.occlusion;
+    scene->gpu_culling = options.gpu_culling;
+    scene->static_batching = options.static_batching;
+    scene->depth_prepass = options.depth_prepass;
+    scene->jobs = job_system.get();
+    LOG(INFO) << "Created " << options.cube_count << (options.lod ? " spheres (" : " cubes (")
+              << (scene->instanced ? "instanced" : "per-object") << " rendering)";
 
     scene->render_context->useVBO(vbo);
-    scene->render_context->loadShader("shaders/basic.vert", ShaderType::VERTEX);
-    scene->render_context->loadShader("shaders/basic.frag", ShaderType::FRAGMENT);
-    scene->render_context->loadTexture("textures/gaga.dds", "texture1");
+    if (scene->instanced)
+        scene->render_context->loadShader("shaders/instanced.vert", ShaderType::VERTEX);
+    else
+        scene->render_context->loadShader("shaders/basic.vert", ShaderType::VERTEX);
+    if (options.texture_array) {
+        scene->render_context->loadShader("shaders/array.frag", ShaderType::FRAGMENT);
+    } else {
+        scene->render_context->loadShader("shaders/basic.frag", ShaderType::FRAGMENT);
+        scene->render_context->loadTexture("textures/gaga.dds", "texture1", texture_loader.get());
+    }
+
+    if (!options.stream.empty()) {
+        auto mode = StreamMode::PERSISTENT;
+        if (options.stream == "unsynchronized")
+            mode = StreamMode::UNSYNCHRONIZED;
+        else if (options.stream == "orphan")
+            mode = StreamMode::ORPHAN;
+        else if (options.stream != "persistent")
+            throw std::runtime_error("Unknown stream mode: " + options.stream);
+        scene->stream = window->enableStreaming(mode);
+    }
 
     scene->use();
+    scene->updateStaticBatches();
 
-    window->loop([scene]() {
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
-        ImGui::ShowDemoWindow();
+    if (options.render_thread) {
+        // The ImGui GLFW backend reads input on the thread handling events, so the menu is left out
+        window->loop([scene](world::SceneSnapshot &snapshot) { scene->capture(snapshot); },
+                     [scene, loader = texture_loader.get()](const world::SceneSnapshot &snapshot) {
+                         if (loader != nullptr)
+                             loader->update();
+                         scene->render(snapshot);
+                     });
+    } else {
+        window->loop([scene, loader = texture_loader.get()]() {
+            ImGui_ImplOpenGL3_NewFrame();
+            ImGui_ImplGlfw_NewFrame();
+            ImGui::NewFrame();
+            ImGui::ShowDemoWindow();
 
-        scene->render();
+            if (loader != nullptr)
+                loader->update();
+            scene->render();
 
-        ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-    });
+            ImGui::Render();
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        });
+    }
 
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
@@ -128,7 +344,18 @@ int main(int argc, char *argv[]) {
     }
 
     try {
-        run_game();
+        auto options = parse_options(argc, argv);
+        if (options.bench == "list") {
+            bench::list();
+            return 0;
+        } else if (!options.bench.empty()) {
+            if (bench::run(options.bench))
+                return 0;
+            LOG(ERROR) << "Unknown benchmark '" << options.bench << "' (use --bench list)";
+            return 1;
+        }
+
+        run_game(options);
         return 0;
     } catch (const std::exception &e) {
         LOG(ERROR) << e.what();
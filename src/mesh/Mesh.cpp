@@ -0,0 +1,108 @@
+#include "Mesh.hpp"
+
+#include <easylogging++.h>
+
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace goat::mesh {
+
+namespace {
+
+// Hashes/compares vertices by their bit pattern, so that the map keys can be indices into the vertex array
+struct VertexHash {
+    const float *data;
+    uint vertex_size;
+
+    size_t operator()(uint index) const {
+        // FNV-1a over the raw bytes of the vertex
+        auto bytes = reinterpret_cast<const unsigned char *>(this->data + static_cast<size_t>(index) * vertex_size);
+        size_t hash = 14695981039346656037ULL;
+        for (size_t i = 0; i < vertex_size * sizeof(float); i++) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+};
+
+struct VertexEqual {
+    const float *data;
+    uint vertex_size;
+
+    bool operator()(uint a, uint b) const {
+        return std::memcmp(this->data + static_cast<size_t>(a) * vertex_size,
+                           this->data + static_cast<size_t>(b) * vertex_size, vertex_size * sizeof(float)) == 0;
+    }
+};
+
+Mesh deduplicate_indexed(const float *data, size_t vertex_count, uint vertex_size, const uint *indices,
+                         size_t index_count) {
+    Mesh mesh{.vertices = {}, .indices = {}, .vertex_size = vertex_size};
+    mesh.indices.reserve(index_count);
+
+    std::unordered_map<uint, uint, VertexHash, VertexEqual> unique(vertex_count, VertexHash{data, vertex_size},
+                                                                    VertexEqual{data, vertex_size});
+    for (size_t i = 0; i < index_count; i++) {
+        auto source = indices ? indices[i] : static_cast<uint>(i);
+        if (source >= vertex_count)
+            throw std::runtime_error("Mesh index out of range");
+
+        auto [it, inserted] = unique.try_emplace(source, static_cast<uint>(mesh.vertexCount()));
+        if (inserted) {
+            auto vertex = data + static_cast<size_t>(source) * vertex_size;
+            mesh.vertices.insert(mesh.vertices.end(), vertex, vertex + vertex_size);
+        }
+        mesh.indices.push_back(it->second);
+    }
+
+    LOG(INFO) << "[mesh] deduplicated " << vertex_count << " vertices into " << mesh.vertexCount() << " ("
+              << mesh.indices.size() << " indices)";
+    return mesh;
+}
+
+}  // namespace
+
+Mesh deduplicate(const std::vector<float> &vertices, uint vertex_size) {
+    if (vertex_size == 0 || vertices.size() % vertex_size != 0)
+        throw std::runtime_error("Vertex data is not a multiple of the vertex size");
+    auto vertex_count = vertices.size() / vertex_size;
+    if (vertex_count % 3 != 0)
+        throw std::runtime_error("Non-indexed vertex data must be a triangle list");
+
+    return deduplicate_indexed(vertices.data(), vertex_count, vertex_size, nullptr, vertex_count);
+}
+
+Mesh deduplicate(const Mesh &mesh) {
+    return deduplicate_indexed(mesh.vertices.data(), mesh.vertexCount(), mesh.vertex_size, mesh.indices.data(),
+                               mesh.indices.size());
+}
+
+Mesh sphere(uint rings, uint segments, float radius) {
+    if (rings < 2 || segments < 3)
+        throw std::runtime_error("A sphere needs at least 2 rings and 3 segments");
+
+    Mesh sphere{.vertices = {}, .indices = {}, .vertex_size = 5};
+    for (uint r = 0; r <= rings; r++) {
+        auto phi = static_cast<float>(M_PI) * r / rings;
+        for (uint s = 0; s <= segments; s++) {
+            auto theta = 2.0f * static_cast<float>(M_PI) * s / segments;
+            sphere.vertices.insert(sphere.vertices.end(),
+                                   {radius * std::sin(phi) * std::cos(theta), radius * std::cos(phi),
+                                    radius * std::sin(phi) * std::sin(theta), static_cast<float>(s) / segments,
+                                    static_cast<float>(r) / rings});
+        }
+    }
+    for (uint r = 0; r < rings; r++) {
+        for (uint s = 0; s < segments; s++) {
+            uint i = r * (segments + 1) + s;
+            sphere.indices.insert(sphere.indices.end(), {i, i + segments + 1, i + 1});
+            sphere.indices.insert(sphere.indices.end(), {i + 1, i + segments + 1, i + segments + 2});
+        }
+    }
+    return sphere;
+}
+
+}  // namespace goat::mesh
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "constants.hpp"
+
+namespace goat::mesh {
+
+/**
+ * @brief CPU-side indexed triangle mesh. Vertices are interleaved floats (e.g. XYZ+UV), `vertex_size` floats
+ *        per vertex, in the same layout that is streamed into a `gfx::VBO` by `applyAttributeBounds`.
+ */
+struct Mesh {
+    std::vector<float> vertices;
+    std::vector<uint> indices;
+    // The number of floats per vertex
+    uint vertex_size = 0U;
+
+    size_t vertexCount() const {
+        return this->vertex_size > 0 ? this->vertices.size() / this->vertex_size : 0UL;
+    }
+
+    size_t triangleCount() const {
+        return this->indices.size() / 3;
+    }
+
+    // Return a pointer to the first float of a vertex
+    const float *vertex(size_t index) const {
+        return &this->vertices[index * this->vertex_size];
+    }
+};
+
+/**
+ * @brief Import a non-indexed triangle list (every 3 vertices form a triangle) by merging bit-identical vertices,
+ *        producing unique vertices plus an index buffer. Vertices keep the order of their first occurrence.
+ * @param vertices Interleaved vertex data
+ * @param vertex_size The number of floats per vertex
+ */
+Mesh deduplicate(const std::vector<float> &vertices, uint vertex_size);
+
+/**
+ * @brief Import an indexed mesh, merging any duplicate vertices it contains and remapping its indices
+ */
+Mesh deduplicate(const Mesh &mesh);
+
+/**
+ * @brief Generate a UV sphere (XYZ+UV, 5 floats per vertex), ring by ring from the top pole. Vertices on the UV
+ *        seam and at the poles are duplicated with different UVs.
+ */
+Mesh sphere(uint rings, uint segments, float radius = 1.0f);
+
+}  // namespace goat::mesh
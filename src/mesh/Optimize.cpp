@@ -0,0 +1,295 @@
+#include "Optimize.hpp"
+
+#include <easylogging++.h>
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace goat::mesh {
+
+namespace {
+
+// Triangles adjacent to each vertex, stored as a flat CSR-style array
+struct Adjacency {
+    std::vector<uint> offsets;
+    std::vector<uint> triangles;
+
+    Adjacency(const Mesh &mesh) : offsets(mesh.vertexCount() + 1, 0U) {
+        for (auto index : mesh.indices)
+            ++this->offsets[index + 1];
+        std::partial_sum(this->offsets.begin(), this->offsets.end(), this->offsets.begin());
+
+        this->triangles.resize(mesh.indices.size());
+        std::vector<uint> cursor(this->offsets.begin(), this->offsets.end() - 1);
+        for (size_t i = 0; i < mesh.indices.size(); i++)
+            this->triangles[cursor[mesh.indices[i]]++] = static_cast<uint>(i / 3);
+    }
+};
+
+// A FIFO post-transform vertex cache simulation
+class FifoCache {
+   private:
+    std::vector<uint> entries;
+    size_t head = 0;
+
+   public:
+    FifoCache(uint size) : entries(size, ~0U) {}
+
+    // Access a vertex, returning true on a cache miss
+    bool access(uint vertex) {
+        if (std::find(this->entries.begin(), this->entries.end(), vertex) != this->entries.end())
+            return false;
+        this->entries[this->head] = vertex;
+        this->head = (this->head + 1) % this->entries.size();
+        return true;
+    }
+
+    void clear() {
+        std::fill(this->entries.begin(), this->entries.end(), ~0U);
+        this->head = 0;
+    }
+};
+
+// Count the cache misses of the triangles in [begin, end) starting from an empty cache
+size_t count_misses(const Mesh &mesh, size_t begin, size_t end, uint cache_size) {
+    FifoCache cache(cache_size);
+    size_t misses = 0;
+    for (auto i = begin; i < end; i++)
+        misses += cache.access(mesh.indices[i]);
+    return misses;
+}
+
+}  // namespace
+
+std::vector<size_t> optimizeVertexCache(Mesh &mesh, uint cache_size) {
+    auto vertex_count = mesh.vertexCount();
+    auto triangle_count = mesh.triangleCount();
+    if (triangle_count == 0)
+        return {0};
+    if (mesh.indices.size() % 3 != 0)
+        throw std::runtime_error("Index buffer is not a triangle list");
+
+    Adjacency adjacency(mesh);
+    std::vector<uint> live(vertex_count, 0U);
+    for (auto index : mesh.indices)
+        ++live[index];
+
+    // `cache_time[v]` is the timestamp at which v entered the simulated cache; it is still cached while
+    // `time - cache_time[v] < cache_size`
+    std::vector<uint> cache_time(vertex_count, 0U);
+    std::vector<bool> emitted(triangle_count, false);
+    std::vector<uint> dead_end;
+    std::vector<uint> candidates;
+    std::vector<uint> output;
+    std::vector<size_t> clusters{0};
+    output.reserve(mesh.indices.size());
+
+    uint time = cache_size + 1;
+    size_t cursor = 0;
+    int fanning = 0;
+    while (fanning >= 0) {
+        // Emit every remaining triangle around the fanning vertex
+        candidates.clear();
+        auto vertex = static_cast<uint>(fanning);
+        for (auto t = adjacency.offsets[vertex]; t < adjacency.offsets[vertex + 1]; t++) {
+            auto triangle = adjacency.triangles[t];
+            if (emitted[triangle])
+                continue;
+            emitted[triangle] = true;
+            for (uint corner = 0; corner < 3; corner++) {
+                auto v = mesh.indices[triangle * 3 + corner];
+                output.push_back(v);
+                dead_end.push_back(v);
+                candidates.push_back(v);
+                --live[v];
+                if (time - cache_time[v] > cache_size)
+                    cache_time[v] = time++;
+            }
+        }
+
+        // Pick the candidate that will still be in the cache after its remaining triangles are emitted,
+        // preferring the oldest one
+        fanning = -1;
+        int best_priority = -1;
+        for (auto v : candidates) {
+            if (live[v] == 0)
+                continue;
+            int priority = 0;
+            if (time - cache_time[v] + 2 * live[v] <= cache_size)
+                priority = static_cast<int>(time - cache_time[v]);
+            if (priority > best_priority) {
+                best_priority = priority;
+                fanning = static_cast<int>(v);
+            }
+        }
+
+        if (fanning == -1) {
+            // Dead end: backtrack through recently emitted vertices, then fall back to a linear scan.
+            // Either way the next triangles are not connected to the last ones, so a new cluster starts.
+            while (!dead_end.empty() && fanning == -1) {
+                auto v = dead_end.back();
+                dead_end.pop_back();
+                if (live[v] > 0)
+                    fanning = static_cast<int>(v);
+            }
+            while (fanning == -1 && cursor < vertex_count) {
+                if (live[cursor] > 0)
+                    fanning = static_cast<int>(cursor);
+                ++cursor;
+            }
+            if (fanning != -1 && output.size() > clusters.back())
+                clusters.push_back(output.size());
+        }
+    }
+
+    assert(output.size() == mesh.indices.size());
+    mesh.indices.swap(output);
+    return clusters;
+}
+
+std::vector<size_t> splitClusters(const Mesh &mesh, const std::vector<size_t> &clusters, uint cache_size,
+                                  float threshold) {
+    std::vector<size_t> split;
+    split.reserve(clusters.size());
+    for (size_t c = 0; c < clusters.size(); c++) {
+        auto begin = clusters[c];
+        auto end = c + 1 < clusters.size() ? clusters[c + 1] : mesh.indices.size();
+        auto cluster_acmr = static_cast<float>(count_misses(mesh, begin, end, cache_size)) /
+                            static_cast<float>((end - begin) / 3);
+
+        // Cut wherever the triangles since the last cut already match the cluster's cache efficiency
+        split.push_back(begin);
+        FifoCache cache(cache_size);
+        size_t misses = 0;
+        for (auto i = begin; i + 3 <= end; i += 3) {
+            for (uint corner = 0; corner < 3; corner++)
+                misses += cache.access(mesh.indices[i + corner]);
+
+            auto triangles = (i + 3 - split.back()) / 3;
+            if (i + 3 < end && triangles >= cache_size &&
+                static_cast<float>(misses) / static_cast<float>(triangles) <= cluster_acmr * threshold) {
+                split.push_back(i + 3);
+                cache.clear();
+                misses = 0;
+            }
+        }
+    }
+    return split;
+}
+
+void optimizeOverdraw(Mesh &mesh, const std::vector<size_t> &hard_clusters, uint cache_size, float threshold) {
+    if (mesh.vertex_size < 3 || mesh.indices.empty())
+        return;
+
+    auto clusters = splitClusters(mesh, hard_clusters, cache_size, threshold);
+    if (clusters.size() < 2)
+        return;
+
+    // Positions are the first three floats of each vertex
+    auto position = [&mesh](uint index) {
+        auto vertex = mesh.vertex(index);
+        return vec3(vertex[0], vertex[1], vertex[2]);
+    };
+
+    vec3 center(0.0f);
+    for (size_t v = 0; v < mesh.vertexCount(); v++)
+        center += position(static_cast<uint>(v));
+    center = center / static_cast<float>(mesh.vertexCount());
+
+    struct Cluster {
+        size_t begin;
+        size_t end;
+        float sort_key;
+    };
+    std::vector<Cluster> sorted;
+    sorted.reserve(clusters.size());
+    for (size_t c = 0; c < clusters.size(); c++) {
+        auto begin = clusters[c];
+        auto end = c + 1 < clusters.size() ? clusters[c + 1] : mesh.indices.size();
+
+        // Area-weighted centroid and normal of the cluster
+        vec3 centroid(0.0f);
+        vec3 normal(0.0f);
+        float area = 0.0f;
+        for (auto i = begin; i < end; i += 3) {
+            auto a = position(mesh.indices[i]);
+            auto b = position(mesh.indices[i + 1]);
+            auto c_ = position(mesh.indices[i + 2]);
+            auto n = glm::cross(b - a, c_ - a);
+            auto triangle_area = glm::length(n);
+            centroid += (a + b + c_) * (triangle_area / 3.0f);
+            normal += n;
+            area += triangle_area;
+        }
+        if (area > 0.0f)
+            centroid = centroid / area;
+        auto normal_length = glm::length(normal);
+        if (normal_length > 0.0f)
+            normal = normal / normal_length;
+
+        sorted.push_back(Cluster{.begin = begin, .end = end, .sort_key = glm::dot(centroid - center, normal)});
+    }
+
+    // Clusters facing outwards occlude the rest of the mesh, so they go first
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const Cluster &a, const Cluster &b) { return a.sort_key > b.sort_key; });
+
+    std::vector<uint> output;
+    output.reserve(mesh.indices.size());
+    for (const auto &cluster : sorted)
+        output.insert(output.end(), mesh.indices.begin() + cluster.begin, mesh.indices.begin() + cluster.end);
+    mesh.indices.swap(output);
+}
+
+void optimizeVertexFetch(Mesh &mesh) {
+    constexpr uint unused = ~0U;
+    std::vector<uint> remap(mesh.vertexCount(), unused);
+    std::vector<float> vertices;
+    vertices.reserve(mesh.vertices.size());
+
+    uint next = 0;
+    for (auto &index : mesh.indices) {
+        if (remap[index] == unused) {
+            remap[index] = next++;
+            auto vertex = mesh.vertex(index);
+            vertices.insert(vertices.end(), vertex, vertex + mesh.vertex_size);
+        }
+        index = remap[index];
+    }
+    mesh.vertices.swap(vertices);
+}
+
+CacheStats analyzeVertexCache(const Mesh &mesh, uint cache_size) {
+    if (mesh.indices.empty())
+        return CacheStats{};
+
+    std::vector<bool> referenced(mesh.vertexCount(), false);
+    size_t unique = 0;
+    for (auto index : mesh.indices) {
+        if (!referenced[index]) {
+            referenced[index] = true;
+            ++unique;
+        }
+    }
+    auto misses = count_misses(mesh, 0, mesh.indices.size(), cache_size);
+
+    return CacheStats{
+        .acmr = static_cast<float>(misses) / static_cast<float>(mesh.triangleCount()),
+        .atvr = static_cast<float>(misses) / static_cast<float>(unique),
+    };
+}
+
+void optimize(Mesh &mesh, uint cache_size) {
+    auto before = analyzeVertexCache(mesh, cache_size);
+    auto clusters = optimizeVertexCache(mesh, cache_size);
+    optimizeOverdraw(mesh, clusters, cache_size);
+    optimizeVertexFetch(mesh);
+    auto after = analyzeVertexCache(mesh, cache_size);
+
+    LOG(INFO) << "[mesh] optimized " << mesh.triangleCount() << " triangles (" << clusters.size()
+              << " clusters): ACMR " << before.acmr << " -> " << after.acmr << ", ATVR " << before.atvr << " -> "
+              << after.atvr;
+}
+
+}  // namespace goat::mesh
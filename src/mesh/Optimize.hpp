@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+
+#include "mesh/Mesh.hpp"
+
+namespace goat::mesh {
+
+// The post-transform vertex cache size targeted by the optimizations (a conservative value for modern GPUs)
+static constexpr uint DEFAULT_CACHE_SIZE = 16U;
+
+// Vertex cache statistics for an index buffer, simulated with a FIFO cache
+struct CacheStats {
+    // Average cache miss ratio: transformed vertices per triangle (0.5 is ideal for large regular meshes, 3 worst)
+    float acmr = 0.0f;
+    // Average transform to vertex ratio: transformed vertices per unique vertex (1.0 is ideal)
+    float atvr = 0.0f;
+};
+
+/**
+ * @brief Reorder the triangles of a mesh for the post-transform vertex cache (Tipsify, Sander et al. 2007).
+ *        The returned offsets mark the first index of each cluster, split where the algorithm had to jump to a
+ *        disconnected part of the mesh; they are consumed by `optimizeOverdraw`.
+ * @param cache_size The cache size to optimize for
+ * @return The index offsets at which each cluster starts (always starting with 0)
+ */
+std::vector<size_t> optimizeVertexCache(Mesh &mesh, uint cache_size = DEFAULT_CACHE_SIZE);
+
+/**
+ * @brief Split clusters further wherever the triangles since the last split already reach the vertex cache
+ *        efficiency of the whole cluster (within `threshold`), so they can be reordered without hurting it.
+ * @return The refined cluster offsets
+ */
+std::vector<size_t> splitClusters(const Mesh &mesh, const std::vector<size_t> &clusters, uint cache_size,
+                                  float threshold);
+
+/**
+ * @brief Reorder clusters of triangles so that the ones facing away from the mesh center are drawn first, which
+ *        lets early depth testing reject more of the fragments behind them. Triangles are only moved as whole
+ *        clusters, so the vertex cache efficiency inside each cluster is kept.
+ * @param clusters The cluster offsets returned by `optimizeVertexCache`
+ * @param threshold How much worse (as an ACMR ratio) a split cluster may be than the cluster it came from
+ */
+void optimizeOverdraw(Mesh &mesh, const std::vector<size_t> &clusters, uint cache_size = DEFAULT_CACHE_SIZE,
+                      float threshold = 1.05f);
+
+/**
+ * @brief Reorder the vertices to match the order in which the index buffer first references them, so vertex
+ *        fetches walk through memory linearly. Unreferenced vertices are removed.
+ */
+void optimizeVertexFetch(Mesh &mesh);
+
+// Simulate a FIFO vertex cache of `cache_size` entries over the index buffer
+CacheStats analyzeVertexCache(const Mesh &mesh, uint cache_size = DEFAULT_CACHE_SIZE);
+
+/**
+ * @brief Run the full pipeline (vertex cache, overdraw, vertex fetch) on a mesh before it is uploaded,
+ *        logging the vertex cache statistics before and after.
+ */
+void optimize(Mesh &mesh, uint cache_size = DEFAULT_CACHE_SIZE);
+
+}  // namespace goat::mesh
@@ -0,0 +1,295 @@
+#include "Quantize.hpp"
+
+#include <easylogging++.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+namespace goat::mesh {
+
+namespace {
+
+// The width and signedness of one component of an integer attribute
+struct IntegerFormat {
+    uint bits;
+    bool is_signed;
+};
+
+IntegerFormat integer_format(gfx::DataType type, uint component) {
+    switch (type) {
+        case gfx::DataType::BYTE:
+            return {8, true};
+        case gfx::DataType::UNSIGNED_BYTE:
+            return {8, false};
+        case gfx::DataType::SHORT:
+            return {16, true};
+        case gfx::DataType::UNSIGNED_SHORT:
+            return {16, false};
+        case gfx::DataType::INT:
+            return {32, true};
+        case gfx::DataType::UNSIGNED_INT:
+            return {32, false};
+        case gfx::DataType::INT_2_10_10_10_REV:
+            return {component < 3 ? 10U : 2U, true};
+        case gfx::DataType::UNSIGNED_INT_2_10_10_10_REV:
+            return {component < 3 ? 10U : 2U, false};
+        default:
+            throw std::runtime_error("Not an integer attribute type");
+    }
+}
+
+const char *type_name(gfx::DataType type) {
+    switch (type) {
+        case gfx::DataType::FLOAT:
+            return "float";
+        case gfx::DataType::HALF_FLOAT:
+            return "half";
+        case gfx::DataType::INT:
+            return "int32";
+        case gfx::DataType::UNSIGNED_INT:
+            return "uint32";
+        case gfx::DataType::SHORT:
+            return "int16";
+        case gfx::DataType::UNSIGNED_SHORT:
+            return "uint16";
+        case gfx::DataType::BYTE:
+            return "int8";
+        case gfx::DataType::UNSIGNED_BYTE:
+            return "uint8";
+        case gfx::DataType::INT_2_10_10_10_REV:
+            return "int 10_10_10_2";
+        case gfx::DataType::UNSIGNED_INT_2_10_10_10_REV:
+            return "uint 10_10_10_2";
+    }
+    return "unknown";
+}
+
+// Encode one component into the low `bits` of the result, setting `clamped` if it did not fit
+uint32_t encode_component(const gfx::VAOBound &bound, uint component, float value, bool &clamped) {
+    if (bound.type == gfx::DataType::FLOAT) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+    if (bound.type == gfx::DataType::HALF_FLOAT) {
+        clamped = std::isfinite(value) && std::fabs(value) > 65504.0f;
+        return encode_half(std::clamp(value, -65504.0f, 65504.0f));
+    }
+
+    auto format = integer_format(bound.type, component);
+    if (bound.normalized) {
+        auto limit = format.is_signed ? 1.0f : 0.0f;
+        clamped = value > 1.0f || value < -limit;
+        auto code = format.is_signed ? static_cast<uint32_t>(encode_snorm(value, format.bits))
+                                     : encode_unorm(value, format.bits);
+        return format.bits < 32 ? code & ((1U << format.bits) - 1) : code;
+    }
+
+    auto max = format.is_signed ? (1LL << (format.bits - 1)) - 1 : (1LL << format.bits) - 1;
+    auto min = format.is_signed ? -max - 1 : 0LL;
+    auto code = std::llround(static_cast<double>(value));
+    clamped = code < min || code > max;
+    code = std::clamp(code, min, max);
+    return format.bits < 32 ? static_cast<uint32_t>(code) & ((1U << format.bits) - 1) : static_cast<uint32_t>(code);
+}
+
+float decode_component(const gfx::VAOBound &bound, uint component, uint32_t code) {
+    if (bound.type == gfx::DataType::FLOAT) {
+        float value;
+        std::memcpy(&value, &code, sizeof(value));
+        return value;
+    }
+    if (bound.type == gfx::DataType::HALF_FLOAT)
+        return decode_half(static_cast<uint16_t>(code));
+
+    auto format = integer_format(bound.type, component);
+    auto value = static_cast<int64_t>(code);
+    if (format.is_signed && (code >> (format.bits - 1)) & 1U)
+        value -= 1LL << format.bits;
+    if (!bound.normalized)
+        return static_cast<float>(value);
+
+    auto max = format.is_signed ? (1LL << (format.bits - 1)) - 1 : (1LL << format.bits) - 1;
+    return std::max(static_cast<float>(static_cast<double>(value) / static_cast<double>(max)), -1.0f);
+}
+
+}  // namespace
+
+uint16_t encode_half(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000U;
+    uint32_t magnitude = bits & 0x7FFFFFFFU;
+
+    // Infinity and NaN (keeping NaN quiet)
+    if (magnitude >= 0x7F800000U)
+        return static_cast<uint16_t>(sign | 0x7C00U | (magnitude > 0x7F800000U ? 0x200U : 0U));
+    // Anything that rounds past the largest half (65504) overflows to infinity
+    if (magnitude >= 0x477FF000U)
+        return static_cast<uint16_t>(sign | 0x7C00U);
+    // Below 2^-14 the result is subnormal: scaling by 2^24 is exact, and the default rounding mode is to nearest even
+    if (magnitude < 0x38800000U) {
+        float abs_value;
+        std::memcpy(&abs_value, &magnitude, sizeof(abs_value));
+        return static_cast<uint16_t>(sign | static_cast<uint32_t>(std::nearbyint(abs_value * 16777216.0f)));
+    }
+
+    // Rebias the exponent (127 -> 15) and round the mantissa from 23 to 10 bits, ties to even
+    uint32_t half = magnitude - 0x38000000U;
+    half += 0xFFFU + ((half >> 13) & 1U);
+    return static_cast<uint16_t>(sign | (half >> 13));
+}
+
+float decode_half(uint16_t half) {
+    uint32_t sign = static_cast<uint32_t>(half & 0x8000U) << 16;
+    uint32_t exponent = (half >> 10) & 0x1FU;
+    uint32_t mantissa = half & 0x3FFU;
+    if (exponent == 0) {
+        auto value = std::ldexp(static_cast<float>(mantissa), -24);
+        return sign ? -value : value;
+    }
+
+    uint32_t bits = exponent == 0x1FU ? sign | 0x7F800000U | (mantissa << 13)
+                                      : sign | ((exponent + 112U) << 23) | (mantissa << 13);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+int32_t encode_snorm(float value, uint bits) {
+    auto max = static_cast<double>((1LL << (bits - 1)) - 1);
+    return static_cast<int32_t>(std::llround(std::clamp(static_cast<double>(value), -1.0, 1.0) * max));
+}
+
+uint32_t encode_unorm(float value, uint bits) {
+    auto max = static_cast<double>((1LL << bits) - 1);
+    return static_cast<uint32_t>(std::llround(std::clamp(static_cast<double>(value), 0.0, 1.0) * max));
+}
+
+size_t encode_attribute(const gfx::VAOBound &bound, const float *values, uint8_t *out) {
+    size_t clamped = 0;
+    bool component_clamped = false;
+    if (gfx::is_packed_type(bound.type)) {
+        uint32_t packed = 0U;
+        for (uint c = 0; c < 4; c++) {
+            component_clamped = false;
+            packed |= encode_component(bound, c, values[c], component_clamped) << (c * 10);
+            clamped += component_clamped;
+        }
+        std::memcpy(out, &packed, sizeof(packed));
+        return clamped;
+    }
+
+    auto size = gfx::data_type_size(bound.type);
+    for (uint c = 0; c < bound.entries; c++) {
+        component_clamped = false;
+        auto code = encode_component(bound, c, values[c], component_clamped);
+        clamped += component_clamped;
+        if (size == 1) {
+            auto narrow = static_cast<uint8_t>(code);
+            std::memcpy(out + c, &narrow, size);
+        } else if (size == 2) {
+            auto narrow = static_cast<uint16_t>(code);
+            std::memcpy(out + c * size, &narrow, size);
+        } else {
+            std::memcpy(out + c * size, &code, size);
+        }
+    }
+    return clamped;
+}
+
+void decode_attribute(const gfx::VAOBound &bound, const uint8_t *data, float *values) {
+    if (gfx::is_packed_type(bound.type)) {
+        uint32_t packed;
+        std::memcpy(&packed, data, sizeof(packed));
+        for (uint c = 0; c < 4; c++) {
+            auto bits = c < 3 ? 10U : 2U;
+            values[c] = decode_component(bound, c, (packed >> (c * 10)) & ((1U << bits) - 1));
+        }
+        return;
+    }
+
+    auto size = gfx::data_type_size(bound.type);
+    for (uint c = 0; c < bound.entries; c++) {
+        uint32_t code = 0U;
+        if (size == 1) {
+            uint8_t narrow;
+            std::memcpy(&narrow, data + c, size);
+            code = narrow;
+        } else if (size == 2) {
+            uint16_t narrow;
+            std::memcpy(&narrow, data + c * size, size);
+            code = narrow;
+        } else {
+            std::memcpy(&code, data + c * size, size);
+        }
+        values[c] = decode_component(bound, c, code);
+    }
+}
+
+QuantizedMesh quantize(const Mesh &mesh, const std::vector<gfx::VAOBound> &format) {
+    QuantizedMesh result{.vertices = {}, .indices = mesh.indices, .bounds = format, .stride = 0UL, .errors = {}};
+
+    uint components = 0U;
+    for (auto &bound : result.bounds) {
+        if (gfx::is_packed_type(bound.type) && bound.entries != 4)
+            throw std::runtime_error("Packed 2_10_10_10 attributes must have 4 entries");
+        bound.data_size = gfx::data_type_size(bound.type);
+        components += bound.entries;
+        result.stride += bound.bytes();
+        result.errors.push_back(AttributeError{.index = bound.index, .type = bound.type});
+    }
+    if (components != mesh.vertex_size) {
+        std::stringstream error;
+        error << "Quantization format has " << components << " components, but the mesh has " << mesh.vertex_size
+              << " floats per vertex";
+        throw std::runtime_error(error.str());
+    }
+
+    auto vertex_count = mesh.vertexCount();
+    result.vertices.resize(vertex_count * result.stride, 0U);
+    std::vector<double> squared_error(result.bounds.size(), 0.0);
+    float decoded[4];
+    for (size_t v = 0; v < vertex_count; v++) {
+        auto source = mesh.vertex(v);
+        auto out = &result.vertices[v * result.stride];
+        for (size_t a = 0; a < result.bounds.size(); a++) {
+            const auto &bound = result.bounds[a];
+            auto &error = result.errors[a];
+            error.clamped += encode_attribute(bound, source, out);
+            decode_attribute(bound, out, decoded);
+            for (uint c = 0; c < bound.entries; c++) {
+                auto difference = std::fabs(decoded[c] - source[c]);
+                error.max_error = std::max(error.max_error, difference);
+                squared_error[a] += static_cast<double>(difference) * difference;
+            }
+            source += bound.entries;
+            out += bound.bytes();
+        }
+    }
+
+    for (size_t a = 0; a < result.bounds.size(); a++) {
+        auto samples = static_cast<double>(vertex_count * result.bounds[a].entries);
+        if (samples > 0)
+            result.errors[a].rms_error = static_cast<float>(std::sqrt(squared_error[a] / samples));
+    }
+    return result;
+}
+
+void logQuantization(const Mesh &mesh, const QuantizedMesh &quantized) {
+    auto source_bytes = mesh.vertices.size() * sizeof(float);
+    LOG(INFO) << "[mesh] quantized " << quantized.vertexCount() << " vertices: " << mesh.vertex_size * sizeof(float)
+              << " -> " << quantized.stride << " bytes per vertex (" << source_bytes << " -> "
+              << quantized.vertices.size() << " bytes)";
+    for (size_t a = 0; a < quantized.errors.size(); a++) {
+        const auto &error = quantized.errors[a];
+        LOG(INFO) << "[mesh]   attribute " << error.index << " (" << type_name(error.type)
+                  << (quantized.bounds[a].normalized ? " normalized" : "") << "): max error " << error.max_error
+                  << ", rms error " << error.rms_error << ", " << error.clamped << " clamped";
+    }
+}
+
+}  // namespace goat::mesh
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "gfx/structs.hpp"
+#include "mesh/Mesh.hpp"
+
+namespace goat::mesh {
+
+// The round-trip error of one quantized attribute, measured per component over every vertex
+struct AttributeError {
+    uint index;
+    gfx::DataType type;
+    float max_error = 0.0f;
+    float rms_error = 0.0f;
+    // The number of components that were outside the range of the format and had to be clamped
+    size_t clamped = 0UL;
+};
+
+/**
+ * @brief A mesh whose vertices were encoded into compact attribute formats, ready to be streamed into a `gfx::VBO`
+ *        with `addAttributeBound(bound)` for each of `bounds` followed by `applyAttributeBounds(vertices)`.
+ */
+struct QuantizedMesh {
+    std::vector<uint8_t> vertices;
+    std::vector<uint> indices;
+    std::vector<gfx::VAOBound> bounds;
+    // The number of bytes per vertex
+    size_t stride = 0UL;
+    std::vector<AttributeError> errors;
+
+    size_t vertexCount() const {
+        return this->stride > 0 ? this->vertices.size() / this->stride : 0UL;
+    }
+};
+
+// Convert a float to an IEEE 754 half float, rounding to nearest even (values above 65504 become infinity)
+uint16_t encode_half(float value);
+float decode_half(uint16_t half);
+
+// Encode a float into a `bits`-wide normalized integer: [-1, 1] for snorm, [0, 1] for unorm (values are clamped)
+int32_t encode_snorm(float value, uint bits);
+uint32_t encode_unorm(float value, uint bits);
+
+/**
+ * @brief Encode the `bound.entries` floats of one attribute into `out` (`bound.bytes()` bytes) using the type
+ *        and normalization of the bound.
+ * @return The number of components that had to be clamped to fit the format
+ */
+size_t encode_attribute(const gfx::VAOBound &bound, const float *values, uint8_t *out);
+
+// Decode one attribute encoded by `encode_attribute` back into `bound.entries` floats
+void decode_attribute(const gfx::VAOBound &bound, const uint8_t *data, float *values);
+
+/**
+ * @brief Encode every vertex of a mesh using one format per attribute, and measure the error each format introduces.
+ *        The attributes are read in order from the interleaved floats of the mesh, so their entries must add up to
+ *        `mesh.vertex_size`. The `data_size` of the bounds is filled in from their type.
+ *
+ * @note Normalized formats only cover [-1, 1] (or [0, 1]), so positions must fit in that range to use them.
+ *       Packed 2_10_10_10 formats read 4 floats per attribute.
+ */
+QuantizedMesh quantize(const Mesh &mesh, const std::vector<gfx::VAOBound> &format);
+
+// Log the size reduction and the per-attribute errors of a quantized mesh
+void logQuantization(const Mesh &mesh, const QuantizedMesh &quantized);
+
+}  // namespace goat::mesh
@@ -0,0 +1,309 @@
+#include "Simplify.hpp"
+
+#include <easylogging++.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+#include "mesh/Optimize.hpp"
+
+namespace goat::mesh {
+
+namespace {
+
+// A symmetric 4x4 matrix summing the squared distances to a set of planes (ax + by + cz + d = 0)
+struct Quadric {
+    // a², ab, ac, ad, b², bc, bd, c², cd, d²
+    std::array<double, 10> q{};
+
+    static Quadric fromPlane(double a, double b, double c, double d) {
+        return Quadric{{a * a, a * b, a * c, a * d, b * b, b * c, b * d, c * c, c * d, d * d}};
+    }
+
+    Quadric &operator+=(const Quadric &other) {
+        for (size_t i = 0; i < this->q.size(); i++)
+            this->q[i] += other.q[i];
+        return *this;
+    }
+
+    // The sum of the squared distances from a point to the planes
+    double evaluate(const float *p) const {
+        double x = p[0], y = p[1], z = p[2];
+        const auto &q = this->q;
+        return q[0] * x * x + 2.0 * q[1] * x * y + 2.0 * q[2] * x * z + 2.0 * q[3] * x + q[4] * y * y +
+               2.0 * q[5] * y * z + 2.0 * q[6] * y + q[7] * z * z + 2.0 * q[8] * z + q[9];
+    }
+};
+
+// Merging the vertex `from` into its neighbour `to`
+struct Collapse {
+    uint from;
+    uint to;
+    double cost;
+};
+
+// The (unnormalized) normal of a triangle
+std::array<double, 3> normal(const float *a, const float *b, const float *c) {
+    double e1[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+    double e2[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+    return {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+}
+
+// Hashes/compares vertices by the bit pattern of their position only
+struct PositionHash {
+    const Mesh *mesh;
+
+    size_t operator()(uint index) const {
+        uint32_t bits[3];
+        std::memcpy(bits, this->mesh->vertex(index), sizeof(bits));
+        size_t hash = 14695981039346656037ULL;
+        for (auto word : bits) {
+            hash ^= word;
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+};
+
+struct PositionEqual {
+    const Mesh *mesh;
+
+    bool operator()(uint a, uint b) const {
+        return std::memcmp(this->mesh->vertex(a), this->mesh->vertex(b), 3 * sizeof(float)) == 0;
+    }
+};
+
+/**
+ * @brief Map each vertex to the first vertex with the same position, and lock the vertices that cannot move:
+ *        the ones sharing their position with another vertex (attribute seams) and the ones on an open border
+ *        (an edge used by a single triangle).
+ */
+void classify(const Mesh &mesh, std::vector<uint> &position_class, std::vector<bool> &locked) {
+    auto vertex_count = mesh.vertexCount();
+    position_class.resize(vertex_count);
+    locked.assign(vertex_count, false);
+
+    std::unordered_map<uint, uint, PositionHash, PositionEqual> positions(vertex_count, PositionHash{&mesh},
+                                                                          PositionEqual{&mesh});
+    std::vector<uint> class_size(vertex_count, 0U);
+    for (uint v = 0; v < vertex_count; v++) {
+        position_class[v] = positions.try_emplace(v, v).first->second;
+        class_size[position_class[v]]++;
+    }
+    for (uint v = 0; v < vertex_count; v++)
+        if (class_size[position_class[v]] > 1)
+            locked[v] = true;
+
+    // Edges are counted between positions, so that seams are not mistaken for borders
+    std::unordered_map<uint64_t, uint> edges(mesh.indices.size());
+    auto edge_key = [&](uint a, uint b) {
+        a = position_class[a];
+        b = position_class[b];
+        return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+    };
+    for (size_t i = 0; i < mesh.indices.size(); i += 3)
+        for (size_t e = 0; e < 3; e++)
+            edges[edge_key(mesh.indices[i + e], mesh.indices[i + (e + 1) % 3])]++;
+    for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+        for (size_t e = 0; e < 3; e++) {
+            auto a = mesh.indices[i + e], b = mesh.indices[i + (e + 1) % 3];
+            if (edges[edge_key(a, b)] == 1)
+                locked[a] = locked[b] = true;
+        }
+    }
+}
+
+// Returns true if moving `from` onto `to` keeps the orientation of every triangle around it that survives
+bool preserves_orientation(const Mesh &mesh, const std::vector<uint> &triangles, uint from, uint to) {
+    const auto *target = mesh.vertex(to);
+    for (auto triangle : triangles) {
+        const auto *corners = &mesh.indices[triangle * 3];
+        if (corners[0] == to || corners[1] == to || corners[2] == to)
+            continue;
+        auto before = normal(mesh.vertex(corners[0]), mesh.vertex(corners[1]), mesh.vertex(corners[2]));
+        auto after = normal(corners[0] == from ? target : mesh.vertex(corners[0]),
+                            corners[1] == from ? target : mesh.vertex(corners[1]),
+                            corners[2] == from ? target : mesh.vertex(corners[2]));
+        // Triangles that were already degenerate have no orientation to keep
+        auto before_length = before[0] * before[0] + before[1] * before[1] + before[2] * before[2];
+        auto dot = before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+        if (before_length > 0.0 && dot <= 0.0)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Measure how far the simplified surface is from the original vertices: the distance from each vertex to
+ *        the closest plane of the triangles around the vertex it was merged into
+ */
+double measure_error(const Mesh &original, const Mesh &simplified, const std::vector<uint> &representative) {
+    std::vector<std::vector<uint>> triangles(simplified.vertexCount());
+    for (uint t = 0; t < simplified.indices.size() / 3; t++)
+        for (size_t corner = 0; corner < 3; corner++)
+            triangles[simplified.indices[t * 3 + corner]].push_back(t);
+
+    double error = 0.0;
+    for (uint v = 0; v < original.vertexCount(); v++) {
+        if (representative[v] == v)
+            continue;
+        const auto *p = original.vertex(v);
+        auto closest = std::numeric_limits<double>::max();
+        for (auto triangle : triangles[representative[v]]) {
+            const auto *corners = &simplified.indices[triangle * 3];
+            const auto *a = simplified.vertex(corners[0]);
+            auto n = normal(a, simplified.vertex(corners[1]), simplified.vertex(corners[2]));
+            auto length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            if (length == 0.0)
+                continue;
+            auto distance = std::abs(n[0] * (p[0] - a[0]) + n[1] * (p[1] - a[1]) + n[2] * (p[2] - a[2])) / length;
+            closest = std::min(closest, distance);
+        }
+        if (closest != std::numeric_limits<double>::max())
+            error = std::max(error, closest);
+    }
+    return error;
+}
+
+}  // namespace
+
+Mesh simplify(const Mesh &mesh, size_t target_index_count, float max_error, float *error) {
+    if (mesh.vertex_size < 3)
+        throw std::runtime_error("Simplified meshes need at least 3 floats (a position) per vertex");
+    if (mesh.indices.size() % 3 != 0)
+        throw std::runtime_error("Simplified meshes must be triangle lists");
+
+    Mesh result = mesh;
+    auto vertex_count = result.vertexCount();
+    std::vector<uint> position_class;
+    std::vector<bool> locked;
+    classify(result, position_class, locked);
+
+    // The planes of the triangles around each position, accumulated into the vertex that survives each collapse
+    std::vector<Quadric> quadrics(vertex_count);
+    for (size_t i = 0; i < result.indices.size(); i += 3) {
+        auto a = result.indices[i], b = result.indices[i + 1], c = result.indices[i + 2];
+        auto n = normal(result.vertex(a), result.vertex(b), result.vertex(c));
+        auto length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length == 0.0)
+            continue;
+        n = {n[0] / length, n[1] / length, n[2] / length};
+        const auto *p = result.vertex(a);
+        auto plane = Quadric::fromPlane(n[0], n[1], n[2], -(n[0] * p[0] + n[1] * p[1] + n[2] * p[2]));
+        for (auto v : {a, b, c})
+            quadrics[position_class[v]] += plane;
+    }
+    auto quadric = [&](uint v) -> Quadric & { return quadrics[position_class[v]]; };
+
+    auto max_cost = static_cast<double>(max_error) * max_error;
+    std::vector<std::vector<uint>> triangles(vertex_count);
+    std::vector<Collapse> collapses;
+    std::vector<uint> remap(vertex_count);
+    std::vector<bool> touched(vertex_count);
+    // The vertex each original vertex was merged into, through all of the passes
+    std::vector<uint> representative(vertex_count);
+    for (uint v = 0; v < vertex_count; v++)
+        representative[v] = v;
+
+    // Each pass collapses disjoint neighbourhoods, cheapest first, then rebuilds the index buffer
+    bool progress = true;
+    while (progress && result.indices.size() > target_index_count) {
+        progress = false;
+        for (auto &list : triangles)
+            list.clear();
+        for (uint t = 0; t < result.indices.size() / 3; t++)
+            for (size_t corner = 0; corner < 3; corner++)
+                triangles[result.indices[t * 3 + corner]].push_back(t);
+
+        collapses.clear();
+        for (size_t i = 0; i < result.indices.size(); i += 3) {
+            for (size_t e = 0; e < 3; e++) {
+                auto a = result.indices[i + e], b = result.indices[i + (e + 1) % 3];
+                if (!locked[a]) {
+                    auto q = quadric(a);
+                    q += quadric(b);
+                    collapses.push_back(Collapse{a, b, q.evaluate(result.vertex(b))});
+                }
+                if (!locked[b]) {
+                    auto q = quadric(b);
+                    q += quadric(a);
+                    collapses.push_back(Collapse{b, a, q.evaluate(result.vertex(a))});
+                }
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(),
+                  [](const Collapse &a, const Collapse &b) { return a.cost < b.cost; });
+
+        for (uint v = 0; v < vertex_count; v++)
+            remap[v] = v;
+        std::fill(touched.begin(), touched.end(), false);
+        auto index_count = result.indices.size();
+        for (const auto &collapse : collapses) {
+            if (index_count <= target_index_count || collapse.cost > max_cost)
+                break;
+            if (touched[collapse.from] || touched[collapse.to] || collapse.from == collapse.to)
+                continue;
+            if (!preserves_orientation(result, triangles[collapse.from], collapse.from, collapse.to))
+                continue;
+
+            // Only the triangles around `from` change: lock their vertices until the next pass
+            for (auto triangle : triangles[collapse.from]) {
+                const auto *corners = &result.indices[triangle * 3];
+                if (corners[0] == collapse.to || corners[1] == collapse.to || corners[2] == collapse.to)
+                    index_count -= 3;
+                for (size_t corner = 0; corner < 3; corner++)
+                    touched[corners[corner]] = true;
+            }
+            touched[collapse.to] = true;
+            remap[collapse.from] = collapse.to;
+            quadric(collapse.to) += quadric(collapse.from);
+            progress = true;
+        }
+        for (auto &v : representative)
+            v = remap[v];
+
+        // Drop the triangles that collapsed into a line
+        size_t write = 0;
+        for (size_t i = 0; i < result.indices.size(); i += 3) {
+            auto a = remap[result.indices[i]], b = remap[result.indices[i + 1]], c = remap[result.indices[i + 2]];
+            if (a == b || b == c || c == a)
+                continue;
+            result.indices[write++] = a;
+            result.indices[write++] = b;
+            result.indices[write++] = c;
+        }
+        result.indices.resize(write);
+    }
+
+    auto measured = measure_error(mesh, result, representative);
+    optimizeVertexFetch(result);
+    if (error != nullptr)
+        *error = static_cast<float>(measured);
+    LOG(INFO) << "[mesh] simplified " << mesh.triangleCount() << " triangles into " << result.triangleCount() << " ("
+              << result.vertexCount() << " vertices, error " << measured << ")";
+    return result;
+}
+
+std::vector<LODMesh> buildLODChain(const Mesh &mesh, size_t levels, float ratio) {
+    if (ratio <= 0.0f || ratio >= 1.0f)
+        throw std::runtime_error("The LOD ratio must be between 0 and 1");
+
+    std::vector<LODMesh> chain;
+    chain.push_back(LODMesh{.mesh = mesh, .error = 0.0f});
+    auto target = static_cast<double>(mesh.triangleCount());
+    while (chain.size() < levels) {
+        // Levels are all simplified from the full detail mesh, so their error is measured against it
+        target *= ratio;
+        float error = 0.0f;
+        auto level = simplify(mesh, static_cast<size_t>(target) * 3, std::numeric_limits<float>::max(), &error);
+        if (level.indices.empty() || level.indices.size() >= chain.back().mesh.indices.size())
+            break;
+        chain.push_back(LODMesh{.mesh = std::move(level), .error = std::max(error, chain.back().error)});
+    }
+    return chain;
+}
+
+}  // namespace goat::mesh
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <limits>
+#include <vector>
+
+#include "mesh/Mesh.hpp"
+
+namespace goat::mesh {
+
+// The number of levels generated by `buildLODChain` (including the full detail mesh), and the triangle ratio of
+// each level to the one before it
+static constexpr size_t DEFAULT_LOD_LEVELS = 4UL;
+static constexpr float DEFAULT_LOD_RATIO = 0.5f;
+
+// A simplified mesh and how far its surface may be from the mesh it was simplified from
+struct LODMesh {
+    Mesh mesh;
+    // The geometric error, in the units of the vertex positions (0 for the full detail mesh)
+    float error = 0.0f;
+};
+
+/**
+ * @brief Reduce the triangle count of a mesh with quadric error edge collapses (Garland & Heckbert, "Surface
+ *        Simplification Using Quadric Error Metrics", 1997). Each collapse merges a vertex into a neighbour
+ *        (keeping that neighbour's attributes), cheapest first, rejecting collapses that would flip a triangle.
+ *        Vertices on open borders and attribute seams (several vertices sharing a position) never move, so the
+ *        outline and the UV mapping of the mesh are kept. The first 3 floats of each vertex are its position.
+ *
+ * @param target_index_count Stop once the mesh has at most this many indices
+ * @param max_error Stop before a collapse whose quadric error (its estimated distance to the surface) is larger
+ * @param error Set to the measured error: the largest distance from a removed vertex to the simplified triangles
+ *              around the vertex it was merged into (optional)
+ * @return The simplified mesh, with its unused vertices removed
+ */
+Mesh simplify(const Mesh &mesh, size_t target_index_count, float max_error = std::numeric_limits<float>::max(),
+              float *error = nullptr);
+
+/**
+ * @brief Generate the levels of detail of a mesh offline: the mesh itself, then up to `levels - 1` versions
+ *        simplified from it, each with about `ratio` times the triangles of the level before. The chain stops
+ *        early when a level could not be simplified any further.
+ */
+std::vector<LODMesh> buildLODChain(const Mesh &mesh, size_t levels = DEFAULT_LOD_LEVELS,
+                                   float ratio = DEFAULT_LOD_RATIO);
+
+}  // namespace goat::mesh
@@ -1,9 +1,14 @@
 #pragma once
 #include <GLFW/glfw3.h>
 
+#include <functional>
+
 #include "constants.hpp"
+#include "gfx/FrameUniforms.hpp"
+#include "gfx/StreamBuffer.hpp"
 #include "gfx/structs.hpp"
 #include "world/Camera.hpp"
+#include "world/SceneSnapshot.hpp"
 
 namespace goat {
 
@@ -18,14 +23,32 @@ class GameWindow {
     float deltaTime;
     float lastFrame;
     world::Camera *camera = nullptr;
+    // Per-frame camera/time/viewport data shared by every shader program (created when the loop starts)
+    std::unique_ptr<gfx::FrameUniformBuffer> frame_uniforms;
+    // Ring buffer for per-frame data, fenced at the end of every frame (optional, see `enableStreaming`)
+    std::unique_ptr<gfx::StreamBuffer> stream;
+    // Snapshots handed from the simulation to the render thread (created by the first threaded `loop`)
+    std::unique_ptr<world::SnapshotBuffer> snapshots;
+    // The framebuffer size last passed to glViewport (the size reported by resizes is applied by the loop)
+    uint viewport_width;
+    uint viewport_height;
 
     static void handleKeypress(GLFWwindow *window, int key, int scancode, int action, int mods);
     static void logDriverInfo();
+    // Point the viewport at the whole framebuffer when its size changed
+    void applyViewport(uint width, uint height);
+    // Draw the snapshots published by the simulation until it stops (on the render thread)
+    void renderSnapshots(const std::function<void(const world::SceneSnapshot &)> &render_fn);
+    // Log the stream buffer and render thread statistics every few seconds
+    void reportStats(float currentFrame, float &lastReport);
 
    public:
     GameWindow(std::string window_title = "GameWindow", gfx::EngineConfig = {gfx::gl::glAPI::OPENGL3_3},
                uint width = gfx::DEFAULT_SCREEN_WIDTH, uint height = gfx::DEFAULT_SCREEN_HEIGHT);
     ~GameWindow() {
+        this->frame_uniforms.reset();
+        this->stream.reset();
+        this->snapshots.reset();
         glfwTerminate();
         if (this->camera)
             delete this->camera;
@@ -35,7 +58,18 @@ class GameWindow {
     void setFeature(gfx::gl::glFeature feature, bool enable = true);
     GLFWwindow *getHandle() const;
     world::Camera *getCamera() const;
+    // Create the stream buffer the frame uniforms (and any other per-frame data) are written to
+    gfx::StreamBuffer *enableStreaming(gfx::StreamMode mode = gfx::StreamMode::PERSISTENT,
+                                       size_t frame_size = gfx::DEFAULT_STREAM_SIZE);
+    gfx::StreamBuffer *getStream() const;
     void loop(std::function<void()> tick_fn);
+    /**
+     * @brief Simulate on this thread and draw on a render thread that owns the GL context. Every frame, `simulate_fn`
+     *        fills a snapshot (with the camera already copied into it) that `render_fn` draws while the next one is
+     *        simulated. GLFW events are still handled on this thread, so `render_fn` must not call into GLFW.
+     */
+    void loop(std::function<void(world::SceneSnapshot &)> simulate_fn,
+              std::function<void(const world::SceneSnapshot &)> render_fn);
 };
 
 }  // namespace goat
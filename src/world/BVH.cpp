@@ -0,0 +1,407 @@
+#include "BVH.hpp"
+
+#include <easylogging++.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <future>
+#include <numeric>
+#include <thread>
+
+namespace goat::world {
+
+namespace {
+
+// Nodes deeper than this become leaves, which bounds the size of the traversal stacks
+constexpr uint MAX_DEPTH = 64U;
+constexpr uint MAX_BINS = 32U;
+// The cost of visiting an interior node, relative to testing one primitive
+constexpr float TRAVERSAL_COST = 1.0f;
+
+// A fixed-size stack of node indices for the traversals
+struct NodeStack {
+    std::array<uint32_t, MAX_DEPTH + 1> nodes;
+    size_t size = 0;
+
+    void push(uint32_t node) {
+        assert(this->size < this->nodes.size());
+        this->nodes[this->size++] = node;
+    }
+
+    uint32_t pop() {
+        return this->nodes[--this->size];
+    }
+
+    bool empty() const {
+        return this->size == 0;
+    }
+};
+
+// Plain floats keep bins trivially constructible, so only the bins in use get initialized (see `buildNode`)
+struct Bin {
+    float min[3];
+    float max[3];
+    uint32_t count;
+
+    void clear() {
+        constexpr auto infinity = std::numeric_limits<float>::infinity();
+        for (int axis = 0; axis < 3; axis++) {
+            this->min[axis] = infinity;
+            this->max[axis] = -infinity;
+        }
+        this->count = 0U;
+    }
+
+    void add(const AABB &bounds) {
+        for (int axis = 0; axis < 3; axis++) {
+            this->min[axis] = std::min(this->min[axis], bounds.min[axis]);
+            this->max[axis] = std::max(this->max[axis], bounds.max[axis]);
+        }
+        ++this->count;
+    }
+
+    AABB bounds() const {
+        return AABB{.min = vec3(this->min[0], this->min[1], this->min[2]),
+                    .max = vec3(this->max[0], this->max[1], this->max[2])};
+    }
+};
+
+}  // namespace
+
+void BVH::build(const std::vector<AABB> &bounds, const BVHBuildOptions &options) {
+    this->options = options;
+    this->options.bins = std::clamp(options.bins, 2U, MAX_BINS);
+    this->options.max_leaf_size = std::max(options.max_leaf_size, 1U);
+    this->primitives = bounds;
+    this->nodes.clear();
+    this->order.resize(bounds.size());
+    std::iota(this->order.begin(), this->order.end(), 0U);
+    this->build_cost = 0.0f;
+    if (bounds.empty())
+        return;
+
+    this->build_bounds = bounds;
+    this->build_centroids.resize(bounds.size());
+    for (size_t i = 0; i < bounds.size(); i++)
+        this->build_centroids[i] = bounds[i].center();
+
+    // A binary tree with n leaves has at most 2n - 1 nodes
+    this->nodes.resize(2 * bounds.size() - 1);
+    std::atomic<uint32_t> next_node{1U};
+
+    // Fork a thread at each split until there is roughly one subtree per thread
+    auto threads =
+        this->options.threads > 0 ? this->options.threads : std::max(std::thread::hardware_concurrency(), 1U);
+    auto parallel_depth = static_cast<uint>(std::bit_width(threads - 1));
+    AABB root_bounds, root_centroids;
+    this->computeBounds(0U, static_cast<uint32_t>(bounds.size()), root_bounds, root_centroids);
+    this->buildNode(0U, 0U, static_cast<uint32_t>(bounds.size()), root_bounds, root_centroids, 0U, parallel_depth,
+                    next_node);
+
+    this->nodes.resize(next_node.load());
+    this->nodes.shrink_to_fit();
+    this->build_bounds = std::vector<AABB>{};
+    this->build_centroids = std::vector<vec3>{};
+    this->build_cost = this->cost();
+
+#ifdef __DEBUG__
+    LOG(DEBUG) << "BVH::build(" << bounds.size() << ") " << this->nodes.size() << " nodes, SAH cost "
+               << this->build_cost;
+#endif
+}
+
+void BVH::computeBounds(uint32_t begin, uint32_t end, AABB &bounds, AABB &centroid_bounds) const {
+    bounds = AABB::empty();
+    centroid_bounds = AABB::empty();
+    for (auto i = begin; i < end; i++) {
+        bounds.expand(this->build_bounds[i]);
+        centroid_bounds.expand(this->build_centroids[i]);
+    }
+}
+
+void BVH::buildNode(uint32_t index, uint32_t begin, uint32_t end, const AABB &bounds, const AABB &centroid_bounds,
+                    uint depth, uint parallel_depth, std::atomic<uint32_t> &next_node) {
+    auto count = end - begin;
+    auto &node = this->nodes[index];
+    node = BVHNode{.bounds = bounds, .left = 0U, .begin = begin, .count = count};
+    if (count <= 1 || depth >= MAX_DEPTH)
+        return;
+
+    // Sort the centroids into bins along all three axes in a single pass. Small nodes do not need more bins than
+    // primitives.
+    auto bin_count = std::min(this->options.bins, std::max(count, 2U));
+    std::array<std::array<Bin, MAX_BINS>, 3> bins;
+    vec3 scale(0.0f, 0.0f, 0.0f);
+    for (int axis = 0; axis < 3; axis++) {
+        for (uint bin = 0; bin < bin_count; bin++)
+            bins[axis][bin].clear();
+        auto extent = centroid_bounds.max[axis] - centroid_bounds.min[axis];
+        scale[axis] = extent > 0.0f ? static_cast<float>(bin_count) / extent : 0.0f;
+    }
+    auto bin_of = [&](const vec3 &centroid, int axis) {
+        return std::min(bin_count - 1, static_cast<uint>((centroid[axis] - centroid_bounds.min[axis]) * scale[axis]));
+    };
+    for (auto i = begin; i < end; i++) {
+        const auto &centroid = this->build_centroids[i];
+        for (int axis = 0; axis < 3; axis++) {
+            bins[axis][bin_of(centroid, axis)].add(this->build_bounds[i]);
+        }
+    }
+
+    // Evaluate the split between every pair of adjacent bins along each axis, and keep the cheapest
+    int best_axis = -1;
+    uint best_bin = 0U;
+    float best_cost = std::numeric_limits<float>::infinity();
+    for (int axis = 0; axis < 3; axis++) {
+        if (scale[axis] <= 0.0f)
+            continue;
+
+        // Sweep from the right to accumulate the cost of everything right of each split...
+        std::array<float, MAX_BINS> right_cost;
+        auto right = AABB::empty();
+        uint32_t right_count = 0U;
+        for (auto bin = bin_count - 1; bin > 0; bin--) {
+            right.expand(bins[axis][bin].bounds());
+            right_count += bins[axis][bin].count;
+            right_cost[bin - 1] = right_count > 0 ? right.halfArea() * right_count : 0.0f;
+        }
+        // ...then from the left to add the cost of everything left of it
+        auto left = AABB::empty();
+        uint32_t left_count = 0U;
+        for (uint bin = 0; bin + 1 < bin_count; bin++) {
+            left.expand(bins[axis][bin].bounds());
+            left_count += bins[axis][bin].count;
+            if (left_count == 0 || left_count == count)
+                continue;
+            auto cost = left.halfArea() * left_count + right_cost[bin];
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_axis = axis;
+                best_bin = bin;
+            }
+        }
+    }
+
+    uint32_t middle;
+    AABB left_bounds = AABB::empty(), left_centroids = AABB::empty();
+    AABB right_bounds = AABB::empty(), right_centroids = AABB::empty();
+    if (best_axis < 0) {
+        // Every centroid is in the same place, so no split separates them; halve the node instead
+        if (count <= this->options.max_leaf_size)
+            return;
+        middle = begin + count / 2;
+        this->computeBounds(begin, middle, left_bounds, left_centroids);
+        this->computeBounds(middle, end, right_bounds, right_centroids);
+    } else {
+        auto split_cost = TRAVERSAL_COST * bounds.halfArea() + best_cost;
+        auto leaf_cost = bounds.halfArea() * count;
+        if (count <= this->options.max_leaf_size && leaf_cost <= split_cost)
+            return;
+
+        // The children's bounds are the union of the bins on each side of the split
+        for (uint bin = 0; bin < bin_count; bin++)
+            (bin <= best_bin ? left_bounds : right_bounds).expand(bins[best_axis][bin].bounds());
+
+        // Partition the primitives (and their build data) around the split, using the same binning, and collect
+        // the centroid bounds of each side on the way
+        auto i = begin;
+        auto j = end;
+        while (i < j) {
+            if (bin_of(this->build_centroids[i], best_axis) <= best_bin) {
+                left_centroids.expand(this->build_centroids[i]);
+                ++i;
+            } else {
+                right_centroids.expand(this->build_centroids[i]);
+                --j;
+                std::swap(this->order[i], this->order[j]);
+                std::swap(this->build_bounds[i], this->build_bounds[j]);
+                std::swap(this->build_centroids[i], this->build_centroids[j]);
+            }
+        }
+        middle = i;
+        assert(middle > begin && middle < end);
+    }
+
+    auto left = next_node.fetch_add(2U);
+    node.left = left;
+    if (depth < parallel_depth && count >= this->options.parallel_threshold) {
+        auto left_build = std::async(std::launch::async, [&]() {
+            this->buildNode(left, begin, middle, left_bounds, left_centroids, depth + 1, parallel_depth, next_node);
+        });
+        this->buildNode(left + 1, middle, end, right_bounds, right_centroids, depth + 1, parallel_depth, next_node);
+        left_build.get();
+    } else {
+        this->buildNode(left, begin, middle, left_bounds, left_centroids, depth + 1, parallel_depth, next_node);
+        this->buildNode(left + 1, middle, end, right_bounds, right_centroids, depth + 1, parallel_depth, next_node);
+    }
+}
+
+void BVH::refit(const std::vector<AABB> &bounds) {
+    assert(bounds.size() == this->primitives.size());
+    this->primitives = bounds;
+
+    // Children are always allocated after their parent, so walking backwards visits them first
+    for (auto i = this->nodes.size(); i-- > 0;) {
+        auto &node = this->nodes[i];
+        if (node.leaf()) {
+            node.bounds = AABB::empty();
+            for (auto p = node.begin; p < node.begin + node.count; p++)
+                node.bounds.expand(this->primitives[this->order[p]]);
+        } else {
+            node.bounds = this->nodes[node.left].bounds;
+            node.bounds.expand(this->nodes[node.left + 1].bounds);
+        }
+    }
+}
+
+bool BVH::update(const std::vector<AABB> &bounds, float threshold) {
+    if (bounds.size() != this->primitives.size() || this->nodes.empty()) {
+        this->build(bounds, this->options);
+        return true;
+    }
+
+    this->refit(bounds);
+    auto cost = this->cost();
+    if (cost <= this->build_cost * threshold)
+        return false;
+
+#ifdef __DEBUG__
+    LOG(DEBUG) << "BVH::update() SAH cost " << cost << " exceeds " << threshold << "x the build cost "
+               << this->build_cost << ", rebuilding";
+#endif
+    this->build(bounds, this->options);
+    return true;
+}
+
+float BVH::cost() const {
+    if (this->nodes.empty())
+        return 0.0f;
+
+    auto root_area = this->nodes[0].bounds.halfArea();
+    if (root_area <= 0.0f)
+        return 0.0f;
+
+    double cost = 0.0;
+    for (const auto &node : this->nodes) {
+        auto area = static_cast<double>(node.bounds.halfArea());
+        cost += node.leaf() ? area * node.count : area * TRAVERSAL_COST;
+    }
+    return static_cast<float>(cost / root_area);
+}
+
+void BVH::collect(const BVHNode &node, std::vector<uint32_t> &results) const {
+    results.insert(results.end(), this->order.begin() + node.begin, this->order.begin() + node.begin + node.count);
+}
+
+void BVH::queryFrustum(const Frustum &frustum, std::vector<uint32_t> &results) const {
+    if (this->nodes.empty())
+        return;
+
+    NodeStack stack;
+    stack.push(0U);
+    while (!stack.empty()) {
+        const auto &node = this->nodes[stack.pop()];
+        if (!frustum.intersects(node.bounds))
+            continue;
+        // Everything under a node that is entirely inside the frustum is visible
+        if (frustum.contains(node.bounds)) {
+            this->collect(node, results);
+        } else if (node.leaf()) {
+            for (auto p = node.begin; p < node.begin + node.count; p++)
+                if (frustum.intersects(this->primitives[this->order[p]]))
+                    results.push_back(this->order[p]);
+        } else {
+            stack.push(node.left + 1);
+            stack.push(node.left);
+        }
+    }
+}
+
+void BVH::querySphere(const vec3 &center, float radius, std::vector<uint32_t> &results) const {
+    if (this->nodes.empty())
+        return;
+
+    auto radius_squared = radius * radius;
+    NodeStack stack;
+    stack.push(0U);
+    while (!stack.empty()) {
+        const auto &node = this->nodes[stack.pop()];
+        if (node.bounds.distanceSquared(center) > radius_squared)
+            continue;
+        if (node.leaf()) {
+            for (auto p = node.begin; p < node.begin + node.count; p++)
+                if (this->primitives[this->order[p]].distanceSquared(center) <= radius_squared)
+                    results.push_back(this->order[p]);
+        } else {
+            stack.push(node.left + 1);
+            stack.push(node.left);
+        }
+    }
+}
+
+void BVH::queryAABB(const AABB &bounds, std::vector<uint32_t> &results) const {
+    if (this->nodes.empty())
+        return;
+
+    NodeStack stack;
+    stack.push(0U);
+    while (!stack.empty()) {
+        const auto &node = this->nodes[stack.pop()];
+        if (!node.bounds.overlaps(bounds))
+            continue;
+        if (node.leaf()) {
+            for (auto p = node.begin; p < node.begin + node.count; p++)
+                if (this->primitives[this->order[p]].overlaps(bounds))
+                    results.push_back(this->order[p]);
+        } else {
+            stack.push(node.left + 1);
+            stack.push(node.left);
+        }
+    }
+}
+
+RayHit BVH::raycast(const vec3 &origin, const vec3 &direction, float max_distance) const {
+    RayHit closest{.index = ~0U, .distance = max_distance};
+    if (this->nodes.empty())
+        return closest;
+
+    auto inverse_direction = vec3(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+    NodeStack stack;
+    stack.push(0U);
+    while (!stack.empty()) {
+        const auto &node = this->nodes[stack.pop()];
+        float distance;
+        if (!node.bounds.intersectRay(origin, inverse_direction, closest.distance, distance))
+            continue;
+
+        if (node.leaf()) {
+            for (auto p = node.begin; p < node.begin + node.count; p++) {
+                auto primitive = this->order[p];
+                if (this->primitives[primitive].intersectRay(origin, inverse_direction, closest.distance, distance) &&
+                    (distance < closest.distance || !closest.hit()))
+                    closest = RayHit{.index = primitive, .distance = distance};
+            }
+            continue;
+        }
+
+        // Visit the nearer child first, so the farther one can be skipped once something closer is hit
+        float left_distance, right_distance;
+        bool left_hit = this->nodes[node.left].bounds.intersectRay(origin, inverse_direction, closest.distance,
+                                                                   left_distance);
+        bool right_hit = this->nodes[node.left + 1].bounds.intersectRay(origin, inverse_direction, closest.distance,
+                                                                        right_distance);
+        if (left_hit && right_hit) {
+            auto near_first = left_distance <= right_distance;
+            stack.push(near_first ? node.left + 1 : node.left);
+            stack.push(near_first ? node.left : node.left + 1);
+        } else if (left_hit) {
+            stack.push(node.left);
+        } else if (right_hit) {
+            stack.push(node.left + 1);
+        }
+    }
+    return closest;
+}
+
+}  // namespace goat::world
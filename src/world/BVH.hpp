@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "world/Bounds.hpp"
+
+namespace goat::world {
+
+// Refit the hierarchy until its SAH cost grows past this factor of the cost it had when it was built
+static constexpr float DEFAULT_BVH_REBUILD_THRESHOLD = 1.5f;
+
+/**
+ * @brief A BVH node. Every node covers the contiguous range [begin, begin + count) of the primitive order, and
+ *        interior nodes store their children next to each other at `left` and `left + 1`.
+ */
+struct BVHNode {
+    AABB bounds;
+    // The index of the left child (0 for leaves, since the root is never a child)
+    uint32_t left = 0U;
+    uint32_t begin = 0U;
+    uint32_t count = 0U;
+
+    bool leaf() const {
+        return this->left == 0U;
+    }
+};
+
+struct BVHBuildOptions {
+    // The number of bins centroids are sorted into along each axis when evaluating split candidates (at most 32)
+    uint bins = 16U;
+    // Nodes with at most this many primitives may become leaves when splitting them would not be cheaper
+    uint max_leaf_size = 4U;
+    // Subtrees with at least this many primitives are built on their own thread
+    size_t parallel_threshold = 16384UL;
+    // The number of threads to build with (0 for one per hardware thread)
+    uint threads = 0U;
+};
+
+// The closest primitive hit by a ray
+struct RayHit {
+    uint32_t index = ~0U;
+    float distance = std::numeric_limits<float>::infinity();
+
+    bool hit() const {
+        return this->index != ~0U;
+    }
+};
+
+/**
+ * @brief A bounding volume hierarchy over a set of boxes (e.g. the world bounds of scene objects), built top-down
+ *        with binned SAH (Wald, "On fast Construction of SAH-based Bounding Volume Hierarchies", 2007).
+ *        Queries append the indices of the matching boxes, in the order they were passed to `build`.
+ *
+ * @note Moving objects are handled by `refit`, which keeps the topology and only recomputes bounds. `update`
+ *       rebuilds the hierarchy once refitting has made it too much worse than a fresh build.
+ */
+class BVH {
+   private:
+    std::vector<BVHNode> nodes;
+    // Primitive indices in the order the leaves reference them
+    std::vector<uint32_t> order;
+    std::vector<AABB> primitives;
+    // Primitive bounds and centroids in the current order, only kept during a build so that each node reads them
+    // sequentially instead of through `order`
+    std::vector<AABB> build_bounds;
+    std::vector<vec3> build_centroids;
+    BVHBuildOptions options;
+    // The SAH cost right after the last build
+    float build_cost = 0.0f;
+
+    // Build the subtree of primitives [begin, end), whose bounds and centroid bounds are already known
+    void buildNode(uint32_t node, uint32_t begin, uint32_t end, const AABB &bounds, const AABB &centroid_bounds,
+                   uint depth, uint parallel_depth, std::atomic<uint32_t> &next_node);
+    // Compute the bounds and centroid bounds of the primitives [begin, end) in build order
+    void computeBounds(uint32_t begin, uint32_t end, AABB &bounds, AABB &centroid_bounds) const;
+
+    // Append every primitive under a node, without testing them
+    void collect(const BVHNode &node, std::vector<uint32_t> &results) const;
+
+   public:
+    // Build the hierarchy from scratch
+    void build(const std::vector<AABB> &bounds, const BVHBuildOptions &options = {});
+
+    // Update the bounds of every primitive (in the same order as `build`) and refit the nodes bottom-up
+    void refit(const std::vector<AABB> &bounds);
+
+    /**
+     * @brief Refit the hierarchy to new bounds, rebuilding it instead when the number of primitives changed or
+     *        the refitted SAH cost is more than `threshold` times the cost after the last build.
+     * @return true if the hierarchy was rebuilt
+     */
+    bool update(const std::vector<AABB> &bounds, float threshold = DEFAULT_BVH_REBUILD_THRESHOLD);
+
+    // The SAH cost of the hierarchy, relative to the surface area of the root
+    float cost() const;
+
+    float buildCost() const {
+        return this->build_cost;
+    }
+
+    // Returns the number of primitives
+    size_t size() const {
+        return this->primitives.size();
+    }
+
+    size_t nodeCount() const {
+        return this->nodes.size();
+    }
+
+    // Find every box that intersects a frustum
+    void queryFrustum(const Frustum &frustum, std::vector<uint32_t> &results) const;
+    // Find every box that intersects a sphere
+    void querySphere(const vec3 &center, float radius, std::vector<uint32_t> &results) const;
+    // Find every box that overlaps a box
+    void queryAABB(const AABB &bounds, std::vector<uint32_t> &results) const;
+    // Find the closest box hit by a ray within `max_distance` (`direction` does not need to be normalized;
+    // distances are measured in multiples of it)
+    RayHit raycast(const vec3 &origin, const vec3 &direction,
+                   float max_distance = std::numeric_limits<float>::infinity()) const;
+};
+
+}  // namespace goat::world
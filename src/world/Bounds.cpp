@@ -0,0 +1,112 @@
+#include "Bounds.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace goat::world {
+
+AABB AABB::fromPoints(const float *points, size_t count, size_t stride) {
+    if (count == 0)
+        return AABB{};
+
+    AABB bounds{.min = vec3(points[0], points[1], points[2]), .max = vec3(points[0], points[1], points[2])};
+    for (size_t i = 1; i < count; i++) {
+        auto point = &points[i * stride];
+        for (int axis = 0; axis < 3; axis++) {
+            bounds.min[axis] = std::min(bounds.min[axis], point[axis]);
+            bounds.max[axis] = std::max(bounds.max[axis], point[axis]);
+        }
+    }
+    return bounds;
+}
+
+bool AABB::bounded() const {
+    for (int axis = 0; axis < 3; axis++)
+        if (!std::isfinite(this->min[axis]) || !std::isfinite(this->max[axis]))
+            return false;
+    return true;
+}
+
+float AABB::distanceSquared(const vec3 &point) const {
+    auto offset = glm::max(glm::max(this->min - point, point - this->max), vec3(0.0f, 0.0f, 0.0f));
+    return glm::dot(offset, offset);
+}
+
+bool AABB::intersectRay(const vec3 &origin, const vec3 &inverse_direction, float max_distance,
+                        float &distance) const {
+    float enter = 0.0f;
+    float exit = max_distance;
+    for (int axis = 0; axis < 3; axis++) {
+        auto t0 = (this->min[axis] - origin[axis]) * inverse_direction[axis];
+        auto t1 = (this->max[axis] - origin[axis]) * inverse_direction[axis];
+        // A NaN (a ray parallel to a slab starting on its boundary) leaves enter/exit unchanged
+        enter = std::max(enter, std::min(t0, t1));
+        exit = std::min(exit, std::max(t0, t1));
+    }
+    distance = enter;
+    return enter <= exit;
+}
+
+AABB AABB::transform(const mat4 &matrix) const {
+    auto center = this->center();
+    auto extents = this->extents();
+
+    // The new extent along each axis is the extent of the old box projected onto that row of the matrix
+    vec3 new_center(matrix[3][0], matrix[3][1], matrix[3][2]);
+    vec3 new_extents(0.0f, 0.0f, 0.0f);
+    for (int row = 0; row < 3; row++) {
+        for (int column = 0; column < 3; column++) {
+            new_center[row] += matrix[column][row] * center[column];
+            new_extents[row] += std::fabs(matrix[column][row]) * extents[column];
+        }
+    }
+    return AABB{.min = new_center - new_extents, .max = new_center + new_extents};
+}
+
+Frustum Frustum::fromMatrix(const mat4 &m) {
+    // glm matrices are column-major: row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+    auto row = [&m](int i) { return vec4(m[0][i], m[1][i], m[2][i], m[3][i]); };
+    auto x = row(0), y = row(1), z = row(2), w = row(3);
+
+    Frustum frustum{};
+    frustum.planes[PLANE_LEFT] = w + x;
+    frustum.planes[PLANE_RIGHT] = w - x;
+    frustum.planes[PLANE_BOTTOM] = w + y;
+    frustum.planes[PLANE_TOP] = w - y;
+    frustum.planes[PLANE_NEAR] = w + z;
+    frustum.planes[PLANE_FAR] = w - z;
+
+    // Normalize so that plane distances are in world units
+    for (auto &plane : frustum.planes) {
+        auto length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+        if (length > 0.0f)
+            plane = plane / length;
+    }
+    return frustum;
+}
+
+bool Frustum::intersects(const AABB &bounds) const {
+    auto center = bounds.center();
+    auto extents = bounds.extents();
+    for (const auto &plane : this->planes) {
+        auto distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+        auto radius = std::fabs(plane.x) * extents.x + std::fabs(plane.y) * extents.y + std::fabs(plane.z) * extents.z;
+        if (distance + radius < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+bool Frustum::contains(const AABB &bounds) const {
+    auto center = bounds.center();
+    auto extents = bounds.extents();
+    for (const auto &plane : this->planes) {
+        auto distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+        auto radius = std::fabs(plane.x) * extents.x + std::fabs(plane.y) * extents.y + std::fabs(plane.z) * extents.z;
+        if (distance - radius < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+}  // namespace goat::world
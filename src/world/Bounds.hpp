@@ -0,0 +1,101 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <limits>
+
+#include "constants.hpp"
+
+namespace goat::world {
+
+/**
+ * @brief An axis-aligned bounding box. An unbounded box (see `unbounded`) marks objects that are never culled.
+ */
+struct AABB {
+    vec3 min = vec3(0.0f, 0.0f, 0.0f);
+    vec3 max = vec3(0.0f, 0.0f, 0.0f);
+
+    // A box covering all of space
+    static AABB unbounded() {
+        constexpr auto infinity = std::numeric_limits<float>::infinity();
+        return AABB{.min = vec3(-infinity, -infinity, -infinity), .max = vec3(infinity, infinity, infinity)};
+    }
+
+    // A box containing nothing, which grows to fit whatever is added to it with `expand`
+    static AABB empty() {
+        constexpr auto infinity = std::numeric_limits<float>::infinity();
+        return AABB{.min = vec3(infinity, infinity, infinity), .max = vec3(-infinity, -infinity, -infinity)};
+    }
+
+    // The smallest box containing `count` points, each `stride` floats apart (e.g. the XYZ of interleaved vertices)
+    static AABB fromPoints(const float *points, size_t count, size_t stride = 3);
+
+    // Returns false for boxes with infinite or NaN corners, which cannot be culled
+    bool bounded() const;
+
+    vec3 center() const {
+        return (this->min + this->max) * 0.5f;
+    }
+
+    // Half of the size of the box along each axis
+    vec3 extents() const {
+        return (this->max - this->min) * 0.5f;
+    }
+
+    // Half of the surface area of the box (the constant factor does not matter when comparing areas)
+    float halfArea() const {
+        auto size = this->max - this->min;
+        return size.x * size.y + size.y * size.z + size.z * size.x;
+    }
+
+    // Grow the box to contain another box
+    void expand(const AABB &other) {
+        this->min = glm::min(this->min, other.min);
+        this->max = glm::max(this->max, other.max);
+    }
+
+    // Grow the box to contain a point
+    void expand(const vec3 &point) {
+        this->min = glm::min(this->min, point);
+        this->max = glm::max(this->max, point);
+    }
+
+    bool overlaps(const AABB &other) const {
+        return this->min.x <= other.max.x && this->max.x >= other.min.x && this->min.y <= other.max.y &&
+               this->max.y >= other.min.y && this->min.z <= other.max.z && this->max.z >= other.min.z;
+    }
+
+    // The squared distance from a point to the closest point of the box (0 inside the box)
+    float distanceSquared(const vec3 &point) const;
+
+    /**
+     * @brief Intersect a ray with the box (slab test)
+     * @param inverse_direction 1 / direction of the ray, per component
+     * @param distance Set to the distance along the ray at which it enters the box (0 if it starts inside)
+     * @return false if the ray misses the box within `max_distance`
+     */
+    bool intersectRay(const vec3 &origin, const vec3 &inverse_direction, float max_distance, float &distance) const;
+
+    // The box containing this box after it is transformed by `matrix` (Arvo, "Transforming Axis-Aligned
+    // Bounding Boxes", 1990)
+    AABB transform(const mat4 &matrix) const;
+};
+
+/**
+ * @brief The six planes of a view frustum, pointing inwards. A plane is stored as (normal, distance), so a point p
+ *        is inside it when dot(normal, p) + distance >= 0.
+ */
+struct Frustum {
+    enum Plane { PLANE_LEFT, PLANE_RIGHT, PLANE_BOTTOM, PLANE_TOP, PLANE_NEAR, PLANE_FAR, PLANE_COUNT };
+    vec4 planes[PLANE_COUNT];
+
+    // Extract the planes from a projection * view matrix (Gribb & Hartmann, 2001)
+    static Frustum fromMatrix(const mat4 &view_projection);
+
+    // Returns false if the box is entirely outside one of the planes (boxes that straddle a corner may pass)
+    bool intersects(const AABB &bounds) const;
+
+    // Returns true if the box is entirely inside every plane
+    bool contains(const AABB &bounds) const;
+};
+
+}  // namespace goat::world
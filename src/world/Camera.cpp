@@ -34,7 +34,7 @@ void Camera::move(Direction direction, float deltaTime) {
 }
 
 glm::mat4 Camera::getProjectionMatrix() const {
-    return glm::perspective(glm::radians(this->fov), 800.f / 600.f, 0.1f, 100.0f);
+    return glm::perspective(glm::radians(this->fov), 800.f / 600.f, CAMERA_NEAR_PLANE, CAMERA_FAR_PLANE);
 }
 
 }  // namespace goat::world
\ No newline at end of file
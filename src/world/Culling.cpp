@@ -0,0 +1,166 @@
+#include "Culling.hpp"
+
+#include <bit>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace goat::world {
+
+namespace {
+
+// Call `fn` with the offset of every set bit in `mask`
+template <typename F>
+inline void for_each_bit(uint32_t mask, F &&fn) {
+    while (mask != 0) {
+        fn(static_cast<uint32_t>(std::countr_zero(mask)));
+        mask &= mask - 1;
+    }
+}
+
+}  // namespace
+
+void FrustumCuller::clear() {
+    for (auto component : {&this->center_x, &this->center_y, &this->center_z, &this->extent_x, &this->extent_y,
+                           &this->extent_z})
+        component->clear();
+}
+
+void FrustumCuller::reserve(size_t count) {
+    for (auto component : {&this->center_x, &this->center_y, &this->center_z, &this->extent_x, &this->extent_y,
+                           &this->extent_z})
+        component->reserve(count);
+}
+
+uint32_t FrustumCuller::add(const AABB &bounds) {
+    auto center = bounds.center();
+    auto extents = bounds.extents();
+    this->center_x.push_back(center.x);
+    this->center_y.push_back(center.y);
+    this->center_z.push_back(center.z);
+    this->extent_x.push_back(extents.x);
+    this->extent_y.push_back(extents.y);
+    this->extent_z.push_back(extents.z);
+    return static_cast<uint32_t>(this->center_x.size() - 1);
+}
+
+void FrustumCuller::cullRange(const Frustum &frustum, size_t begin, size_t end,
+                              std::vector<uint32_t> &visible) const {
+    for (auto i = begin; i < end; i++) {
+        bool inside = true;
+        for (const auto &plane : frustum.planes) {
+            auto distance =
+                plane.x * this->center_x[i] + plane.y * this->center_y[i] + plane.z * this->center_z[i] + plane.w;
+            auto radius = std::fabs(plane.x) * this->extent_x[i] + std::fabs(plane.y) * this->extent_y[i] +
+                          std::fabs(plane.z) * this->extent_z[i];
+            if (distance + radius < 0.0f) {
+                inside = false;
+                break;
+            }
+        }
+        if (inside)
+            visible.push_back(static_cast<uint32_t>(i));
+    }
+}
+
+size_t FrustumCuller::cullScalar(const Frustum &frustum, std::vector<uint32_t> &visible) const {
+    auto before = visible.size();
+    this->cullRange(frustum, 0, this->size(), visible);
+    return visible.size() - before;
+}
+
+size_t FrustumCuller::cull(const Frustum &frustum, std::vector<uint32_t> &visible) const {
+    auto before = visible.size();
+    auto count = this->size();
+    size_t i = 0;
+
+    // Each kernel keeps a lane mask of the boxes that are on the inner side of every plane tested so far,
+    // and stops testing planes early once the whole batch is outside
+#if defined(__AVX2__)
+    for (; i + 8 <= count; i += 8) {
+        auto cx = _mm256_loadu_ps(&this->center_x[i]), cy = _mm256_loadu_ps(&this->center_y[i]),
+             cz = _mm256_loadu_ps(&this->center_z[i]);
+        auto ex = _mm256_loadu_ps(&this->extent_x[i]), ey = _mm256_loadu_ps(&this->extent_y[i]),
+             ez = _mm256_loadu_ps(&this->extent_z[i]);
+        int mask = 0xFF;
+        for (const auto &plane : frustum.planes) {
+            auto distance = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.x), cx), _mm256_mul_ps(_mm256_set1_ps(plane.y), cy)),
+                _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.z), cz), _mm256_set1_ps(plane.w)));
+            auto radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(std::fabs(plane.x)), ex),
+                                                      _mm256_mul_ps(_mm256_set1_ps(std::fabs(plane.y)), ey)),
+                                        _mm256_mul_ps(_mm256_set1_ps(std::fabs(plane.z)), ez));
+            mask &= _mm256_movemask_ps(_mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_GE_OQ));
+            if (mask == 0)
+                break;
+        }
+        for_each_bit(static_cast<uint32_t>(mask),
+                     [&](uint32_t lane) { visible.push_back(static_cast<uint32_t>(i + lane)); });
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    for (; i + 4 <= count; i += 4) {
+        auto cx = _mm_loadu_ps(&this->center_x[i]), cy = _mm_loadu_ps(&this->center_y[i]),
+             cz = _mm_loadu_ps(&this->center_z[i]);
+        auto ex = _mm_loadu_ps(&this->extent_x[i]), ey = _mm_loadu_ps(&this->extent_y[i]),
+             ez = _mm_loadu_ps(&this->extent_z[i]);
+        int mask = 0xF;
+        for (const auto &plane : frustum.planes) {
+            auto distance =
+                _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), cx), _mm_mul_ps(_mm_set1_ps(plane.y), cy)),
+                           _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.z), cz), _mm_set1_ps(plane.w)));
+            auto radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(std::fabs(plane.x)), ex),
+                                                _mm_mul_ps(_mm_set1_ps(std::fabs(plane.y)), ey)),
+                                     _mm_mul_ps(_mm_set1_ps(std::fabs(plane.z)), ez));
+            mask &= _mm_movemask_ps(_mm_cmpge_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+            if (mask == 0)
+                break;
+        }
+        for_each_bit(static_cast<uint32_t>(mask),
+                     [&](uint32_t lane) { visible.push_back(static_cast<uint32_t>(i + lane)); });
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint32_t lane_bits[4] = {1U, 2U, 4U, 8U};
+    auto lanes = vld1q_u32(lane_bits);
+    for (; i + 4 <= count; i += 4) {
+        auto cx = vld1q_f32(&this->center_x[i]), cy = vld1q_f32(&this->center_y[i]),
+             cz = vld1q_f32(&this->center_z[i]);
+        auto ex = vld1q_f32(&this->extent_x[i]), ey = vld1q_f32(&this->extent_y[i]),
+             ez = vld1q_f32(&this->extent_z[i]);
+        uint32_t mask = 0xF;
+        for (const auto &plane : frustum.planes) {
+            auto distance = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(plane.w), cx, plane.x), cy, plane.y),
+                                        cz, plane.z);
+            auto radius = vmlaq_n_f32(
+                vmlaq_n_f32(vmulq_n_f32(ex, std::fabs(plane.x)), ey, std::fabs(plane.y)), ez, std::fabs(plane.z));
+            mask &= vaddvq_u32(vandq_u32(vcgeq_f32(vaddq_f32(distance, radius), vdupq_n_f32(0.0f)), lanes));
+            if (mask == 0)
+                break;
+        }
+        for_each_bit(mask, [&](uint32_t lane) { visible.push_back(static_cast<uint32_t>(i + lane)); });
+    }
+#endif
+
+    // The remainder (or everything, without SIMD support)
+    this->cullRange(frustum, i, count, visible);
+    return visible.size() - before;
+}
+
+const char *FrustumCuller::simdPath() {
+#if defined(__AVX2__)
+    return "AVX2 (8-wide)";
+#elif defined(__SSE2__) || defined(_M_X64)
+    return "SSE2 (4-wide)";
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    return "NEON (4-wide)";
+#else
+    return "scalar";
+#endif
+}
+
+}  // namespace goat::world
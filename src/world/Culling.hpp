@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "world/Bounds.hpp"
+
+namespace goat::world {
+
+// Per-frame culling results
+struct CullingStats {
+    size_t visible = 0UL;
+    size_t culled = 0UL;
+    // Objects inside the frustum but hidden behind occluders (counted in `culled`)
+    size_t occluded = 0UL;
+};
+
+/**
+ * @brief Tests world-space bounding boxes against a view frustum in batches. Boxes are stored as
+ *        structure-of-arrays (center and extents per axis), so one SIMD register holds the same component of
+ *        4 (SSE, NEON) or 8 (AVX2) boxes and every plane is tested against the whole batch at once.
+ */
+class FrustumCuller {
+   private:
+    std::vector<float> center_x, center_y, center_z;
+    std::vector<float> extent_x, extent_y, extent_z;
+
+    // Test boxes [begin, end) one at a time, appending the visible ones to `visible`
+    void cullRange(const Frustum &frustum, size_t begin, size_t end, std::vector<uint32_t> &visible) const;
+
+   public:
+    void clear();
+    void reserve(size_t count);
+
+    // Add a world-space box, returning its index
+    uint32_t add(const AABB &bounds);
+
+    size_t size() const {
+        return this->center_x.size();
+    }
+
+    /**
+     * @brief Append the index of every box that intersects the frustum to `visible`, using the widest SIMD
+     *        instruction set the build targets.
+     * @return The number of visible boxes
+     */
+    size_t cull(const Frustum &frustum, std::vector<uint32_t> &visible) const;
+
+    // The same as `cull`, without SIMD (the reference implementation)
+    size_t cullScalar(const Frustum &frustum, std::vector<uint32_t> &visible) const;
+
+    // The name of the SIMD implementation used by `cull`
+    static const char *simdPath();
+};
+
+}  // namespace goat::world
@@ -2,13 +2,18 @@
 
 namespace goat::world {
 
+vec3 GameObject::getWorldPosition() const {
+    assert(this->transform != nullptr);
+    return this->world_pos + this->transform->pos;
+}
+
 /** @brief Return the model matrix for the object taking its transformations into account */
 glm::mat4 GameObject::getModelMatrix() const {
     assert(this->transform != nullptr);
 
     auto model = mat4(1.0f);
     auto transform = this->transform.get();
-    model = glm::translate(model, transform->pos);
+    model = glm::translate(model, this->world_pos + transform->pos);
     model = glm::rotate(model, glm::radians(transform->rot.x), vec3(1.0f, 0.0f, 0.0f));
     model = glm::rotate(model, glm::radians(transform->rot.y), vec3(0.0f, 1.0f, 0.0f));
     model = glm::rotate(model, glm::radians(transform->rot.z), vec3(0.0f, 0.0f, 1.0f));
@@ -16,4 +21,24 @@ glm::mat4 GameObject::getModelMatrix() const {
     return model;
 }
 
-}  // namespace goat::world
\ No newline at end of file
+/** @brief Return the object-space bounds transformed by the model matrix (unbounded objects stay unbounded) */
+AABB GameObject::getWorldBounds() const {
+    if (!this->bounds.bounded())
+        return this->bounds;
+    return this->bounds.transform(this->getModelMatrix());
+}
+
+void GameObject::updateTransform() {
+    this->model = this->getModelMatrix();
+    this->world_bounds = this->bounds.bounded() ? this->bounds.transform(this->model) : this->bounds;
+}
+
+bool GameObject::sameDrawState(const GameObject &other) const {
+    return this->active == other.active && this->lifetime == other.lifetime && this->pass == other.pass &&
+           this->render_context == other.render_context && this->bounds.min == other.bounds.min &&
+           this->bounds.max == other.bounds.max && this->occluder == other.occluder && this->mesh == other.mesh &&
+           this->lods == other.lods && this->texture.array == other.texture.array &&
+           this->texture.layer == other.texture.layer;
+}
+
+}  // namespace goat::world
@@ -2,9 +2,18 @@
 #include <glm/ext/matrix_transform.hpp>
 
 #include "constants.hpp"
+#include "gfx/TextureArray.hpp"
 #include "gfx/constants.hpp"
+#include "mesh/Mesh.hpp"
+#include "world/Bounds.hpp"
+#include "world/LOD.hpp"
+#include "world/Occlusion.hpp"
 #include "world/Transform.hpp"
 
+namespace goat::gfx {
+class RenderContext;
+}
+
 namespace goat::world {
 
 /**
@@ -17,6 +26,26 @@ struct GameObject {
     vec3 world_pos = vec3(0.0f, 0.0f, 0.0f);
     const gfx::ObjectLifetime lifetime = gfx::ObjectLifetime::SCENE;
     const std::shared_ptr<Transform> transform{};
+    // The render pass the object is drawn in
+    gfx::RenderPass pass = gfx::RenderPass::SOLID;
+    // The program/textures/VBOs to draw the object with (the scene's render context if unset)
+    std::shared_ptr<gfx::RenderContext> render_context{};
+    // Object-space bounds of the object's geometry, used for culling (unbounded objects are always drawn)
+    AABB bounds = AABB::unbounded();
+    // Simplified geometry drawn into the occlusion buffer to hide the objects behind this one (optional)
+    std::shared_ptr<const Occluder> occluder{};
+    // CPU-side copy of the object's geometry, merged into the scene's static batches when the lifetime is STATIC
+    std::shared_ptr<const mesh::Mesh> mesh{};
+    // Levels of detail drawn instead of the render context's VBOs, picked by distance (optional)
+    std::shared_ptr<const LODChain> lods{};
+    // The level of detail drawn last frame
+    size_t lod = 0UL;
+    // The texture array layer sampled by shaders reading `texture_array` (optional)
+    gfx::TextureSlot texture{};
+    // The model matrix and world bounds as of the last `updateTransform`. The scene refreshes them at the start of
+    // every frame (or copies them from the snapshot it draws), so rendering reads them rather than the transform
+    glm::mat4 model = glm::mat4(1.0f);
+    AABB world_bounds = AABB::unbounded();
 
     static std::shared_ptr<GameObject> create(
         vec3 world_pos = vec3(0.0f, 0.0f, 0.0f), gfx::ObjectLifetime lifetime = gfx::ObjectLifetime::SCENE,
@@ -30,8 +59,16 @@ struct GameObject {
     }
     // Return if the object is rendered using EBO/indices instead of VBO/vertices
     bool hasEBO() const;
+    // Return the position of the object in world space (its world position offset by its transform)
+    vec3 getWorldPosition() const;
     // Return the model matrix for the object taking its transformations into account
     glm::mat4 getModelMatrix() const;
+    // Return the bounds of the object in world space
+    AABB getWorldBounds() const;
+    // Recompute `model` and `world_bounds` from the transform
+    void updateTransform();
+    // Returns true if both objects are drawn the same way (everything but the transform and per-frame state)
+    bool sameDrawState(const GameObject &other) const;
     // Apply texture details to related shader uniforms
     void applyUniformData() const;
 };
@@ -0,0 +1,14 @@
+#include "LOD.hpp"
+
+namespace goat::world {
+
+size_t LODChain::select(float pixels_per_unit, float max_pixel_error, float hysteresis, size_t current) const {
+    for (size_t i = this->levels.size(); i-- > 1;) {
+        auto threshold = max_pixel_error * (i > current ? 1.0f - hysteresis : 1.0f + hysteresis);
+        if (this->levels[i].error * pixels_per_unit <= threshold)
+            return i;
+    }
+    return 0UL;
+}
+
+}  // namespace goat::world
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "gfx/VBO.hpp"
+
+namespace goat::world {
+
+// The largest error, in pixels, a level of detail may show on screen before a finer one is drawn
+static constexpr float DEFAULT_LOD_PIXEL_ERROR = 1.0f;
+// How far past the threshold (as a fraction of it) the error must go before the level changes again, so that
+// objects moving around a switching distance do not flicker between two levels
+static constexpr float DEFAULT_LOD_HYSTERESIS = 0.25f;
+
+// The geometry of one level of detail, and how far its surface is from the full detail one (in object units)
+struct LODLevel {
+    std::shared_ptr<gfx::VBO> vbo;
+    float error = 0.0f;
+};
+
+/**
+ * @brief The levels of detail of an object, from the full detail geometry to the coarsest. They replace the VBOs
+ *        of the object's render context when it is drawn, so they must share its vertex layout.
+ */
+struct LODChain {
+    // Ordered from the finest (error 0) to the coarsest level
+    std::vector<LODLevel> levels{};
+
+    /**
+     * @brief Pick the coarsest level whose error stays under `max_pixel_error` once projected. Coarser levels
+     *        than the current one need to be under the threshold by `hysteresis` (and finer levels over it by as
+     *        much) before they are picked, so the choice does not flip back and forth around the threshold.
+     * @param pixels_per_unit How many pixels one object unit covers at the object's distance
+     * @param current The level drawn last frame
+     */
+    size_t select(float pixels_per_unit, float max_pixel_error, float hysteresis, size_t current) const;
+};
+
+}  // namespace goat::world
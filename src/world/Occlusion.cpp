@@ -0,0 +1,436 @@
+#include "Occlusion.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace goat::world {
+
+namespace {
+
+// How much nearer (relative to its 1/w) a box is treated when it is tested, so an occluder never hides itself
+// through rounding when its bounds match its geometry
+constexpr float DEPTH_BIAS = 1e-5f;
+
+/**
+ * @brief The operations the span rasterizer needs on a group of `width` horizontally adjacent pixels. Every
+ *        implementation evaluates the same expressions in the same order, so they all produce the same depth.
+ */
+struct ScalarLanes {
+    using type = float;
+    static constexpr uint width = 1U;
+
+    static type set1(float value) {
+        return value;
+    }
+    // The offset of each pixel in the group
+    static type ramp() {
+        return 0.0f;
+    }
+    static type load(const float *data) {
+        return *data;
+    }
+    static void store(float *data, type value) {
+        *data = value;
+    }
+    static type add(type a, type b) {
+        return a + b;
+    }
+    static type mul(type a, type b) {
+        return a * b;
+    }
+    // Keep the nearest of `depth` and `z` wherever the pixel is inside of all three edges
+    static type merge(type depth, type z, type e0, type e1, type e2) {
+        return (e0 >= 0.0f && e1 >= 0.0f && e2 >= 0.0f) ? std::max(depth, z) : depth;
+    }
+};
+
+#if defined(__AVX2__)
+struct SimdLanes {
+    using type = __m256;
+    static constexpr uint width = 8U;
+
+    static type set1(float value) {
+        return _mm256_set1_ps(value);
+    }
+    static type ramp() {
+        return _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+    }
+    static type load(const float *data) {
+        return _mm256_loadu_ps(data);
+    }
+    static void store(float *data, type value) {
+        _mm256_storeu_ps(data, value);
+    }
+    static type add(type a, type b) {
+        return _mm256_add_ps(a, b);
+    }
+    static type mul(type a, type b) {
+        return _mm256_mul_ps(a, b);
+    }
+    // Depth is always positive, so masking `z` to 0 outside of the triangle leaves `depth` as it was
+    static type merge(type depth, type z, type e0, type e1, type e2) {
+        auto inside = _mm256_cmp_ps(_mm256_min_ps(_mm256_min_ps(e0, e1), e2), _mm256_setzero_ps(), _CMP_GE_OQ);
+        return _mm256_max_ps(depth, _mm256_and_ps(inside, z));
+    }
+};
+#elif defined(__SSE2__) || defined(_M_X64)
+struct SimdLanes {
+    using type = __m128;
+    static constexpr uint width = 4U;
+
+    static type set1(float value) {
+        return _mm_set1_ps(value);
+    }
+    static type ramp() {
+        return _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    }
+    static type load(const float *data) {
+        return _mm_loadu_ps(data);
+    }
+    static void store(float *data, type value) {
+        _mm_storeu_ps(data, value);
+    }
+    static type add(type a, type b) {
+        return _mm_add_ps(a, b);
+    }
+    static type mul(type a, type b) {
+        return _mm_mul_ps(a, b);
+    }
+    static type merge(type depth, type z, type e0, type e1, type e2) {
+        auto inside = _mm_cmpge_ps(_mm_min_ps(_mm_min_ps(e0, e1), e2), _mm_setzero_ps());
+        return _mm_max_ps(depth, _mm_and_ps(inside, z));
+    }
+};
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+struct SimdLanes {
+    using type = float32x4_t;
+    static constexpr uint width = 4U;
+
+    static type set1(float value) {
+        return vdupq_n_f32(value);
+    }
+    static type ramp() {
+        const float offsets[4] = {0.0f, 1.0f, 2.0f, 3.0f};
+        return vld1q_f32(offsets);
+    }
+    static type load(const float *data) {
+        return vld1q_f32(data);
+    }
+    static void store(float *data, type value) {
+        vst1q_f32(data, value);
+    }
+    static type add(type a, type b) {
+        return vaddq_f32(a, b);
+    }
+    static type mul(type a, type b) {
+        return vmulq_f32(a, b);
+    }
+    static type merge(type depth, type z, type e0, type e1, type e2) {
+        auto inside = vcgeq_f32(vminq_f32(vminq_f32(e0, e1), e2), vdupq_n_f32(0.0f));
+        return vmaxq_f32(depth, vreinterpretq_f32_u32(vandq_u32(inside, vreinterpretq_u32_f32(z))));
+    }
+};
+#else
+using SimdLanes = ScalarLanes;
+#endif
+
+/**
+ * @brief Rasterize the part of a triangle inside a tile, one row at a time. Spans start on a multiple of the lane
+ *        width, which never crosses the tile's edge since tiles are a multiple of every lane width wide.
+ */
+template <typename L>
+void rasterize_span(const auto &triangle, int tile_x, int tile_y, float *depth, uint width) {
+    auto x0 = std::max(triangle.min_x, tile_x), x1 = std::min(triangle.max_x, tile_x + (int)OCCLUSION_TILE_WIDTH - 1);
+    auto y0 = std::max(triangle.min_y, tile_y), y1 = std::min(triangle.max_y, tile_y + (int)OCCLUSION_TILE_HEIGHT - 1);
+    x0 -= x0 % static_cast<int>(L::width);
+
+    const auto a0 = L::set1(triangle.edges[0].x), a1 = L::set1(triangle.edges[1].x),
+               a2 = L::set1(triangle.edges[2].x), az = L::set1(triangle.depth.x);
+    const auto ramp = L::ramp();
+    for (auto y = y0; y <= y1; y++) {
+        auto py = static_cast<float>(y) + 0.5f;
+        auto row0 = L::set1(triangle.edges[0].y * py + triangle.edges[0].z);
+        auto row1 = L::set1(triangle.edges[1].y * py + triangle.edges[1].z);
+        auto row2 = L::set1(triangle.edges[2].y * py + triangle.edges[2].z);
+        auto row_z = L::set1(triangle.depth.y * py + triangle.depth.z);
+        auto line = depth + static_cast<size_t>(y) * width;
+        for (auto x = x0; x <= x1; x += L::width) {
+            auto px = L::add(L::set1(static_cast<float>(x) + 0.5f), ramp);
+            auto e0 = L::add(L::mul(a0, px), row0);
+            auto e1 = L::add(L::mul(a1, px), row1);
+            auto e2 = L::add(L::mul(a2, px), row2);
+            auto z = L::add(L::mul(az, px), row_z);
+            L::store(line + x, L::merge(L::load(line + x), z, e0, e1, e2));
+        }
+    }
+}
+
+// Rasterize every tile's triangles (the tiles are independent, and each one stays in cache while it is filled)
+template <typename L>
+void rasterize_tiles(const auto &triangles, const std::vector<std::vector<uint32_t>> &bins, uint tiles_x,
+                     float *depth, uint width) {
+    for (size_t tile = 0; tile < bins.size(); tile++) {
+        auto tile_x = static_cast<int>((tile % tiles_x) * OCCLUSION_TILE_WIDTH);
+        auto tile_y = static_cast<int>((tile / tiles_x) * OCCLUSION_TILE_HEIGHT);
+        for (auto index : bins[tile])
+            rasterize_span<L>(triangles[index], tile_x, tile_y, depth, width);
+    }
+}
+
+}  // namespace
+
+std::shared_ptr<const Occluder> Occluder::fromPoints(const float *points, size_t count, size_t stride,
+                                                     const std::vector<uint> &indices) {
+    auto occluder = std::make_shared<Occluder>();
+    occluder->positions.reserve(count);
+    for (size_t i = 0; i < count; i++)
+        occluder->positions.push_back(vec3(points[i * stride], points[i * stride + 1], points[i * stride + 2]));
+    for (auto index : indices)
+        if (index >= count)
+            throw std::runtime_error("Occluder index out of range");
+    occluder->indices = indices;
+    return occluder;
+}
+
+std::shared_ptr<const Occluder> Occluder::fromBox(const AABB &bounds) {
+    auto occluder = std::make_shared<Occluder>();
+    for (uint corner = 0; corner < 8; corner++)
+        occluder->positions.push_back(vec3(corner & 1 ? bounds.max.x : bounds.min.x,
+                                           corner & 2 ? bounds.max.y : bounds.min.y,
+                                           corner & 4 ? bounds.max.z : bounds.min.z));
+    // Two triangles per face (the rasterizer draws both windings, so their orientation does not matter)
+    occluder->indices = {0, 1, 3, 0, 3, 2, 4, 5, 7, 4, 7, 6, 0, 1, 5, 0, 5, 4,
+                         2, 3, 7, 2, 7, 6, 0, 2, 6, 0, 6, 4, 1, 3, 7, 1, 7, 5};
+    return occluder;
+}
+
+OcclusionBuffer::OcclusionBuffer(uint width, uint height) : width(width), height(height) {
+    if (width == 0 || height == 0 || width % OCCLUSION_TILE_WIDTH != 0) {
+        std::stringstream error;
+        error << "Invalid occlusion buffer size " << width << "x" << height << " (the width must be a multiple of "
+              << OCCLUSION_TILE_WIDTH << ")";
+        throw std::runtime_error(error.str());
+    }
+    this->tiles_x = width / OCCLUSION_TILE_WIDTH;
+    this->tiles_y = (height + OCCLUSION_TILE_HEIGHT - 1) / OCCLUSION_TILE_HEIGHT;
+    this->bins.resize(this->tiles_x * this->tiles_y);
+
+    this->levels.push_back(Level{width, height, std::vector<float>(width * height)});
+    while (width > 1 || height > 1) {
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+        this->levels.push_back(Level{width, height, std::vector<float>(width * height)});
+    }
+}
+
+void OcclusionBuffer::begin(const mat4 &view_projection) {
+    this->view_projection = view_projection;
+    std::fill(this->levels[0].depth.begin(), this->levels[0].depth.end(), 0.0f);
+    this->triangles.clear();
+    for (auto &bin : this->bins)
+        bin.clear();
+    this->stats = OcclusionStats{};
+}
+
+/**
+ * @brief Transform the occluder to clip space, drop the triangles outside of the frustum and clip the ones that
+ *        cross the near plane (the other planes are handled by clamping to the screen while binning).
+ */
+void OcclusionBuffer::addOccluder(const Occluder &occluder, const mat4 &model) {
+    auto transform = this->view_projection * model;
+    this->clip_positions.clear();
+    for (const auto &position : occluder.positions)
+        this->clip_positions.push_back(transform * vec4(position, 1.0f));
+    this->stats.occluders++;
+
+    const auto &clip = this->clip_positions;
+    for (size_t i = 0; i + 2 < occluder.indices.size(); i += 3) {
+        const vec4 *vertices[3] = {&clip[occluder.indices[i]], &clip[occluder.indices[i + 1]],
+                                   &clip[occluder.indices[i + 2]]};
+
+        // Outcodes of each vertex against the planes of the clip volume, plus the count behind the near plane
+        uint outside_all = ~0U;
+        uint behind = 0U;
+        for (auto vertex : vertices) {
+            const auto &v = *vertex;
+            uint code = (v.x < -v.w ? 1U : 0U) | (v.x > v.w ? 2U : 0U) | (v.y < -v.w ? 4U : 0U) |
+                        (v.y > v.w ? 8U : 0U) | (v.z < -v.w ? 16U : 0U) | (v.z > v.w ? 32U : 0U);
+            outside_all &= code;
+            behind += (code & 16U) ? 1U : 0U;
+        }
+        if (outside_all != 0)
+            continue;
+        if (behind == 0) {
+            this->addTriangle(*vertices[0], *vertices[1], *vertices[2]);
+            continue;
+        }
+
+        // Sutherland-Hodgman against the near plane (z >= -w), giving a triangle or a quad
+        vec4 polygon[4];
+        size_t count = 0;
+        for (size_t v = 0; v < 3; v++) {
+            const auto &current = *vertices[v];
+            const auto &next = *vertices[(v + 1) % 3];
+            auto d_current = current.z + current.w, d_next = next.z + next.w;
+            if (d_current >= 0.0f)
+                polygon[count++] = current;
+            if ((d_current >= 0.0f) != (d_next >= 0.0f))
+                polygon[count++] = current + (next - current) * (d_current / (d_current - d_next));
+        }
+        for (size_t v = 2; v < count; v++)
+            this->addTriangle(polygon[0], polygon[v - 1], polygon[v]);
+    }
+}
+
+void OcclusionBuffer::addTriangle(const vec4 &a, const vec4 &b, const vec4 &c) {
+    auto w = static_cast<float>(this->width), h = static_cast<float>(this->height);
+    auto project = [&](const vec4 &v) {
+        auto inverse_w = 1.0f / v.w;
+        return vec3((v.x * inverse_w * 0.5f + 0.5f) * w, (v.y * inverse_w * 0.5f + 0.5f) * h, inverse_w);
+    };
+    vec3 p[3] = {project(a), project(b), project(c)};
+
+    // Orient every triangle counter-clockwise, so both windings are drawn
+    auto area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[1].y - p[0].y) * (p[2].x - p[0].x);
+    if (area < 0.0f) {
+        std::swap(p[1], p[2]);
+        area = -area;
+    }
+    if (!(area > 1e-6f))
+        return;
+
+    // The pixels whose centers are inside the bounding rectangle of the triangle, clamped to the screen
+    auto min_x = std::clamp(std::ceil(std::min({p[0].x, p[1].x, p[2].x}) - 0.5f), 0.0f, w);
+    auto max_x = std::clamp(std::floor(std::max({p[0].x, p[1].x, p[2].x}) - 0.5f), -1.0f, w - 1.0f);
+    auto min_y = std::clamp(std::ceil(std::min({p[0].y, p[1].y, p[2].y}) - 0.5f), 0.0f, h);
+    auto max_y = std::clamp(std::floor(std::max({p[0].y, p[1].y, p[2].y}) - 0.5f), -1.0f, h - 1.0f);
+    if (min_x > max_x || min_y > max_y)
+        return;
+
+    Triangle triangle{};
+    triangle.min_x = static_cast<int>(min_x);
+    triangle.max_x = static_cast<int>(max_x);
+    triangle.min_y = static_cast<int>(min_y);
+    triangle.max_y = static_cast<int>(max_y);
+
+    // Edge i runs from vertex i to vertex i + 1, and is positive on the inner side. Normalized by the area, the
+    // edge opposite of a vertex is that vertex's barycentric weight, which interpolates 1/w across the triangle
+    triangle.depth = vec3(0.0f, 0.0f, 0.0f);
+    for (size_t i = 0; i < 3; i++) {
+        const auto &from = p[i];
+        const auto &to = p[(i + 1) % 3];
+        auto edge_a = from.y - to.y, edge_b = to.x - from.x;
+        triangle.edges[i] = vec3(edge_a, edge_b, -(edge_a * from.x + edge_b * from.y));
+        triangle.depth += triangle.edges[i] * (p[(i + 2) % 3].z / area);
+    }
+
+    auto index = static_cast<uint32_t>(this->triangles.size());
+    this->triangles.push_back(triangle);
+    this->stats.triangles++;
+    for (auto ty = triangle.min_y / OCCLUSION_TILE_HEIGHT; ty <= triangle.max_y / OCCLUSION_TILE_HEIGHT; ty++) {
+        for (auto tx = triangle.min_x / OCCLUSION_TILE_WIDTH; tx <= triangle.max_x / OCCLUSION_TILE_WIDTH; tx++) {
+            this->bins[ty * this->tiles_x + tx].push_back(index);
+            this->stats.binned++;
+        }
+    }
+}
+
+void OcclusionBuffer::rasterize() {
+    rasterize_tiles<SimdLanes>(this->triangles, this->bins, this->tiles_x, this->levels[0].depth.data(), this->width);
+    this->buildHierarchy();
+}
+
+void OcclusionBuffer::rasterizeScalar() {
+    rasterize_tiles<ScalarLanes>(this->triangles, this->bins, this->tiles_x, this->levels[0].depth.data(),
+                                 this->width);
+    this->buildHierarchy();
+}
+
+void OcclusionBuffer::buildHierarchy() {
+    for (size_t level = 1; level < this->levels.size(); level++) {
+        const auto &below = this->levels[level - 1];
+        auto &current = this->levels[level];
+        for (uint y = 0; y < current.height; y++) {
+            auto y0 = y * 2, y1 = std::min(y * 2 + 1, below.height - 1);
+            for (uint x = 0; x < current.width; x++) {
+                auto x0 = x * 2, x1 = std::min(x * 2 + 1, below.width - 1);
+                current.depth[y * current.width + x] =
+                    std::min({below.depth[y0 * below.width + x0], below.depth[y0 * below.width + x1],
+                              below.depth[y1 * below.width + x0], below.depth[y1 * below.width + x1]});
+            }
+        }
+    }
+}
+
+bool OcclusionBuffer::visible(const AABB &bounds) const {
+    // The corners of the box in clip space are its center plus or minus each of its transformed half axes
+    auto center = this->view_projection * vec4(bounds.center(), 1.0f);
+    auto extents = bounds.extents();
+    const vec4 axes[3] = {this->view_projection[0] * extents.x, this->view_projection[1] * extents.y,
+                          this->view_projection[2] * extents.z};
+
+    constexpr auto infinity = std::numeric_limits<float>::infinity();
+    float min_x = infinity, min_y = infinity, max_x = -infinity, max_y = -infinity, nearest = 0.0f;
+    for (uint corner = 0; corner < 8; corner++) {
+        auto clip = center + axes[0] * (corner & 1 ? 1.0f : -1.0f) + axes[1] * (corner & 2 ? 1.0f : -1.0f) +
+                    axes[2] * (corner & 4 ? 1.0f : -1.0f);
+        if (clip.w <= 0.0f || clip.z < -clip.w)
+            return true;
+        auto inverse_w = 1.0f / clip.w;
+        min_x = std::min(min_x, clip.x * inverse_w);
+        max_x = std::max(max_x, clip.x * inverse_w);
+        min_y = std::min(min_y, clip.y * inverse_w);
+        max_y = std::max(max_y, clip.y * inverse_w);
+        nearest = std::max(nearest, inverse_w);
+    }
+    nearest *= 1.0f + DEPTH_BIAS;
+
+    // Boxes that leave the screen are partly outside of the buffer, and left to frustum culling
+    auto w = static_cast<float>(this->width), h = static_cast<float>(this->height);
+    min_x = (min_x * 0.5f + 0.5f) * w;
+    max_x = (max_x * 0.5f + 0.5f) * w;
+    min_y = (min_y * 0.5f + 0.5f) * h;
+    max_y = (max_y * 0.5f + 0.5f) * h;
+    if (min_x < 0.0f || min_y < 0.0f || max_x >= w || max_y >= h)
+        return true;
+
+    // Pick the level at which the rectangle covers at most a few texels on each axis
+    auto x0 = static_cast<uint>(min_x), x1 = static_cast<uint>(max_x);
+    auto y0 = static_cast<uint>(min_y), y1 = static_cast<uint>(max_y);
+    auto span = std::max(x1 - x0, y1 - y0) + 1;
+    auto level_index = std::min(static_cast<size_t>(std::bit_width(span >> 2)), this->levels.size() - 1);
+    const auto &level = this->levels[level_index];
+    x0 >>= level_index, x1 >>= level_index, y0 >>= level_index, y1 >>= level_index;
+
+    for (auto y = y0; y <= y1; y++)
+        for (auto x = x0; x <= x1; x++)
+            if (level.depth[y * level.width + x] <= nearest)
+                return true;
+    return false;
+}
+
+const char *OcclusionBuffer::simdPath() {
+#if defined(__AVX2__)
+    return "AVX2 (8-wide)";
+#elif defined(__SSE2__) || defined(_M_X64)
+    return "SSE2 (4-wide)";
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    return "NEON (4-wide)";
+#else
+    return "scalar";
+#endif
+}
+
+}  // namespace goat::world
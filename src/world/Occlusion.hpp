@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "world/Bounds.hpp"
+
+namespace goat::world {
+
+// The resolution of the occlusion depth buffer (the width must be a multiple of `OCCLUSION_TILE_WIDTH`)
+static constexpr uint DEFAULT_OCCLUSION_WIDTH = 256U;
+static constexpr uint DEFAULT_OCCLUSION_HEIGHT = 128U;
+// Occluder triangles are binned into tiles of this many pixels, and each tile is rasterized on its own
+static constexpr uint OCCLUSION_TILE_WIDTH = 32U;
+static constexpr uint OCCLUSION_TILE_HEIGHT = 8U;
+// The number of occluders rasterized per frame (the largest ones on screen are picked)
+static constexpr size_t DEFAULT_MAX_OCCLUDERS = 64UL;
+
+/**
+ * @brief Object-space triangles drawn into the occlusion buffer for an object. They should be a simplified,
+ *        closed version of the object's geometry that never covers more of the screen than the object itself.
+ */
+struct Occluder {
+    std::vector<vec3> positions{};
+    std::vector<uint> indices{};
+
+    // Build an occluder from the XYZ of `count` points, each `stride` floats apart, and a triangle list
+    static std::shared_ptr<const Occluder> fromPoints(const float *points, size_t count, size_t stride,
+                                                      const std::vector<uint> &indices);
+
+    // Build an occluder covering a box
+    static std::shared_ptr<const Occluder> fromBox(const AABB &bounds);
+
+    size_t triangleCount() const {
+        return this->indices.size() / 3;
+    }
+};
+
+// Per-frame occlusion buffer statistics
+struct OcclusionStats {
+    size_t occluders = 0UL;
+    // Occluder triangles that reached the screen (after clipping), and how many tiles they were binned into
+    size_t triangles = 0UL;
+    size_t binned = 0UL;
+};
+
+/**
+ * @brief A low resolution software depth buffer for occlusion culling. Occluders are transformed and clipped by
+ *        `addOccluder`, and their triangles binned into screen tiles. `rasterize` then fills each tile with SIMD
+ *        spans (4 pixels with SSE/NEON, 8 with AVX2) and builds a depth hierarchy, which `visible` tests the
+ *        screen rectangle of a box against.
+ *
+ * @note Depth is stored as 1/w, which is linear in screen space and keeps float precision over the whole view
+ *       range. Bigger values are nearer, and the buffer is cleared to 0 (infinitely far).
+ */
+class OcclusionBuffer {
+   private:
+    // A clipped occluder triangle in screen space: edge functions and depth as planes (a * x + b * y + c)
+    struct Triangle {
+        vec3 edges[3];
+        vec3 depth;
+        int min_x, min_y, max_x, max_y;
+    };
+
+    // One level of the depth hierarchy, each texel holding the farthest depth of 2x2 texels of the level below
+    struct Level {
+        uint width, height;
+        std::vector<float> depth;
+    };
+
+    uint width, height;
+    uint tiles_x, tiles_y;
+    mat4 view_projection = mat4(1.0f);
+    // Level 0 is the full resolution depth buffer
+    std::vector<Level> levels{};
+    std::vector<Triangle> triangles{};
+    // The triangles overlapping each tile, in the order they were added
+    std::vector<std::vector<uint32_t>> bins{};
+    // Scratch storage for the clip-space vertices of the occluder being added
+    std::vector<vec4> clip_positions{};
+    OcclusionStats stats{};
+
+    // Set up a triangle from clip-space vertices in front of the near plane and bin it
+    void addTriangle(const vec4 &a, const vec4 &b, const vec4 &c);
+    // Build every hierarchy level from level 0
+    void buildHierarchy();
+
+   public:
+    OcclusionBuffer(uint width = DEFAULT_OCCLUSION_WIDTH, uint height = DEFAULT_OCCLUSION_HEIGHT);
+
+    // Clear the buffer and the binned triangles for a new view
+    void begin(const mat4 &view_projection);
+
+    // Transform, clip and bin the triangles of an occluder (nothing is drawn until `rasterize`)
+    void addOccluder(const Occluder &occluder, const mat4 &model);
+
+    // Rasterize every binned triangle, one tile at a time, with the widest SIMD instruction set the build targets
+    void rasterize();
+
+    // The same as `rasterize`, without SIMD (the reference implementation)
+    void rasterizeScalar();
+
+    /**
+     * @brief Test a world-space box against the depth hierarchy. Conservative: boxes that cross the near plane or
+     *        leave the screen are visible, and a box is only occluded when every texel under its screen rectangle
+     *        is nearer than the nearest point of the box.
+     */
+    bool visible(const AABB &bounds) const;
+
+    uint getWidth() const {
+        return this->width;
+    }
+    uint getHeight() const {
+        return this->height;
+    }
+
+    // The full resolution depth buffer (1/w per pixel, row 0 at the bottom of the screen)
+    const std::vector<float> &getDepth() const {
+        return this->levels[0].depth;
+    }
+
+    const OcclusionStats &getStats() const {
+        return this->stats;
+    }
+
+    // The name of the SIMD implementation used by `rasterize`
+    static const char *simdPath();
+};
+
+}  // namespace goat::world
@@ -1,5 +1,12 @@
 #include "Scene.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
 #include "world/GameObject.hpp"
 
 namespace goat::world {
@@ -24,32 +31,789 @@ void Scene::use() const {
 }
 
 void Scene::render() const {
+    this->frame_objects.reset();
+    this->updateTransforms();
+    this->draw();
+}
+
+void Scene::render(const SceneSnapshot &snapshot) const {
+    assert(snapshot.objects != nullptr);
+    // The scene's camera and the cached transforms of the objects belong to the render thread
+    *this->camera = snapshot.camera;
+    this->frame_objects = snapshot.objects;
+    const auto &objects = *snapshot.objects;
+    for (size_t i = 0; i < objects.size(); i++) {
+        if (objects[i] == nullptr)
+            continue;
+        objects[i]->model = snapshot.models[i];
+        objects[i]->world_bounds = snapshot.bounds[i];
+    }
+    this->draw();
+}
+
+void Scene::draw() const {
     assert(this->render_context != nullptr);
     auto timeStart = std::chrono::high_resolution_clock::now();
+    auto stateBefore = gfx::GLState::get().getStats();
     this->use();
 
-    const float *projection = static_cast<const float *>(glm::value_ptr(this->camera->getProjectionMatrix()));
-    this->render_context->setMatrix("projection", projection, 4);
+    // Projection and view are read from the shared `FrameData` uniform block, filled once per frame by the window
+    GLint viewport[4]{};
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    this->lod_scale = this->camera->getProjectionMatrix()[1][1] * static_cast<float>(viewport[3]) * 0.5f;
+    bool indirect = this->gpu_culling && gfx::GPUCuller::supported();
+    this->cullObjects();
+    if (this->culling && this->occlusion_culling)
+        this->occludeObjects();
+    this->queueDraws();
+    this->queue.sort();
+
+    size_t draw_calls = 0UL, prepass_calls = 0UL;
+    if (this->depth_prepass) {
+        if (!this->prepass)
+            this->prepass = std::make_unique<gfx::DepthPrepass>();
+        this->prepass_query.begin();
+        prepass_calls = this->submitDepthPrepass();
+        this->prepass_query.end();
+    }
+    this->shading_query.begin();
+    draw_calls += indirect ? this->submitIndirect() : 0UL;
+    if (this->static_batching) {
+        this->updateStaticBatches();
+        draw_calls += this->submitStatic();
+    }
+    if (this->depth_prepass)
+        this->prepass->shade(this->depth_prepass_equal ? GL_EQUAL : GL_LEQUAL);
+    draw_calls += this->submitDraws(this->depth_prepass);
+    if (this->depth_prepass)
+        this->prepass->restore();
+    this->shading_query.end();
+    // The next frame tests the objects drawn on the GPU against the depth of this one
+    if (indirect)
+        this->gpu_culler->buildDepthPyramid(this->camera->getProjectionMatrix() * this->camera->view);
+
+    auto stateAfter = gfx::GLState::get().getStats();
+    auto obj_count = this->drawnObjects().size();
+    auto timeEnd = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(timeEnd - timeStart);
+    LOG(INFO) << "Scene<" << this->name << ">::render() [" << duration.count() << "μs] " << obj_count << " objects ("
+              << this->cull_stats.visible << " visible, " << this->cull_stats.culled << " culled, "
+              << this->cull_stats.occluded << " occluded), " << draw_calls << " draw calls, "
+              << (stateAfter.issued - stateBefore.issued) << " state changes ("
+              << (stateAfter.skipped - stateBefore.skipped) << " redundant skipped)";
+
+    // GPU results lag a few frames behind; shaded samples only count fragments that passed the depth test
+    const auto &shading = this->shading_query.getResult();
+    if (shading.valid) {
+        std::stringstream gpu;
+        gpu << "Scene<" << this->name << "> GPU: ";
+        if (this->depth_prepass)
+            gpu << "depth prepass " << this->prepass_query.getResult().gpu_ms << "ms (" << prepass_calls
+                << " draw calls), ";
+        gpu << "shading " << shading.gpu_ms << "ms, " << shading.samples << " samples shaded";
+        LOG(INFO) << gpu.str();
+    }
+}
+
+/**
+ * @brief Refresh the model matrix and world bounds of every object, split across the job system's threads when
+ *        the scene has one (each object only writes its own fields, so chunks never touch the same data).
+ */
+void Scene::updateTransforms() const {
+    this->splitObjects([this](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+            if (this->objects[i] != nullptr)
+                this->objects[i]->updateTransform();
+    });
+}
+
+/**
+ * @brief Capture the objects and their transforms for the render thread. The render thread draws copies of the
+ *        objects, which only it writes to (their transforms and level of detail) and which never change once
+ *        captured: an object whose draw state changed gets a new copy in a new list, while earlier snapshots keep
+ *        the old one. An unchanged scene costs a comparison of the draw state of each object.
+ */
+void Scene::capture(SceneSnapshot &snapshot) const {
+    // Draw states are compared while the transforms are captured, as both read every object
+    bool resized = this->captured_objects == nullptr || this->captured_sources.size() != this->objects.size();
+    std::atomic<bool> changed = resized;
+    snapshot.models.resize(this->objects.size());
+    snapshot.bounds.resize(this->objects.size());
+    this->splitObjects([this, &snapshot, &changed, resized](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            const auto &object = this->objects[i];
+            // Copies are only read here for their draw state, which the render thread does not write to
+            if (!resized && !changed.load(std::memory_order_relaxed) &&
+                (object != this->captured_sources[i] ||
+                 (object != nullptr && !object->sameDrawState(*(*this->captured_objects)[i]))))
+                changed.store(true, std::memory_order_relaxed);
+            if (object == nullptr)
+                continue;
+            snapshot.models[i] = object->getModelMatrix();
+            snapshot.bounds[i] =
+                object->bounds.bounded() ? object->bounds.transform(snapshot.models[i]) : object->bounds;
+        }
+    });
+
+    if (changed) {
+        auto copies = std::make_shared<ObjectList>(this->objects.size());
+        for (size_t i = 0; i < this->objects.size(); i++) {
+            const auto &object = this->objects[i];
+            if (object == nullptr)
+                continue;
+            bool same = !resized && object == this->captured_sources[i] &&
+                        object->sameDrawState(*(*this->captured_objects)[i]);
+            (*copies)[i] = same ? (*this->captured_objects)[i] : std::make_shared<GameObject>(*object);
+        }
+        this->captured_sources = this->objects;
+        this->captured_objects = copies;
+    }
+    snapshot.objects = this->captured_objects;
+}
+
+void Scene::splitObjects(const std::function<void(size_t, size_t)> &fn) const {
+    if (this->jobs != nullptr && this->objects.size() >= TRANSFORM_JOB_GRAIN * 2)
+        this->jobs->parallelFor(this->objects.size(), TRANSFORM_JOB_GRAIN, fn);
+    else
+        fn(0, this->objects.size());
+}
+
+const ObjectList &Scene::drawnObjects() const {
+    return this->frame_objects != nullptr ? *this->frame_objects : this->objects;
+}
+
+bool Scene::batchedStatic(const GameObject &object) const {
+    return this->static_batching && object.lifetime == gfx::ObjectLifetime::STATIC && object.mesh != nullptr &&
+           object.pass == gfx::RenderPass::SOLID;
+}
+
+void Scene::updateStaticBatches() const {
+    const auto &objects = this->drawnObjects();
+    this->static_scratch.clear();
+    for (size_t i = 0; i < objects.size(); i++)
+        if (objects[i] != nullptr && this->batchedStatic(*objects[i]))
+            this->static_scratch.push_back(static_cast<uint32_t>(i));
+    if (this->static_scratch == this->static_objects)
+        return;
+    this->static_objects.swap(this->static_scratch);
+
+    // Group the objects by context, texture and vertex layout: each group is merged into its own VBO
+    std::vector<StaticBatch> batches;
+    std::vector<std::vector<const GameObject *>> groups;
+    for (auto index : this->static_objects) {
+        const auto &object = objects[index];
+        auto context = object->render_context ? object->render_context.get() : this->render_context.get();
+        auto array = object->texture.valid() ? object->texture.array.get() : nullptr;
+        auto layer = object->texture.valid() ? object->texture.layer : 0U;
+        size_t group = 0;
+        for (; group < batches.size(); group++) {
+            const auto &batch = batches[group];
+            if (batch.context == context && batch.array == array && batch.layer == layer &&
+                groups[group].front()->mesh->vertex_size == object->mesh->vertex_size)
+                break;
+        }
+        if (group == batches.size()) {
+            batches.push_back(StaticBatch{.context = context, .array = array, .layer = layer});
+            groups.emplace_back();
+        }
+        groups[group].push_back(object.get());
+    }
+
+    for (size_t i = 0; i < batches.size(); i++) {
+        auto geometry = StaticGeometry::merge(groups[i], this->static_chunk_size);
+        const auto &vbos = batches[i].context->getVBOs();
+        if (vbos.empty())
+            throw std::runtime_error("Static objects must be drawn by a render context with a VBO");
+        batches[i].vbo = StaticBatch::upload(geometry.mesh, *vbos.front());
+        batches[i].chunks = std::move(geometry.chunks);
+    }
+    this->static_batches.swap(batches);
+    LOG(INFO) << "Scene<" << this->name << "> merged " << this->static_objects.size() << " static objects into "
+              << this->static_batches.size() << " batches";
+}
+
+/**
+ * @brief Test the chunks of each static batch against the camera frustum, drawing each run of consecutive visible
+ *        chunks with a single range draw. Batched geometry is already in world space, so it is drawn with an
+ *        identity model matrix.
+ */
+size_t Scene::submitStatic() const {
+    auto frustum = Frustum::fromMatrix(this->camera->getProjectionMatrix() * this->camera->view);
+    const auto identity = mat4(1.0f);
+    size_t draw_calls = 0UL, visible = 0UL, culled = 0UL;
+    auto &state = gfx::GLState::get();
+    gfx::RenderContext *context = nullptr;
 
-    const float *view = static_cast<const float *>(glm::value_ptr(this->camera->view));
-    this->render_context->setMatrix("view", view, 4);
+    for (const auto &batch : this->static_batches) {
+        bool bound = false;
+        size_t first = 0UL, count = 0UL;
+        auto flush = [&]() {
+            if (count == 0)
+                return;
+            if (!bound) {
+                if (batch.context != context) {
+                    context = batch.context;
+                    context->compile();
+                    context->use();
+                    // Chunks have no size on screen to stream textures by: they want their finest levels
+                    context->requestTextures(std::numeric_limits<float>::infinity());
+                }
+                batch.vbo->use();
+                if (batch.array != nullptr)
+                    state.bindTexture(gfx::TEXTURE_ARRAY_UNIT, GL_TEXTURE_2D_ARRAY, batch.array->getHandle());
+                if (this->instanced) {
+                    // A single identity instance, read by the instanced shader for every vertex of the batch
+                    if (!batch.vbo->isInstanced()) {
+                        batch.vbo->enableInstancing();
+                        batch.vbo->uploadInstances({identity}, batch.array != nullptr ? std::vector<uint>{batch.layer}
+                                                                                    : std::vector<uint>{});
+                    }
+                } else {
+                    context->setMatrix(context->getModelUniform(), glm::value_ptr(identity), 4);
+                    if (context->getLayerUniform().valid())
+                        context->setUInt(context->getLayerUniform(), batch.layer);
+                }
+                bound = true;
+            }
+            batch.vbo->drawRange(first, count);
+            ++draw_calls;
+            count = 0UL;
+        };
 
+        for (const auto &chunk : batch.chunks) {
+            if (this->culling && !frustum.intersects(chunk.bounds)) {
+                ++culled;
+                flush();
+                continue;
+            }
+            ++visible;
+            if (count > 0 && first + count == chunk.first_index) {
+                count += chunk.index_count;
+            } else {
+                flush();
+                first = chunk.first_index;
+                count = chunk.index_count;
+            }
+        }
+        flush();
+    }
 #ifdef __DEBUG__
-    LOG(DEBUG) << "\tProjection = [x=" << projection[0] << ", y=" << projection[1] << ", z=" << projection[2]
-               << ", w=" << projection[3] << "]";
-    LOG(DEBUG) << "\t      View = [x=" << view[0] << ", y=" << view[1] << ", z=" << view[2] << ", w=" << view[3] << "]";
+    LOG(DEBUG) << "Scene<" << this->name << ">::submitStatic() " << visible << " chunks visible, " << culled
+               << " culled, " << draw_calls << " draw calls";
 #endif
-    for (const auto &object : this->objects) {
-        if (object != nullptr) {
-            auto model = static_cast<const float *>(glm::value_ptr(object->getModelMatrix()));
-            this->render_context->setMatrix("model", model, 4);
-            this->render_context->render(this->camera.get());
+    return draw_calls;
+}
+
+bool Scene::drawnIndirect(const GameObject &object) const {
+    if (!this->gpu_culling || object.pass != gfx::RenderPass::SOLID || !gfx::GPUCuller::supported() ||
+        this->batchedStatic(object))
+        return false;
+    // Commands can only draw indexed geometry
+    if (object.lods)
+        return std::all_of(object.lods->levels.begin(), object.lods->levels.end(),
+                           [](const LODLevel &level) { return level.vbo->indexCount() > 0; });
+    auto context = object.render_context ? object.render_context.get() : this->render_context.get();
+    for (const auto &vbo : context->getVBOs())
+        if (vbo->indexCount() == 0)
+            return false;
+    return true;
+}
+
+/**
+ * @brief Gather the model matrix and world bounds of every solid object into one batch per VBO, context and
+ *        texture array, then cull them all with a single compute dispatch and draw each batch with a single
+ *        glMultiDrawElementsIndirect. No per-object culling or draw call happens on the CPU.
+ */
+size_t Scene::submitIndirect() const {
+    if (!this->gpu_culler)
+        this->gpu_culler = std::make_unique<gfx::GPUCuller>();
+    for (auto &batch : this->indirect_batches) {
+        batch.models.clear();
+        batch.layers.clear();
+        batch.instances.clear();
+    }
+
+    IndirectBatch *batch = nullptr;
+    for (const auto &object : this->drawnObjects()) {
+        if (object == nullptr || !this->drawnIndirect(*object))
+            continue;
+
+        auto context = object->render_context ? object->render_context.get() : this->render_context.get();
+        context->compile();
+        auto array = object->texture.valid() ? object->texture.array.get() : nullptr;
+        auto bounds = object->world_bounds;
+        auto model = object->model;
+        // Objects with levels of detail draw the selected level instead of the context's geometry
+        gfx::VBO *lod = object->lods ? this->selectLOD(*object) : nullptr;
+        auto vbo_count = lod != nullptr ? 1UL : context->getVBOs().size();
+        for (size_t v = 0; v < vbo_count; v++) {
+            auto vbo = lod != nullptr ? lod : context->getVBOs()[v].get();
+            // Consecutive objects usually share a batch, so only search for another one when they do not
+            if (batch == nullptr || batch->context != context || batch->vbo != vbo || batch->array != array) {
+                auto it = std::find_if(this->indirect_batches.begin(), this->indirect_batches.end(),
+                                       [&](const auto &b) {
+                                           return b.context == context && b.vbo == vbo && b.array == array;
+                                       });
+                if (it == this->indirect_batches.end()) {
+                    this->indirect_batches.push_back(IndirectBatch{.context = context, .vbo = vbo, .array = array});
+                    it = this->indirect_batches.end() - 1;
+                }
+                batch = &*it;
+            }
+
+            auto instance = gfx::GPUInstance{
+                .center = vec4(0.0f, 0.0f, 0.0f, 0.0f),
+                .extents = vec4(0.0f, 0.0f, 0.0f, 0.0f),
+                .index_count = static_cast<uint>(vbo->indexCount()),
+                .first_index = vbo->firstIndex(),
+                .base_vertex = vbo->baseVertex(),
+                .base_instance = static_cast<uint>(batch->models.size()),
+            };
+            if (bounds.bounded()) {
+                instance.center = vec4(bounds.center(), 1.0f);
+                instance.extents = vec4(bounds.extents(), 0.0f);
+            }
+            batch->instances.push_back(instance);
+            batch->models.push_back(model);
+            if (array != nullptr)
+                batch->layers.push_back(object->texture.layer);
         }
     }
-    auto obj_count = this->objects.size();
-    auto timeEnd = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(timeEnd - timeStart);
-    LOG(INFO) << "Scene<" << this->name << ">::render() [" << duration.count() << "μs] " << obj_count << " objects";
+
+    // Every batch's commands are laid out one after the other, so the whole scene is culled by one dispatch
+    this->indirect_instances.clear();
+    for (auto &batch : this->indirect_batches) {
+        batch.first = this->indirect_instances.size();
+        this->indirect_instances.insert(this->indirect_instances.end(), batch.instances.begin(), batch.instances.end());
+    }
+    if (this->indirect_instances.empty())
+        return 0UL;
+    this->gpu_culler->cull(this->indirect_instances, this->camera->getProjectionMatrix() * this->camera->view);
+
+    size_t draw_calls = 0UL;
+    auto &state = gfx::GLState::get();
+    gfx::RenderContext *context = nullptr;
+    for (const auto &batch : this->indirect_batches) {
+        if (batch.instances.empty())
+            continue;
+        if (batch.context != context) {
+            context = batch.context;
+            context->use();
+            // Objects culled on the GPU have no size on screen to stream textures by: they want their finest levels
+            context->requestTextures(std::numeric_limits<float>::infinity());
+        }
+        batch.vbo->use();
+        if (batch.array != nullptr)
+            state.bindTexture(gfx::TEXTURE_ARRAY_UNIT, GL_TEXTURE_2D_ARRAY, batch.array->getHandle());
+        if (!batch.vbo->isInstanced())
+            batch.vbo->enableInstancing();
+        if (this->stream != nullptr)
+            batch.vbo->uploadInstances(*this->stream, batch.models, batch.layers);
+        else
+            batch.vbo->uploadInstances(batch.models, batch.layers);
+        this->gpu_culler->draw(*batch.vbo, batch.first, batch.instances.size());
+        ++draw_calls;
+    }
+    return draw_calls;
+}
+
+/**
+ * @brief Project the error of each level of detail at the distance from the camera to the object's bounds, and
+ *        keep the coarsest level that stays under `lod_pixel_error` (with hysteresis around the last level drawn).
+ *        Levels are measured in object units, so they are scaled by the object's largest scale factor.
+ */
+gfx::VBO *Scene::selectLOD(GameObject &object) const {
+    const auto &levels = object.lods->levels;
+    assert(!levels.empty());
+
+    auto bounds = object.world_bounds;
+    auto distance = bounds.bounded() ? std::sqrt(bounds.distanceSquared(this->camera->pos))
+                                     : glm::length(vec3(object.model[3]) - this->camera->pos);
+    // The scale factors are the lengths of the model matrix axes
+    auto scale = vec3(glm::length(vec3(object.model[0])), glm::length(vec3(object.model[1])),
+                      glm::length(vec3(object.model[2])));
+    auto pixels_per_unit =
+        this->lod_scale * std::max(scale.x, std::max(scale.y, scale.z)) / std::max(distance, CAMERA_NEAR_PLANE);
+    object.lod = object.lods->select(pixels_per_unit, this->lod_pixel_error, this->lod_hysteresis,
+                                     std::min(object.lod, levels.size() - 1));
+    return levels[object.lod].vbo.get();
+}
+
+/**
+ * @brief Test the world bounds of every object against the camera frustum in SIMD batches, before any GL calls
+ *        are made. Objects without bounds (or every object, when culling is disabled) are always visible.
+ */
+void Scene::cullObjects() const {
+    const auto &objects = this->drawnObjects();
+    if (this->culling && this->spatial_index) {
+        this->updateSpatialIndex();
+        this->visible_objects.clear();
+        for (size_t i = 0; i < objects.size(); i++) {
+            const auto &object = objects[i];
+            if (object != nullptr && !object->bounds.bounded())
+                this->visible_objects.push_back(static_cast<uint32_t>(i));
+        }
+
+        auto frustum = Frustum::fromMatrix(this->camera->getProjectionMatrix() * this->camera->view);
+        auto first = this->visible_objects.size();
+        this->bvh.queryFrustum(frustum, this->visible_objects);
+        auto found = this->visible_objects.size() - first;
+        for (auto i = first; i < this->visible_objects.size(); i++)
+            this->visible_objects[i] = this->bvh_objects[this->visible_objects[i]];
+        // The index covers every object, including the ones culled on the GPU or merged into static batches
+        if (this->gpu_culling || this->static_batching)
+            std::erase_if(this->visible_objects, [this, &objects](uint32_t index) {
+                const auto &object = *objects[index];
+                return this->drawnIndirect(object) || this->batchedStatic(object);
+            });
+
+        this->cull_stats = CullingStats{
+            .visible = this->visible_objects.size(),
+            .culled = this->bvh_objects.size() - found,
+        };
+        return;
+    }
+
+    this->culler.clear();
+    this->culler.reserve(objects.size());
+    this->cull_objects.clear();
+    this->visible_objects.clear();
+
+    for (size_t i = 0; i < objects.size(); i++) {
+        const auto &object = objects[i];
+        if (object == nullptr || this->drawnIndirect(*object) || this->batchedStatic(*object))
+            continue;
+
+        auto bounds = object->world_bounds;
+        if (!this->culling || !bounds.bounded()) {
+            this->visible_objects.push_back(static_cast<uint32_t>(i));
+            continue;
+        }
+        this->culler.add(bounds);
+        this->cull_objects.push_back(static_cast<uint32_t>(i));
+    }
+
+    auto frustum = Frustum::fromMatrix(this->camera->getProjectionMatrix() * this->camera->view);
+    auto first = this->visible_objects.size();
+    auto visible = this->culler.cull(frustum, this->visible_objects);
+    for (auto i = first; i < this->visible_objects.size(); i++)
+        this->visible_objects[i] = this->cull_objects[this->visible_objects[i]];
+
+    this->cull_stats = CullingStats{
+        .visible = this->visible_objects.size(),
+        .culled = this->cull_objects.size() - visible,
+    };
+}
+
+/**
+ * @brief Draw the occluders of the visible objects that cover the most of the screen into the occlusion buffer,
+ *        then drop every visible object hidden behind them, before any draw is queued for it.
+ */
+void Scene::occludeObjects() const {
+    const auto &objects = this->drawnObjects();
+    const auto &view = this->camera->view;
+    this->occlusion.begin(this->camera->getProjectionMatrix() * view);
+
+    // Rank the occluders by their approximate size on screen: bounding radius over view depth
+    this->occluders.clear();
+    for (auto index : this->visible_objects) {
+        const auto &object = objects[index];
+        if (object->occluder == nullptr || !object->bounds.bounded())
+            continue;
+        auto bounds = object->world_bounds;
+        auto depth = std::max(-(view * vec4(bounds.center(), 1.0f)).z, CAMERA_NEAR_PLANE);
+        this->occluders.emplace_back(glm::length(bounds.extents()) / depth, index);
+    }
+    auto count = std::min(this->occluders.size(), this->max_occluders);
+    std::partial_sort(this->occluders.begin(), this->occluders.begin() + count, this->occluders.end(),
+                      [](const auto &a, const auto &b) { return a.first > b.first; });
+    for (size_t i = 0; i < count; i++) {
+        const auto &object = objects[this->occluders[i].second];
+        this->occlusion.addOccluder(*object->occluder, object->model);
+    }
+    this->occlusion.rasterize();
+
+    auto hidden = std::remove_if(this->visible_objects.begin(), this->visible_objects.end(),
+                                 [this, &objects](uint32_t index) {
+                                     const auto &object = objects[index];
+                                     return object->bounds.bounded() && !this->occlusion.visible(object->world_bounds);
+                                 });
+    auto occluded = static_cast<size_t>(this->visible_objects.end() - hidden);
+    this->visible_objects.erase(hidden, this->visible_objects.end());
+
+    this->cull_stats.visible -= occluded;
+    this->cull_stats.culled += occluded;
+    this->cull_stats.occluded = occluded;
+#ifdef __DEBUG__
+    const auto &stats = this->occlusion.getStats();
+    LOG(DEBUG) << "Scene<" << this->name << ">::occludeObjects() " << stats.occluders << " occluders ("
+               << stats.triangles << " triangles in " << stats.binned << " tiles), " << occluded << " occluded";
+#endif
+}
+
+/**
+ * @brief Queue one draw per VBO of every visible object, keyed by pass, program, textures, VAO and view depth
+ */
+void Scene::queueDraws() const {
+    this->draw_items.clear();
+    this->queue.clear();
+    this->queue.reserve(this->visible_objects.size());
+
+    const auto &objects = this->drawnObjects();
+    const auto &view = this->camera->view;
+    for (auto index : this->visible_objects) {
+        const auto &object = objects[index];
+
+        auto context = object->render_context ? object->render_context.get() : this->render_context.get();
+        context->compile();
+
+        auto view_pos = view * object->model[3];
+        auto depth = (-view_pos.z - CAMERA_NEAR_PLANE) / (CAMERA_FAR_PLANE - CAMERA_NEAR_PLANE);
+        // The object's size on screen picks the mip levels its streamed textures need
+        auto extent = object->world_bounds.bounded() ? object->world_bounds.max - object->world_bounds.min : vec3(1.0f);
+        context->requestTextures(this->lod_scale * std::max(extent.x, std::max(extent.y, extent.z)) /
+                                 std::max(-view_pos.z, CAMERA_NEAR_PLANE));
+        // Objects in the same texture array share a material, whatever layer they use
+        auto material = context->getMaterialId();
+        if (object->texture.valid())
+            material = material * 31U + object->texture.array->getHandle();
+        if (object->lods) {
+            auto vbo = this->selectLOD(*object);
+            auto key = gfx::SortKey::make(object->pass, context->getProgram(), material, vbo->getSortId(), depth);
+            this->queue.push(key, static_cast<uint32_t>(this->draw_items.size()));
+            this->draw_items.push_back(DrawItem{.object = object.get(), .context = context, .vbo = vbo});
+            continue;
+        }
+        for (const auto &vbo : context->getVBOs()) {
+            auto key = gfx::SortKey::make(object->pass, context->getProgram(), material, vbo->getSortId(), depth);
+            this->queue.push(key, static_cast<uint32_t>(this->draw_items.size()));
+            this->draw_items.push_back(DrawItem{.object = object.get(), .context = context, .vbo = vbo.get()});
+        }
+    }
+}
+
+/**
+ * @brief Lay down the depth of the solid draws in the queue before shading them, nearest first so that farther
+ *        surfaces fail the depth test early. Per-object draws are ordered by depth alone; instanced draws are
+ *        grouped by VBO first (one draw per VBO), front to back within each group. Only positions are fetched
+ *        (through the depth VAO of VBOs split with `applySplitAttributeBounds`) and no color is written.
+ */
+size_t Scene::submitDepthPrepass() const {
+    using gfx::SortKey;
+    this->prepass_entries.clear();
+    for (const auto &entry : this->queue.getEntries()) {
+        // The solid pass sorts first
+        if (SortKey::pass(entry.key) != gfx::RenderPass::SOLID)
+            break;
+        uint64_t vao = this->draw_items[entry.item].vbo->getSortId() & ((1ULL << SortKey::VAO_BITS) - 1);
+        uint64_t depth = SortKey::depth(entry.key);
+        auto key = this->instanced ? (vao << SortKey::DEPTH_BITS) | depth : (depth << SortKey::VAO_BITS) | vao;
+        this->prepass_entries.push_back(gfx::SortEntry{.key = key, .item = entry.item});
+    }
+    if (this->prepass_entries.empty())
+        return 0UL;
+    gfx::radix_sort(this->prepass_entries, this->prepass_scratch);
+
+    size_t draw_calls = 0UL;
+    this->prepass->begin();
+    this->prepass->use(this->instanced);
+    const auto &entries = this->prepass_entries;
+    for (size_t i = 0; i < entries.size();) {
+        const auto &item = this->draw_items[entries[i].item];
+        item.vbo->useDepth();
+        if (this->instanced) {
+            this->instance_models.clear();
+            size_t end = i;
+            for (; end < entries.size() && this->draw_items[entries[end].item].vbo == item.vbo; end++)
+                this->instance_models.push_back(this->draw_items[entries[end].item].object->model);
+
+            if (!item.vbo->isInstanced())
+                item.vbo->enableInstancing();
+            if (this->stream != nullptr)
+                item.vbo->uploadInstances(*this->stream, this->instance_models);
+            else
+                item.vbo->uploadInstances(this->instance_models);
+            item.vbo->drawInstanced(this->instance_models.size());
+            i = end;
+        } else {
+            this->prepass->setModel(item.object->model);
+            item.vbo->draw();
+            i++;
+        }
+        ++draw_calls;
+    }
+    this->prepass->end();
+    return draw_calls;
+}
+
+/**
+ * @brief Record the sorted render queue into command buffers and replay them. Large queues are split into slices
+ *        recorded in parallel by the job system; each slice starts from the pass and context the slice before it
+ *        ends with, so the replayed commands are the same as when recording serially, except that instanced runs
+ *        crossing a slice boundary are drawn in two calls.
+ */
+size_t Scene::submitDraws(bool prepassed) const {
+    const auto &entries = this->queue.getEntries();
+    if (entries.empty())
+        return 0UL;
+
+    size_t slices = 1UL;
+    if (this->jobs != nullptr && entries.size() >= COMMAND_RECORD_GRAIN * 2)
+        slices = (entries.size() + COMMAND_RECORD_GRAIN - 1) / COMMAND_RECORD_GRAIN;
+    if (this->command_buffers.size() < slices)
+        this->command_buffers.resize(slices);
+    auto record = [this, &entries, slices, prepassed](size_t begin, size_t end) {
+        for (size_t slice = begin; slice < end; slice++) {
+            auto &buffer = this->command_buffers[slice];
+            buffer.clear();
+            this->recordDraws(buffer, entries.size() * slice / slices, entries.size() * (slice + 1) / slices,
+                              prepassed);
+        }
+    };
+    if (slices > 1)
+        this->jobs->parallelFor(slices, 1, record);
+    else
+        record(0, 1);
+
+    size_t draw_calls = 0UL;
+    for (size_t slice = 0; slice < slices; slice++)
+        draw_calls += gfx::replay(this->command_buffers[slice], this->stream);
+
+    if (gfx::SortKey::pass(entries.back().key) != gfx::RenderPass::SOLID) {
+        gfx::GLState::get().setEnabled(GL_BLEND, false);
+        glDepthMask(GL_TRUE);
+    }
+    return draw_calls;
+}
+
+/**
+ * @brief Walk a slice of the sorted queue, only switching programs/textures when the context changes. In instanced
+ *        mode, consecutive draws of the same VBO and texture array are merged into a single instanced draw, with
+ *        the model matrix and layer of each object stored in the command.
+ */
+void Scene::recordDraws(gfx::CommandBuffer &buffer, size_t begin, size_t end, bool prepassed) const {
+    const auto &entries = this->queue.getEntries();
+    // The state left by the entries before the slice (the start of the frame's solid pass for the first one)
+    const gfx::RenderContext *context = nullptr;
+    auto pass = gfx::RenderPass::SOLID;
+    if (begin > 0) {
+        context = this->draw_items[entries[begin - 1].item].context;
+        pass = gfx::SortKey::pass(entries[begin - 1].key);
+    }
+
+    for (size_t i = begin; i < end;) {
+        const auto &item = this->draw_items[entries[i].item];
+        auto item_pass = gfx::SortKey::pass(entries[i].key);
+        if (item_pass != pass) {
+            auto &command = buffer.push<gfx::cmd::SetPass>();
+            command.pass = item_pass;
+            command.prepassed = prepassed;
+            pass = item_pass;
+        }
+        if (item.context != context) {
+            context = item.context;
+            buffer.push<gfx::cmd::UseContext>().context = context;
+        }
+        buffer.push<gfx::cmd::UseVBO>().vbo = item.vbo;
+        const auto &texture = item.object->texture;
+        if (texture.valid()) {
+            auto &command = buffer.push<gfx::cmd::BindTexture>();
+            command.unit = gfx::TEXTURE_ARRAY_UNIT;
+            command.target = GL_TEXTURE_2D_ARRAY;
+            command.handle = texture.array->getHandle();
+        }
+
+        if (this->instanced) {
+            // Batch the run of draws sharing this VBO, context, pass and texture array
+            size_t run_end = i;
+            for (; run_end < end; run_end++) {
+                const auto &next = this->draw_items[entries[run_end].item];
+                if (next.vbo != item.vbo || next.context != context ||
+                    gfx::SortKey::pass(entries[run_end].key) != pass || next.object->texture.array != texture.array)
+                    break;
+            }
+
+            auto count = run_end - i;
+            auto payload = gfx::cmd::DrawInstanced::payload(count, texture.valid());
+            auto &command = buffer.push<gfx::cmd::DrawInstanced>(payload);
+            command.vbo = item.vbo;
+            command.count = static_cast<uint32_t>(count);
+            command.layers = texture.valid();
+            auto models = command.models();
+            auto layers = command.instanceLayers();
+            for (size_t j = 0; j < count; j++) {
+                const auto &next = *this->draw_items[entries[i + j].item].object;
+                models[j] = next.model;
+                if (layers != nullptr)
+                    layers[j] = next.texture.layer;
+            }
+            i = run_end;
+        } else {
+            auto &model = buffer.push<gfx::cmd::SetMatrix4>();
+            model.location = context->getModelUniform().location;
+            model.value = item.object->model;
+            if (context->getLayerUniform().valid()) {
+                auto &layer = buffer.push<gfx::cmd::SetUInt>();
+                layer.location = context->getLayerUniform().location;
+                layer.value = texture.layer;
+            }
+            buffer.push<gfx::cmd::Draw>().vbo = item.vbo;
+            i++;
+        }
+    }
+}
+
+void Scene::updateSpatialIndex() const {
+    this->bvh_bounds.clear();
+    this->bvh_scratch.clear();
+    const auto &objects = this->drawnObjects();
+    for (size_t i = 0; i < objects.size(); i++) {
+        const auto &object = objects[i];
+        if (object == nullptr || !object->bounds.bounded())
+            continue;
+        this->bvh_bounds.push_back(object->world_bounds);
+        this->bvh_scratch.push_back(static_cast<uint32_t>(i));
+    }
+
+    // A different set of objects invalidates the primitive order, so it needs a full build rather than a refit
+    if (this->bvh_scratch != this->bvh_objects) {
+        this->bvh_objects.swap(this->bvh_scratch);
+        this->bvh.build(this->bvh_bounds);
+    } else {
+        this->bvh.update(this->bvh_bounds);
+    }
+}
+
+std::vector<std::shared_ptr<GameObject>> Scene::overlapSphere(const vec3 &center, float radius) const {
+    std::vector<uint32_t> results;
+    this->bvh.querySphere(center, radius, results);
+
+    std::vector<std::shared_ptr<GameObject>> found;
+    found.reserve(results.size());
+    for (auto index : results)
+        found.push_back(this->drawnObjects()[this->bvh_objects[index]]);
+    return found;
+}
+
+std::vector<std::shared_ptr<GameObject>> Scene::overlapBox(const AABB &bounds) const {
+    std::vector<uint32_t> results;
+    this->bvh.queryAABB(bounds, results);
+
+    std::vector<std::shared_ptr<GameObject>> found;
+    found.reserve(results.size());
+    for (auto index : results)
+        found.push_back(this->drawnObjects()[this->bvh_objects[index]]);
+    return found;
+}
+
+std::shared_ptr<GameObject> Scene::raycast(const vec3 &origin, const vec3 &direction, float max_distance,
+                                           float *distance) const {
+    auto hit = this->bvh.raycast(origin, direction, max_distance);
+    if (!hit.hit())
+        return nullptr;
+    if (distance != nullptr)
+        *distance = hit.distance;
+    return this->drawnObjects()[this->bvh_objects[hit.index]];
 }
 
-}  // namespace goat::world
\ No newline at end of file
+}  // namespace goat::world
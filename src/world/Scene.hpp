@@ -1,22 +1,138 @@
 #pragma once
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "gfx/CommandBuffer.hpp"
+#include "gfx/CommandReplay.hpp"
+#include "gfx/DepthPrepass.hpp"
+#include "gfx/GPUCulling.hpp"
+#include "gfx/PassQuery.hpp"
 #include "gfx/RenderContext.hpp"
+#include "gfx/RenderQueue.hpp"
+#include "jobs/JobSystem.hpp"
+#include "world/BVH.hpp"
 #include "world/Camera.hpp"
+#include "world/Culling.hpp"
 #include "world/GameObject.hpp"
+#include "world/Occlusion.hpp"
+#include "world/SceneSnapshot.hpp"
+#include "world/StaticBatch.hpp"
 
 namespace goat::world {
 
+// The number of objects per job when transform updates are split across threads
+static constexpr size_t TRANSFORM_JOB_GRAIN = 1024UL;
+// The number of queued draws per command buffer when recording is split across threads
+static constexpr size_t COMMAND_RECORD_GRAIN = 4096UL;
+
+// A single VBO of an object, queued for drawing in the current frame
+struct DrawItem {
+    const GameObject *object;
+    gfx::RenderContext *context;
+    gfx::VBO *vbo;
+};
+
+// Solid objects sharing a VBO, context and texture array, culled on the GPU and drawn with one indirect call
+struct IndirectBatch {
+    gfx::RenderContext *context;
+    gfx::VBO *vbo;
+    const gfx::TextureArray *array;
+    // Per-instance attributes and culling data of every object in the batch (reused every frame)
+    std::vector<mat4> models{};
+    std::vector<uint> layers{};
+    std::vector<gfx::GPUInstance> instances{};
+    // The index of the batch's first draw command
+    size_t first = 0UL;
+};
+
 /**
  * @brief A scene contains a collection of objects that are rendered to the screen
  *        using a given camera and render context.
+ * @note When a render thread draws the scene from snapshots (see `capture`), the simulation thread owns `objects`,
+ *       and the render thread owns everything else: the camera (which must not be the simulated one), the per-frame
+ *       state below and the spatial queries. The render thread draws copies of the objects made by `capture`, so
+ *       objects may change in any way between captures; the spatial queries also see the copies.
  */
 struct Scene {
     const std::shared_ptr<gfx::RenderContext> render_context;
     const std::shared_ptr<world::Camera> camera;
     std::vector<std::shared_ptr<GameObject>> objects{};
     std::string name = "Scene";
+    // Draw all objects with one instanced call per VBO instead of one draw per object
+    bool instanced = false;
+    // Skip objects whose bounds are outside of the camera frustum
+    bool culling = true;
+    // Cull through the BVH (refitted every frame) instead of testing every object's bounds
+    bool spatial_index = false;
+    // Skip objects hidden behind the occluders of the objects in front of them (after frustum culling)
+    bool occlusion_culling = false;
+    // The most occluders drawn into the occlusion buffer each frame, picked by their size on screen
+    size_t max_occluders = DEFAULT_MAX_OCCLUDERS;
+    // Cull and draw solid objects on the GPU with a compute shader and multi-draw-indirect (OpenGL 4.3+, ignored on
+    // older contexts). The shaders must read the model matrix from the per-instance attribute (`instanced.vert`)
+    bool gpu_culling = false;
+    // Merge solid STATIC objects that have a mesh into one VBO per render context and texture, drawn in culled
+    // chunks of `static_chunk_size` world units. Batched objects must not move or change once merged
+    bool static_batching = false;
+    float static_chunk_size = DEFAULT_STATIC_CHUNK_SIZE;
+    // Draw the solid objects into the depth buffer first, front to back with a position-only program, then shade
+    // them without writing depth, so each visible pixel runs the full fragment shader once. The shading pass tests
+    // depth with GL_EQUAL, or GL_LEQUAL when `depth_prepass_equal` is false (for shaders without invariant
+    // positions). Static batches and GPU-culled draws are not prepassed: they are drawn in between, as usual
+    bool depth_prepass = false;
+    bool depth_prepass_equal = true;
+    // The largest error, in pixels, allowed on screen when picking the level of detail of objects with `lods`
+    float lod_pixel_error = DEFAULT_LOD_PIXEL_ERROR;
+    // How far past the error threshold (as a fraction of it) objects go before switching levels
+    float lod_hysteresis = DEFAULT_LOD_HYSTERESIS;
+    // Splits per-object work (transform updates and draw recording) across the threads of a job system when set
+    jobs::JobSystem *jobs = nullptr;
+    // The objects of the last capture, and the copies of them shared with the snapshots captured since any of them
+    // was added, removed or changed how it is drawn (simulation side)
+    mutable ObjectList captured_sources{};
+    mutable std::shared_ptr<const ObjectList> captured_objects{};
+    // The object list of the snapshot drawn last, when rendering from snapshots (render side)
+    mutable std::shared_ptr<const ObjectList> frame_objects{};
+    // Ring buffer the instance data is streamed through when set (owned by the window, see `enableStreaming`)
+    gfx::StreamBuffer *stream = nullptr;
+    // Per-frame scratch storage for instance model matrices (reused to avoid reallocating every frame)
+    mutable std::vector<mat4> instance_models{};
+    // Per-frame draw list and the sort keys ordering it (reused to avoid reallocating every frame)
+    mutable std::vector<DrawItem> draw_items{};
+    mutable gfx::RenderQueue queue{};
+    // The command buffers the sorted draws are recorded into, one per slice of the queue (reused every frame)
+    mutable std::vector<gfx::CommandBuffer> command_buffers{};
+    // Per-frame culling state: the bounds being tested, the object index of each of them, and the objects to draw
+    mutable FrustumCuller culler{};
+    mutable std::vector<uint32_t> cull_objects{};
+    mutable std::vector<uint32_t> visible_objects{};
+    mutable CullingStats cull_stats{};
+    // Spatial index over the bounded objects: their world bounds and the object index of each of them
+    mutable BVH bvh{};
+    mutable std::vector<AABB> bvh_bounds{};
+    mutable std::vector<uint32_t> bvh_objects{};
+    mutable std::vector<uint32_t> bvh_scratch{};
+    // Software depth buffer for occlusion culling, and the occluders picked for it this frame (size, object index)
+    mutable OcclusionBuffer occlusion{};
+    mutable std::vector<std::pair<float, uint32_t>> occluders{};
+    // GPU culling state (created by the first frame drawn with `gpu_culling`), and the batches drawn through it
+    mutable std::unique_ptr<gfx::GPUCuller> gpu_culler{};
+    mutable std::vector<IndirectBatch> indirect_batches{};
+    mutable std::vector<gfx::GPUInstance> indirect_instances{};
+    // Static batches, the index of every object merged into them, and the static objects found this frame
+    mutable std::vector<StaticBatch> static_batches{};
+    mutable std::vector<uint32_t> static_objects{};
+    mutable std::vector<uint32_t> static_scratch{};
+    // Depth prepass programs (created by the first frame drawn with `depth_prepass`), the prepass draw order, and
+    // the GPU measurements of the prepass and of everything shaded after it
+    mutable std::unique_ptr<gfx::DepthPrepass> prepass{};
+    mutable std::vector<gfx::SortEntry> prepass_entries{};
+    mutable std::vector<gfx::SortEntry> prepass_scratch{};
+    mutable gfx::PassQuery prepass_query{};
+    mutable gfx::PassQuery shading_query{};
+    // Pixels covered by one world unit at a distance of 1 this frame (the projection scale over half the viewport)
+    mutable float lod_scale = 0.0f;
 
     static Scene *create(
         const std::string &name, std::shared_ptr<world::Camera> camera,
@@ -25,6 +141,70 @@ struct Scene {
 
     void use() const;
     void render() const;
+    // Draw a snapshot captured by `capture`, from the thread owning the GL context
+    void render(const SceneSnapshot &snapshot) const;
+
+    /**
+     * @brief Fill a snapshot with the model matrix and world bounds of every object, from the simulation thread.
+     *        This is what `render` does with `updateTransforms`, without writing to the objects being drawn: the
+     *        snapshot refers to copies of the objects, made again for the objects whose draw state changed.
+     */
+    void capture(SceneSnapshot &snapshot) const;
+
+    // Recompute the model matrix and world bounds of every object (`render` does this at the start of every frame)
+    void updateTransforms() const;
+
+    /**
+     * @brief Refit the spatial index to the object bounds of the last `updateTransforms` (rebuilding it when objects
+     *        were added or removed, or when it degraded too much). `render` does this every frame when
+     *        `spatial_index` is set; call both before querying if objects moved since.
+     */
+    void updateSpatialIndex() const;
+
+    /**
+     * @brief Merge the static objects into batches, rebuilding them whenever static objects were added or removed.
+     *        `render` does this every frame; call it after loading a scene to avoid merging during its first frame.
+     */
+    void updateStaticBatches() const;
+
+    // Return every object whose bounds overlap a sphere
+    std::vector<std::shared_ptr<GameObject>> overlapSphere(const vec3 &center, float radius) const;
+    // Return every object whose bounds overlap a box
+    std::vector<std::shared_ptr<GameObject>> overlapBox(const AABB &bounds) const;
+    // Return the first object whose bounds are hit by a ray (nullptr if none), and the distance to it
+    std::shared_ptr<GameObject> raycast(const vec3 &origin, const vec3 &direction, float max_distance,
+                                        float *distance = nullptr) const;
+
+   private:
+    // The objects being drawn: those of the snapshot drawn last, or `objects` when rendering without snapshots
+    const ObjectList &drawnObjects() const;
+    // Run `fn` over every object index in chunks, split across the job system's threads when the scene is large
+    void splitObjects(const std::function<void(size_t, size_t)> &fn) const;
+    // Cull, sort and draw the objects from their cached transforms
+    void draw() const;
+    // Returns true if the object is culled and drawn on the GPU rather than by `cullObjects` and `submitDraws`
+    bool drawnIndirect(const GameObject &object) const;
+    // Returns true if the object is merged into a static batch rather than drawn on its own
+    bool batchedStatic(const GameObject &object) const;
+    // Cull the chunks of every static batch and draw the visible ones, returning the number of draw calls issued
+    size_t submitStatic() const;
+    // Cull and draw every object drawn indirectly, returning the number of draw calls issued
+    size_t submitIndirect() const;
+    // Pick the level of detail of an object from its distance to the camera, returning the VBO to draw
+    gfx::VBO *selectLOD(GameObject &object) const;
+    // Find the objects inside the camera frustum
+    void cullObjects() const;
+    // Rasterize the largest occluders on screen and remove the visible objects they hide
+    void occludeObjects() const;
+    // Fill the render queue with every VBO of every visible object
+    void queueDraws() const;
+    // Draw the solid draws of the sorted render queue into the depth buffer, returning the number of draw calls
+    size_t submitDepthPrepass() const;
+    // Draw the sorted render queue (shading what `submitDepthPrepass` laid down when `prepassed`), returning the
+    // number of draw calls issued
+    size_t submitDraws(bool prepassed = false) const;
+    // Record the draws of the queue entries [begin, end) into a command buffer (thread-safe, no GL calls)
+    void recordDraws(gfx::CommandBuffer &buffer, size_t begin, size_t end, bool prepassed) const;
 };
 
 }  // namespace goat::world
\ No newline at end of file
@@ -0,0 +1,83 @@
+#include "SceneSnapshot.hpp"
+
+#include <chrono>
+
+namespace goat::world {
+
+namespace {
+
+double elapsed_us(std::chrono::steady_clock::time_point start) {
+    auto duration = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+}  // namespace
+
+SceneSnapshot &SnapshotBuffer::write() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    assert(this->writing == -1);
+    // Never the published slot, so the render thread always has the latest snapshot to draw
+    auto slot = this->published == 0 ? 1 : 0;
+    if (this->drawing == slot && !this->stopped) {
+        auto start = std::chrono::steady_clock::now();
+        this->changed.wait(lock, [this, slot]() { return this->drawing != slot || this->stopped; });
+        this->stats.simulation_wait_us += elapsed_us(start);
+    }
+    this->writing = slot;
+    return this->snapshots[slot];
+}
+
+void SnapshotBuffer::publish() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        assert(this->writing != -1);
+        this->published = this->writing;
+        this->writing = -1;
+        this->fresh = true;
+    }
+    this->changed.notify_all();
+}
+
+const SceneSnapshot *SnapshotBuffer::acquire() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    assert(this->drawing == -1);
+    if (!this->fresh && !this->stopped) {
+        auto start = std::chrono::steady_clock::now();
+        this->changed.wait(lock, [this]() { return this->fresh || this->stopped; });
+        this->stats.render_wait_us += elapsed_us(start);
+    }
+    if (this->stopped)
+        return nullptr;
+    this->drawing = this->published;
+    this->fresh = false;
+    this->stats.frames++;
+    return &this->snapshots[this->drawing];
+}
+
+void SnapshotBuffer::release() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->drawing = -1;
+    }
+    this->changed.notify_all();
+}
+
+void SnapshotBuffer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopped = true;
+    }
+    this->changed.notify_all();
+}
+
+SnapshotStats SnapshotBuffer::getStats() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->stats;
+}
+
+void SnapshotBuffer::resetStats() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->stats = {};
+}
+
+}  // namespace goat::world
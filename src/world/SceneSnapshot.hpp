@@ -0,0 +1,80 @@
+#pragma once
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "world/Bounds.hpp"
+#include "world/Camera.hpp"
+#include "world/GameObject.hpp"
+
+namespace goat::world {
+
+// The objects of a scene, shared by every snapshot captured until the scene's object list changes
+typedef std::vector<std::shared_ptr<GameObject>> ObjectList;
+
+/**
+ * @brief Everything the render thread reads to draw one frame, captured by the simulation thread (see
+ *        `Scene::capture`): the camera, copies of the objects and their model matrices and world bounds. A snapshot
+ *        is not changed once published, so the simulation can move on to the next frame while it is drawn. The
+ *        copies belong to the render thread, which writes their per-frame state (transforms, level of detail).
+ */
+struct SceneSnapshot {
+    // The simulation frame the snapshot was captured in, with its time and delta time in seconds
+    uint64_t frame = 0UL;
+    float time = 0.0f;
+    float delta_time = 0.0f;
+    // The framebuffer size when the snapshot was captured
+    uint width = 0U;
+    uint height = 0U;
+    // A copy of the simulated camera
+    Camera camera{vec3(0.0f, 0.0f, 0.0f)};
+    // Copies of the scene's objects as they were to be drawn, shared by the snapshots until one of them changes
+    std::shared_ptr<const ObjectList> objects{};
+    // The model matrix and world bounds of each object, in the order of `objects`
+    std::vector<mat4> models{};
+    std::vector<AABB> bounds{};
+};
+
+struct SnapshotStats {
+    size_t frames = 0UL;
+    // Time the simulation waited for a snapshot to be drawn, and the render thread waited for one to be captured
+    double simulation_wait_us = 0.0;
+    double render_wait_us = 0.0;
+};
+
+/**
+ * @brief Two snapshots handed from the simulation thread to the render thread: the simulation fills one while the
+ *        other is drawn, and only waits when it gets a whole frame ahead. A snapshot is never drawn twice, so the
+ *        render thread waits for the simulation too, and a frame takes as long as the slower of the two.
+ */
+class SnapshotBuffer {
+    SceneSnapshot snapshots[2];
+    std::mutex mutex;
+    std::condition_variable changed;
+    // The slot being filled, the slot last published and the slot being drawn (-1 for none)
+    int writing = -1;
+    int published = -1;
+    int drawing = -1;
+    // Whether the published snapshot was not drawn yet
+    bool fresh = false;
+    bool stopped = false;
+    SnapshotStats stats{};
+
+   public:
+    // Return the snapshot to fill for the next frame, waiting until the render thread is done drawing it
+    SceneSnapshot &write();
+    // Hand the snapshot returned by `write` to the render thread
+    void publish();
+    // Return the latest snapshot, waiting until one is published that was not drawn yet (nullptr once stopped)
+    const SceneSnapshot *acquire();
+    // Let the simulation fill the snapshot returned by `acquire` again
+    void release();
+    // Make the render thread's current and later `acquire` calls return nullptr
+    void stop();
+
+    SnapshotStats getStats();
+    void resetStats();
+};
+
+}  // namespace goat::world
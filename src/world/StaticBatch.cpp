@@ -0,0 +1,81 @@
+#include "StaticBatch.hpp"
+
+#include <easylogging++.h>
+
+#include <array>
+#include <cmath>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+#include "world/GameObject.hpp"
+
+namespace goat::world {
+
+StaticGeometry StaticGeometry::merge(const std::vector<const GameObject *> &objects, float chunk_size) {
+    StaticGeometry geometry{};
+    if (objects.empty())
+        return geometry;
+    auto vertex_size = objects.front()->mesh->vertex_size;
+    geometry.mesh.vertex_size = vertex_size;
+
+    // Cells are ordered by (x, y, z), so each chunk is followed by one of its neighbours in the index buffer
+    std::map<std::array<int, 3>, std::vector<const GameObject *>> cells;
+    size_t vertex_count = 0, index_count = 0;
+    for (const auto *object : objects) {
+        if (object->mesh->vertex_size != vertex_size)
+            throw std::runtime_error("Static objects merged together must have the same vertex size");
+        auto position = object->getWorldPosition() / chunk_size;
+        cells[{static_cast<int>(std::floor(position.x)), static_cast<int>(std::floor(position.y)),
+               static_cast<int>(std::floor(position.z))}]
+            .push_back(object);
+        vertex_count += object->mesh->vertexCount();
+        index_count += object->mesh->indices.size();
+    }
+    geometry.mesh.vertices.reserve(vertex_count * vertex_size);
+    geometry.mesh.indices.reserve(index_count);
+    geometry.chunks.reserve(cells.size());
+
+    for (const auto &[cell, cell_objects] : cells) {
+        StaticChunk chunk{.first_index = geometry.mesh.indices.size(), .objects = cell_objects.size()};
+        for (const auto *object : cell_objects) {
+            const auto &source = *object->mesh;
+            auto model = object->getModelMatrix();
+            auto base = static_cast<uint>(geometry.mesh.vertexCount());
+            for (size_t v = 0; v < source.vertexCount(); v++) {
+                const auto *vertex = source.vertex(v);
+                auto position = vec3(model * vec4(vertex[0], vertex[1], vertex[2], 1.0f));
+                chunk.bounds.expand(position);
+                geometry.mesh.vertices.insert(geometry.mesh.vertices.end(), {position.x, position.y, position.z});
+                geometry.mesh.vertices.insert(geometry.mesh.vertices.end(), vertex + 3, vertex + vertex_size);
+            }
+            for (auto index : source.indices)
+                geometry.mesh.indices.push_back(base + index);
+        }
+        chunk.index_count = geometry.mesh.indices.size() - chunk.first_index;
+        geometry.chunks.push_back(chunk);
+    }
+
+    LOG(INFO) << "[static] merged " << objects.size() << " objects into " << geometry.chunks.size() << " chunks ("
+              << geometry.mesh.vertexCount() << " vertices, " << geometry.mesh.indices.size() << " indices)";
+    return geometry;
+}
+
+std::shared_ptr<gfx::VBO> StaticBatch::upload(const mesh::Mesh &mesh, const gfx::VBO &source) {
+    size_t entries = 0;
+    for (const auto &bound : source.getAttributeBounds())
+        entries += bound.entries;
+    if (entries != mesh.vertex_size)
+        throw std::runtime_error("Static batch vertices have " + std::to_string(mesh.vertex_size) +
+                                 " floats, but the VBO they are drawn with has " + std::to_string(entries) +
+                                 " attribute entries");
+
+    auto vbo = std::make_shared<gfx::VBO>(gfx::BufferType::ARRAY, gfx::DrawType::STATIC, gfx::DataType::FLOAT,
+                                          mesh.indices);
+    for (const auto &bound : source.getAttributeBounds())
+        vbo->addAttributeBound(bound.index, bound.entries);
+    vbo->applyAttributeBounds(mesh.vertices);
+    return vbo;
+}
+
+}  // namespace goat::world
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "gfx/RenderContext.hpp"
+#include "gfx/TextureArray.hpp"
+#include "gfx/VBO.hpp"
+#include "mesh/Mesh.hpp"
+#include "world/Bounds.hpp"
+
+namespace goat::world {
+
+struct GameObject;
+
+// The size of the grid cells static objects are grouped into (in world units), each one becoming a culled chunk
+static constexpr float DEFAULT_STATIC_CHUNK_SIZE = 16.0f;
+
+// A range of a static batch's indices drawing the objects of one grid cell
+struct StaticChunk {
+    // The world bounds of every vertex in the chunk
+    AABB bounds = AABB::empty();
+    size_t first_index = 0UL;
+    size_t index_count = 0UL;
+    size_t objects = 0UL;
+};
+
+/**
+ * @brief The world-space geometry of static objects merged into a single mesh, split into chunks by a uniform grid
+ *        over the objects' positions. Chunks are laid out in grid order, so neighbouring chunks that are visible
+ *        together can be drawn as one range.
+ */
+struct StaticGeometry {
+    mesh::Mesh mesh{};
+    std::vector<StaticChunk> chunks{};
+
+    /**
+     * @brief Pre-transform the mesh of every object by its model matrix and append it to the merged mesh. Only
+     *        the position (the first 3 floats of each vertex) is transformed, other attributes are copied as is.
+     *        Every object must have a mesh with the same vertex size.
+     */
+    static StaticGeometry merge(const std::vector<const GameObject *> &objects,
+                                float chunk_size = DEFAULT_STATIC_CHUNK_SIZE);
+};
+
+// Static objects sharing a render context and texture, merged into one VBO
+struct StaticBatch {
+    gfx::RenderContext *context;
+    const gfx::TextureArray *array;
+    uint layer;
+    std::shared_ptr<gfx::VBO> vbo{};
+    std::vector<StaticChunk> chunks{};
+
+    /**
+     * @brief Upload merged geometry into a new float VBO with the attributes of the VBO the objects are drawn with:
+     *        the same indices and entries in the same order, each stored as floats (the mesh holds them unpacked).
+     *        Throws if the mesh's vertex size does not match those attributes.
+     */
+    static std::shared_ptr<gfx::VBO> upload(const mesh::Mesh &mesh, const gfx::VBO &source);
+};
+
+}  // namespace goat::world